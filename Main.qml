@@ -31,6 +31,7 @@ Window {
 	onDashboardClicked: rightScreen.showMap() // Map button now only restores map
 	onPhoneClicked: rightScreen.showPhone()
 	onParkAssistClicked: leftScreen.showParkAssist()
+	onSettingsClicked: rightScreen.showDiagnostics()
     }
 
     // Focus for key handling
@@ -0,0 +1,27 @@
+// Shared entry point: the controllers need a QCoreApplication for their
+// timers, threads and queued connections.
+//
+// JSON for regression tracking:
+//   VehicleSysBenchmarks --benchmark_out=results.json --benchmark_out_format=json
+
+#include <benchmark/benchmark.h>
+#include <QCoreApplication>
+#include <QLoggingCategory>
+
+int main(int argc, char *argv[])
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    QCoreApplication app(argc, argv);
+
+    // Controllers built here decode with the DBC the generated decoders came from
+    qputenv("VEHICLESYS_DBC", VEHICLESYS_BENCHMARK_DBC);
+    // Per-run status chatter would end up inside the measurements
+    QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
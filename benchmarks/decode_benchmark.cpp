@@ -0,0 +1,149 @@
+// Decode cost of Engine_Data (0x100): the original hand-written switch
+// branch against the dbc2cpp-generated decoders and the runtime table.
+//
+// Requires 0x100 in the generated set (the default generates every message).
+
+#include <benchmark/benchmark.h>
+#include <QByteArray>
+#include <QVector>
+#include <cstring>
+
+#include "candecodetable.h"
+#include "dbcdatabase.h"
+#include "vehiclesignals_generated.h"
+
+namespace {
+
+constexpr int FrameCount = 256;
+
+// Simulator-like Engine_Data frames with varying rpm, temperature and fuel
+QVector<QByteArray> engineFrames()
+{
+    QVector<QByteArray> frames;
+    frames.reserve(FrameCount);
+    for (int i = 0; i < FrameCount; ++i) {
+        const int rawRpm = (800 + i * 23) * 4;
+        QByteArray data(8, 0);
+        data[0] = static_cast<char>(rawRpm & 0xFF);
+        data[1] = static_cast<char>((rawRpm >> 8) & 0xFF);
+        data[2] = static_cast<char>(i % 100);
+        data[3] = static_cast<char>(60 + i % 70);
+        data[7] = static_cast<char>(255 - i);
+        frames.append(data);
+    }
+    return frames;
+}
+
+struct EngineValues
+{
+    int rpm;
+    int temp;
+    int fuelLevel;
+};
+
+// The 0x100 branch of the former hand-written processCanFrame switch
+EngineValues handWrittenEngineData(const QByteArray &data)
+{
+    EngineValues values{0, 0, 0};
+    if (data.size() >= 8) {
+        values.rpm = (static_cast<quint8>(data[0]) | (static_cast<quint8>(data[1]) << 8)) * 0.25;
+        if (data.size() >= 4) {
+            values.temp = static_cast<quint8>(data[3]) - 40;
+        }
+        if (data.size() >= 8) {
+            values.fuelLevel = static_cast<quint8>(data[7]) * 0.392157;
+        }
+    }
+    return values;
+}
+
+void BM_HandWritten_EngineData(benchmark::State &state)
+{
+    const QVector<QByteArray> frames = engineFrames();
+    int next = 0;
+    for (auto _ : state) {
+        const EngineValues values = handWrittenEngineData(frames[next]);
+        benchmark::DoNotOptimize(values);
+        next = (next + 1) % FrameCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HandWritten_EngineData);
+
+// Same three signals through the generated per-signal accessors
+void BM_Generated_EngineData(benchmark::State &state)
+{
+    using Engine = GeneratedCan::Message<0x100u>;
+    const QVector<QByteArray> frames = engineFrames();
+    int next = 0;
+    for (auto _ : state) {
+        const QByteArray &data = frames[next];
+        const quint8 *payload = reinterpret_cast<const quint8 *>(data.constData());
+        EngineValues values{0, 0, 0};
+        if (data.size() >= Engine::length) {
+            values.rpm = static_cast<int>(Engine::decodeEngineSpeed(payload));
+            values.temp = static_cast<int>(Engine::decodeEngineCoolantTemp(payload));
+            values.fuelLevel = static_cast<int>(Engine::decodeFuelLevel(payload));
+        }
+        benchmark::DoNotOptimize(values);
+        next = (next + 1) % FrameCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Generated_EngineData);
+
+// ID lookup plus every Engine_Data signal, as the controller dispatches it
+void BM_GeneratedDispatch_EngineData(benchmark::State &state)
+{
+    const QVector<QByteArray> frames = engineFrames();
+    double values[GeneratedCan::maxSignalsPerMessage];
+    quint32 frameId = 0x100;
+    int next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(frameId);
+        const QByteArray &data = frames[next];
+        if (const GeneratedCan::DecoderEntry *decoder = GeneratedCan::findDecoder(frameId, false)) {
+            const quint8 *payload = reinterpret_cast<const quint8 *>(data.constData());
+            const quint64 present = decoder->decode(payload, data.size(), values);
+            benchmark::DoNotOptimize(present);
+            benchmark::DoNotOptimize(values);
+        }
+        next = (next + 1) % FrameCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GeneratedDispatch_EngineData);
+
+// Runtime CanDecodeTable compiled from the same DBC
+void BM_DecodeTable_EngineData(benchmark::State &state)
+{
+    DbcDatabase database;
+    if (!database.load(QStringLiteral(VEHICLESYS_BENCHMARK_DBC))) {
+        state.SkipWithError("cannot load DBC");
+        return;
+    }
+    CanDecodeTable table;
+    table.compile(database);
+
+    const QVector<QByteArray> frames = engineFrames();
+    quint8 payload[CanDecodeTable::MaxPayload + CanDecodeTable::PayloadPadding] = {};
+    double values[64];
+    quint32 frameId = 0x100;
+    int next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(frameId);
+        const QByteArray &data = frames[next];
+        if (const CanDecodeTable::Message *message = table.find(frameId, false)) {
+            std::memcpy(payload, data.constData(), data.size());
+            table.decode(*message, payload, data.size(), [&values, message](int signalIndex, double value) {
+                values[signalIndex - message->firstSignal] = value;
+            });
+            benchmark::DoNotOptimize(values);
+        }
+        next = (next + 1) % FrameCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeTable_EngineData);
+
+} // namespace
@@ -0,0 +1,301 @@
+// Cost of getting a CAN frame onto a QML-visible property:
+//   - VehicleDataController::processCanFrame per message ID of the DBC,
+//     with payloads that change every frame and with a repeated payload
+//     (which the payload change cache skips), and with no subscriber for
+//     the message
+//   - NOTIFY fan-out with 0, 1 and N receivers per property, published per
+//     change and coalesced once per rendered frame
+//   - CanBusController end to end: ring, drain, decode and notify, fed by
+//     a recorded log replayed as fast as it is consumed
+//
+// Per-frame benchmarks run one frame per iteration, so their time column
+// is ns/frame and items_per_second is frames/s.
+
+#include <benchmark/benchmark.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QVector>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "canbuscontroller.h"
+#include "canlogwriter.h"
+#include "dbcdatabase.h"
+#include "vehicledatacontroller.h"
+
+namespace {
+
+constexpr int FrameCount = 256;
+constexpr int ReplayFrameCount = 100000;
+
+const DbcDatabase &benchmarkDatabase()
+{
+    static DbcDatabase database;
+    static bool loaded = database.load(QStringLiteral(VEHICLESYS_BENCHMARK_DBC));
+    Q_UNUSED(loaded)
+    return database;
+}
+
+// Frames of one message; random payloads, or the same payload every time
+QVector<CanFrame> messageFrames(const DbcMessage &message, bool changing)
+{
+    std::mt19937 random(message.id);
+    QVector<CanFrame> frames;
+    frames.reserve(FrameCount);
+    CanFrame frame = CanFrame::create(message.id, static_cast<quint8>(message.length),
+                                      message.extended ? CanFrame::ExtendedId : 0);
+    for (int i = 0; i < FrameCount; ++i) {
+        if (changing || i == 0) {
+            for (int byte = 0; byte < frame.length; ++byte) {
+                frame.data[byte] = static_cast<quint8>(random());
+            }
+        }
+        frames.append(frame);
+    }
+    return frames;
+}
+
+// Engine_Data frames whose rpm, coolant temperature and fuel level all move every frame
+QVector<CanFrame> engineFrames()
+{
+    QVector<CanFrame> frames;
+    frames.reserve(FrameCount);
+    for (int i = 0; i < FrameCount; ++i) {
+        CanFrame frame = CanFrame::create(0x100, 8);
+        const int rawRpm = (800 + i * 23) * 4;
+        frame.data[0] = static_cast<quint8>(rawRpm & 0xFF);
+        frame.data[1] = static_cast<quint8>((rawRpm >> 8) & 0xFF);
+        frame.data[3] = static_cast<quint8>(60 + i % 70);
+        frame.data[7] = static_cast<quint8>(255 - i);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+// Every signal of the DBC, as if every screen were visible
+void subscribeAll(VehicleDataController &controller)
+{
+    const SignalRegistry &registry = controller.signalRegistry();
+    for (int id = 0; id < registry.count(); ++id) {
+        controller.subscribe(registry.info(id).message + QLatin1Char('.') + registry.info(id).name);
+    }
+}
+
+// Extended IDs carry CanFrame::ExtendedIdFlag
+int64_t messageKey(const DbcMessage &message)
+{
+    return message.extended ? (message.id | CanFrame::ExtendedIdFlag) : message.id;
+}
+
+const DbcMessage *messageForKey(int64_t key)
+{
+    const quint32 id = static_cast<quint32>(key);
+    return benchmarkDatabase().message(id & ~CanFrame::ExtendedIdFlag, (id & CanFrame::ExtendedIdFlag) != 0);
+}
+
+void messageIdArguments(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgNames({ "id", "changing" });
+    for (const DbcMessage &message : benchmarkDatabase().messages()) {
+        benchmark->Args({ messageKey(message), 1 });
+        benchmark->Args({ messageKey(message), 0 });
+    }
+}
+
+void BM_ProcessCanFrame(benchmark::State &state)
+{
+    const DbcMessage *message = messageForKey(state.range(0));
+    if (!message) {
+        state.SkipWithError("message not in DBC");
+        return;
+    }
+
+    VehicleDataController controller;
+    subscribeAll(controller);
+    const QVector<CanFrame> frames = messageFrames(*message, state.range(1) != 0);
+    int next = 0;
+    for (auto _ : state) {
+        controller.processCanFrame(frames[next]);
+        next = (next + 1) % FrameCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(message->name.toStdString());
+
+    // Share of frames and signals the payload change cache let through undecoded
+    const PayloadChangeCache &cache = controller.payloadCache();
+    for (int m = 0; m < cache.messageCount(); ++m) {
+        if (cache.frameId(m) == message->id) {
+            const PayloadChangeCache::Stats &stats = cache.stats(m);
+            state.counters["unchanged_frames"] = stats.frames
+                    ? static_cast<double>(stats.unchanged) / static_cast<double>(stats.frames) : 0.0;
+            state.counters["skipped_signals"] = static_cast<double>(stats.signalsSkipped)
+                    / static_cast<double>(qMax<quint64>(1, stats.signalsDecoded + stats.signalsSkipped));
+        }
+    }
+}
+BENCHMARK(BM_ProcessCanFrame)->Apply(messageIdArguments);
+
+// The same frames with nothing subscribed: the cost of a hidden screen
+void BM_ProcessCanFrame_Unwatched(benchmark::State &state)
+{
+    const DbcMessage *message = messageForKey(state.range(0));
+    if (!message) {
+        state.SkipWithError("message not in DBC");
+        return;
+    }
+
+    VehicleDataController controller;
+    controller.unsubscribe(QStringLiteral("VehicleSpeed")); // Held for the odometer
+    const QVector<CanFrame> frames = messageFrames(*message, true);
+    int next = 0;
+    for (auto _ : state) {
+        controller.processCanFrame(frames[next]);
+        next = (next + 1) % FrameCount;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(message->name.toStdString());
+}
+BENCHMARK(BM_ProcessCanFrame_Unwatched)->Apply([](benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgName("id");
+    for (const DbcMessage &message : benchmarkDatabase().messages()) {
+        benchmark->Arg(messageKey(message));
+    }
+});
+
+// Receivers on each Engine_Data property, one connection apiece as a QML
+// binding holds
+void connectReceivers(VehicleDataController &controller, int count,
+                      std::vector<std::unique_ptr<QObject>> &receivers, quint64 &notifications)
+{
+    for (int i = 0; i < count; ++i) {
+        receivers.emplace_back(new QObject);
+        QObject *receiver = receivers.back().get();
+        QObject::connect(&controller, &VehicleDataController::rpmChanged, receiver,
+                         [&notifications](int) { ++notifications; });
+        QObject::connect(&controller, &VehicleDataController::engineTemperatureChanged, receiver,
+                         [&notifications](int) { ++notifications; });
+        QObject::connect(&controller, &VehicleDataController::fuelLevelChanged, receiver,
+                         [&notifications](int) { ++notifications; });
+    }
+}
+
+// range(0) receivers per property, NOTIFY on every change
+void BM_NotifyFanout(benchmark::State &state)
+{
+    VehicleDataController controller;
+    subscribeAll(controller);
+    std::vector<std::unique_ptr<QObject>> receivers;
+    quint64 notifications = 0;
+    connectReceivers(controller, static_cast<int>(state.range(0)), receivers, notifications);
+
+    const QVector<CanFrame> frames = engineFrames();
+    int next = 0;
+    for (auto _ : state) {
+        controller.processCanFrame(frames[next]);
+        next = (next + 1) % FrameCount;
+    }
+    benchmark::DoNotOptimize(notifications);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["notifications_per_frame"] = benchmark::Counter(
+                static_cast<double>(notifications), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_NotifyFanout)->ArgName("receivers")->Arg(0)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// The same fan-out in FramePublish mode: a 1 kHz message seen by a 60 Hz
+// display gets about 16 frames per publish
+void BM_NotifyFanout_FramePublish(benchmark::State &state)
+{
+    constexpr int FramesPerPublish = 16;
+
+    VehicleDataController controller;
+    controller.setPublishMode(VehicleDataController::FramePublish);
+    subscribeAll(controller);
+    std::vector<std::unique_ptr<QObject>> receivers;
+    quint64 notifications = 0;
+    connectReceivers(controller, static_cast<int>(state.range(0)), receivers, notifications);
+
+    const QVector<CanFrame> frames = engineFrames();
+    int next = 0;
+    for (auto _ : state) {
+        controller.processCanFrame(frames[next]);
+        next = (next + 1) % FrameCount;
+        if (next % FramesPerPublish == 0) {
+            controller.publishPendingChanges();
+        }
+    }
+    benchmark::DoNotOptimize(notifications);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["notifications_per_frame"] = benchmark::Counter(
+                static_cast<double>(notifications), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_NotifyFanout_FramePublish)->ArgName("receivers")->Arg(0)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// Every DBC message in turn, 10 us apart, random payloads
+QString replayLog()
+{
+    static const QString path = [] {
+        const QString logPath = QDir::temp().filePath(QStringLiteral("vehiclesys-benchmark.vscan"));
+        const QVector<DbcMessage> &messages = benchmarkDatabase().messages();
+        std::mt19937 random(1);
+        CanLogWriter writer;
+        if (messages.isEmpty() || !writer.open(logPath)) {
+            return QString();
+        }
+        for (int i = 0; i < ReplayFrameCount; ++i) {
+            const DbcMessage &message = messages.at(i % messages.size());
+            CanFrame frame = CanFrame::create(message.id, static_cast<quint8>(message.length),
+                                              message.extended ? CanFrame::ExtendedId : 0);
+            for (int byte = 0; byte < frame.length; ++byte) {
+                frame.data[byte] = static_cast<quint8>(random());
+            }
+            frame.timestampNs = static_cast<qint64>(i) * 10000;
+            writer.append(frame);
+        }
+        writer.close();
+        return logPath;
+    }();
+    return path;
+}
+
+// Replayer thread -> ring -> CanBusController drain -> frameReceived ->
+// processCanFrame -> NOTIFY, timed until the last frame has been decoded
+void BM_EndToEnd_Replay(benchmark::State &state)
+{
+    const QString logPath = replayLog();
+    if (logPath.isEmpty()) {
+        state.SkipWithError("cannot write replay log");
+        return;
+    }
+
+    CanBusController canBus;
+    VehicleDataController vehicleData;
+    subscribeAll(vehicleData);
+    QObject::connect(&canBus, &CanBusController::frameReceived,
+                     &vehicleData, &VehicleDataController::processCanFrame);
+    qint64 received = 0;
+    QObject::connect(&canBus, &CanBusController::frameReceived, &vehicleData,
+                     [&received](const CanFrame &) { ++received; });
+    canBus.setReplaySpeed(0.0);
+
+    for (auto _ : state) {
+        received = 0;
+        if (!canBus.connectToReplay(logPath)) {
+            state.SkipWithError("cannot replay log");
+            return;
+        }
+        while (received < ReplayFrameCount) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+
+    const double frames = static_cast<double>(state.iterations()) * ReplayFrameCount;
+    state.SetItemsProcessed(static_cast<int64_t>(frames));
+    state.counters["ns_per_frame"] = benchmark::Counter(
+                frames / 1e9, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["dropped"] = static_cast<double>(canBus.droppedFrames());
+}
+BENCHMARK(BM_EndToEnd_Replay)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
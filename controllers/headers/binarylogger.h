@@ -0,0 +1,246 @@
+#ifndef BINARYLOGGER_H
+#define BINARYLOGGER_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QLatin1String>
+#include <QString>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief A named group of log messages with its own rate limit.
+ *
+ * Defined once with VEHICLESYS_LOG_CATEGORY(function, "name") and declared
+ * where needed with VEHICLESYS_DECLARE_LOG_CATEGORY(function), like
+ * Q_LOGGING_CATEGORY. qDebug() categories get one each, by name.
+ *
+ * VEHICLESYS_LOG_RATE sets limits in messages per second, e.g.
+ * "vehiclesys.can=50,default=200,*=100"; messages over the limit within a
+ * second are counted and reported instead of written.
+ */
+class LogCategory
+{
+public:
+    explicit LogCategory(const char *name);
+
+    const char *name() const { return m_name; }
+
+    // Messages per second let through; 0 for no limit
+    void setRateLimit(int messagesPerSecond);
+    // False once this second's limit is used up. Shared by all threads, so
+    // the limit is approximate
+    bool admit(qint64 nowNs);
+    // Messages refused since the last call
+    quint64 takeRateLimited() { return m_rateLimited.exchange(0, std::memory_order_relaxed); }
+
+private:
+    Q_DISABLE_COPY(LogCategory)
+
+    const char *m_name;
+    std::atomic<int> m_rateLimit;
+    std::atomic<qint64> m_windowSecond;
+    std::atomic<int> m_windowCount;
+    std::atomic<quint64> m_rateLimited;
+};
+
+#define VEHICLESYS_DECLARE_LOG_CATEGORY(function) LogCategory &function();
+#define VEHICLESYS_LOG_CATEGORY(function, name) \
+    LogCategory &function() \
+    { \
+        static LogCategory category(name); \
+        return category; \
+    }
+
+namespace BinaryLog {
+
+enum Level : quint8 {
+    Debug,
+    Info,
+    Warning,
+    Critical
+};
+
+// One per call site; a record refers to it instead of carrying the format
+struct Site
+{
+    LogCategory &(*category)();
+    Level level;
+    const char *format;     // "%1".."%9" are replaced by the arguments
+    const char *file;
+    int line;
+};
+
+// An integer argument shown in hexadecimal
+struct Hex
+{
+    quint64 value;
+};
+inline Hex hex(quint64 value) { return Hex{ value }; }
+
+template<typename... Args>
+constexpr const char *formatOf(const char *format, const Args &...) { return format; }
+
+namespace detail {
+
+enum Tag : quint8 {
+    IntTag,
+    UIntTag,
+    DoubleTag,
+    BoolTag,
+    HexTag,
+    Utf8Tag,
+    Utf16Tag
+};
+
+// Longer strings are cut
+constexpr int MaxStringLength = 1024;
+
+qint64 now();
+// Space for @p payloadSize argument bytes in the calling thread's ring, or
+// nullptr if it is full (the record is counted as dropped)
+char *beginRecord(const Site &site, LogCategory *category, qint64 timestampNs, int payloadSize);
+void commitRecord();
+
+inline int stringLength(qsizetype length) { return static_cast<int>(qMin<qsizetype>(length, MaxStringLength)); }
+
+template<typename T>
+inline char *put(char *out, Tag tag, const T &value)
+{
+    *out++ = static_cast<char>(tag);
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+inline char *putString(char *out, Tag tag, const void *data, int length, int unitSize)
+{
+    *out++ = static_cast<char>(tag);
+    const quint16 units = static_cast<quint16>(length);
+    std::memcpy(out, &units, sizeof(units));
+    out += sizeof(units);
+    std::memcpy(out, data, static_cast<size_t>(length) * unitSize);
+    return out + length * unitSize;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, int>::type
+encodedSize(T)
+{
+    return 9;
+}
+inline int encodedSize(bool) { return 2; }
+inline int encodedSize(double) { return 9; }
+inline int encodedSize(Hex) { return 9; }
+inline int encodedSize(const char *text) { return 3 + stringLength(text ? qstrlen(text) : 0); }
+inline int encodedSize(const QByteArray &text) { return 3 + stringLength(text.size()); }
+inline int encodedSize(QLatin1String text) { return 3 + stringLength(text.size()); }
+inline int encodedSize(const QString &text) { return 3 + 2 * stringLength(text.size()); }
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, char *>::type
+encode(char *out, T value)
+{
+    if (std::is_signed<T>::value || std::is_enum<T>::value) {
+        return put(out, IntTag, static_cast<qint64>(value));
+    }
+    return put(out, UIntTag, static_cast<quint64>(value));
+}
+inline char *encode(char *out, bool value) { return put(out, BoolTag, static_cast<quint8>(value ? 1 : 0)); }
+inline char *encode(char *out, double value) { return put(out, DoubleTag, value); }
+inline char *encode(char *out, Hex value) { return put(out, HexTag, value.value); }
+inline char *encode(char *out, const char *text)
+{
+    return putString(out, Utf8Tag, text, stringLength(text ? qstrlen(text) : 0), 1);
+}
+inline char *encode(char *out, const QByteArray &text)
+{
+    return putString(out, Utf8Tag, text.constData(), stringLength(text.size()), 1);
+}
+inline char *encode(char *out, QLatin1String text)
+{
+    return putString(out, Utf8Tag, text.data(), stringLength(text.size()), 1);
+}
+inline char *encode(char *out, const QString &text)
+{
+    return putString(out, Utf16Tag, text.utf16(), stringLength(text.size()), 2);
+}
+
+inline int payloadSize() { return 0; }
+template<typename T, typename... Rest>
+inline int payloadSize(const T &first, const Rest &...rest)
+{
+    return encodedSize(first) + payloadSize(rest...);
+}
+
+inline char *encodeAll(char *out) { return out; }
+template<typename T, typename... Rest>
+inline char *encodeAll(char *out, const T &first, const Rest &...rest)
+{
+    return encodeAll(encode(out, first), rest...);
+}
+
+} // namespace detail
+
+/**
+ * @brief Records a message for the writer thread.
+ *
+ * Only the site pointer, a timestamp and the raw arguments are copied into
+ * the calling thread's ring; nothing is formatted or written here. Use the
+ * VEHICLESYS_LOG_* macros rather than calling this directly.
+ */
+template<typename... Args>
+inline void write(const Site &site, const char *, const Args &...args)
+{
+    LogCategory &category = site.category();
+    const qint64 timestampNs = detail::now();
+    if (!category.admit(timestampNs)) {
+        return;
+    }
+    char *out = detail::beginRecord(site, &category, timestampNs, detail::payloadSize(args...));
+    if (!out) {
+        return;
+    }
+    detail::encodeAll(out, args...);
+    detail::commitRecord();
+}
+
+} // namespace BinaryLog
+
+/**
+ * @brief Owns the writer thread; one instance, for the life of main().
+ *
+ * Starts draining every thread's ring and routes qDebug() and friends
+ * through the same rings, so the calling thread never formats for output or
+ * blocks on I/O. The writer merges the rings by time and writes to
+ * VEHICLESYS_LOG_FILE, or stderr. A message repeating its call site's
+ * previous one exactly is counted instead of written, and summarized when
+ * the site logs something else or a second has passed. Without a running
+ * logger (tools, benchmarks) messages are written synchronously.
+ */
+class BinaryLogger
+{
+public:
+    BinaryLogger();
+    ~BinaryLogger();
+
+private:
+    Q_DISABLE_COPY(BinaryLogger)
+};
+
+#define VEHICLESYS_LOG(level, category, ...) \
+    do { \
+        static const BinaryLog::Site vehiclesysLogSite = { \
+            &category, level, BinaryLog::formatOf(__VA_ARGS__), __FILE__, __LINE__ }; \
+        BinaryLog::write(vehiclesysLogSite, __VA_ARGS__); \
+    } while (false)
+
+#define VEHICLESYS_LOG_DEBUG(category, ...) VEHICLESYS_LOG(BinaryLog::Debug, category, __VA_ARGS__)
+#define VEHICLESYS_LOG_INFO(category, ...) VEHICLESYS_LOG(BinaryLog::Info, category, __VA_ARGS__)
+#define VEHICLESYS_LOG_WARNING(category, ...) VEHICLESYS_LOG(BinaryLog::Warning, category, __VA_ARGS__)
+
+// Categories shared across the application
+VEHICLESYS_DECLARE_LOG_CATEGORY(logCan)     // "vehiclesys.can"
+VEHICLESYS_DECLARE_LOG_CATEGORY(logMedia)   // "vehiclesys.media"
+
+#endif // BINARYLOGGER_H
@@ -2,66 +2,187 @@
 #define CANBUSCONTROLLER_H
 
 #include <QObject>
+#include <QThread>
 #include <QTimer>
 #include <QString>
+#include <QVector>
+#include <QList>
 
 #ifdef HAVE_QT_SERIALBUS
 #include <QCanBusDevice>
-#include <QCanBusFrame>
 #endif
 
+#include "canbusstatistics.h"
+#include "canframe.h"
+#include "canstatisticsmodel.h"
+
+class CanFrameRing;
+class CanIngestWorker;
+class SocketCanReader;
+class CanBusSimulator;
+class CanLogWriter;
+class CanLogReplayer;
+
 class CanBusController : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
     Q_PROPERTY(QString status READ status NOTIFY statusChanged)
+    Q_PROPERTY(Backend backend READ backend WRITE setBackend NOTIFY backendChanged)
+    Q_PROPERTY(int ringCapacity READ ringCapacity WRITE setRingCapacity NOTIFY ringCapacityChanged)
+    Q_PROPERTY(qint64 droppedFrames READ droppedFrames NOTIFY ringStatisticsChanged)
+    Q_PROPERTY(int ringHighWatermark READ ringHighWatermark NOTIFY ringStatisticsChanged)
+    Q_PROPERTY(qint64 simulationSeed READ simulationSeed WRITE setSimulationSeed NOTIFY simulationSeedChanged)
+    Q_PROPERTY(double simulationBusLoad READ simulationBusLoad WRITE setSimulationBusLoad NOTIFY simulationBusLoadChanged)
+    Q_PROPERTY(int simulationBitRate READ simulationBitRate WRITE setSimulationBitRate NOTIFY simulationBitRateChanged)
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(double replaySpeed READ replaySpeed WRITE setReplaySpeed NOTIFY replaySpeedChanged)
+    // Per-ID and per-thread bus statistics, refreshed once a second
+    Q_PROPERTY(CanStatisticsModel *statistics READ statisticsModel CONSTANT)
 
 public:
+    // How live bus traffic is read
+    enum Backend {
+        QtSerialBusBackend,     // QCanBus "socketcan" plugin
+        NativeSocketCanBackend  // Raw AF_CAN socket, recvmmsg + SO_TIMESTAMPING
+    };
+    Q_ENUM(Backend)
+
     explicit CanBusController(QObject *parent = nullptr);
     ~CanBusController();
 
     bool connected() const;
     QString status() const;
+    Backend backend() const;
+    int ringCapacity() const;
+    qint64 droppedFrames() const;
+    int ringHighWatermark() const;
+    qint64 simulationSeed() const;
+    double simulationBusLoad() const;
+    int simulationBitRate() const;
+    // Load of the running simulation schedule, in percent of the bit rate
+    Q_INVOKABLE double scheduledBusLoad() const;
+
+    // Both take effect the next time a bus device is opened
+    void setBackend(Backend backend);
+    void setRingCapacity(int capacity);
+
+    // Simulator settings take effect the next time simulation starts;
+    // a bus load of 0 keeps the DBC cycle times
+    void setSimulationSeed(qint64 seed);
+    void setSimulationBusLoad(double percent);
+    void setSimulationBitRate(int bitsPerSecond);
+    Q_INVOKABLE void setSimulationCycleTime(quint32 frameId, int cycleTimeMs);
+
+    // Every frame delivered to the application is appended to a binary log
+    bool recording() const;
+    Q_INVOKABLE bool startRecording(const QString &path, qint64 maxBytes = 0);
+    Q_INVOKABLE void stopRecording();
+    Q_INVOKABLE qint64 recordedFrames() const;
+    // Converts a finished log to candump -l text for can-utils
+    Q_INVOKABLE bool exportRecording(const QString &logPath, const QString &candumpPath);
+
+    // 1.0 replays in real time, 10.0 ten times faster, 0 as fast as possible;
+    // takes effect the next time a replay starts
+    double replaySpeed() const;
+    void setReplaySpeed(double speed);
+    // Share of the log replayed so far, 0 to 1
+    Q_INVOKABLE double replayProgress() const;
+
+    /**
+     * @brief Counters of every source and decoder thread.
+     *
+     * Decoders on other threads record into a shard of their own from
+     * createShard(). Frames are counted as they come off the bus, before
+     * the ring, so drops do not hide traffic; IDs removed by the kernel
+     * receive filter are never seen.
+     */
+    CanBusStatistics *statistics() const { return m_statistics; }
+    CanStatisticsModel *statisticsModel() const { return m_statisticsModel; }
+    // Writes the latest statistics in Prometheus text format, replacing the file atomically
+    Q_INVOKABLE bool writeStatistics(const QString &path);
 
 public slots:
     void connectToSimulator();
     void disconnectFromSimulator();
+    // Third source next to the bus and the simulator: a recorded log
+    bool connectToReplay(const QString &path);
+    // Extended when @p frameId carries CanFrame::ExtendedIdFlag or exceeds 0x7FF
     void sendFrame(quint32 frameId, const QByteArray &data);
+    // Only these IDs reach userspace; an empty list accepts everything.
+    // Extended IDs carry CanFrame::ExtendedIdFlag
+    void setFrameIdFilter(const QList<quint32> &frameIds);
+    // Messages, transmitters and cycle times the simulator generates
+    void setSimulationDbc(const QString &path);
 
 signals:
     void connectedChanged(bool connected);
     void statusChanged(const QString &status);
-    void frameReceived(quint32 frameId, const QByteArray &data);
+    void frameReceived(const CanFrame &frame);
+    // Each drained batch in one piece, for a decoder on another thread;
+    // only built while something is connected
+    void framesReceived(const QVector<CanFrame> &frames);
     void errorOccurred(const QString &error);
+    void backendChanged(Backend backend);
+    void ringCapacityChanged(int capacity);
+    void ringStatisticsChanged();
+    void simulationSeedChanged(qint64 seed);
+    void simulationBusLoadChanged(double percent);
+    void simulationBitRateChanged(int bitsPerSecond);
+    void recordingChanged(bool recording);
+    void replaySpeedChanged(double speed);
 
 private slots:
-#ifdef HAVE_QT_SERIALBUS
     void handleFramesReceived();
-    void handleErrorOccurred(QCanBusDevice::CanBusError error);
+    void handleReplayFinished();
+    void sampleStatistics();
+#ifdef HAVE_QT_SERIALBUS
+    void handleErrorOccurred(const QString &errorString);
     void handleStateChanged(QCanBusDevice::CanBusDeviceState state);
 #endif
-    void simulateVehicleData();
+#ifdef HAVE_SOCKETCAN
+    void handleReaderFailed(const QString &errorString);
+#endif
 
 private:
-    void setupSimulatedData();
+    void startSimulation();
     void connectToBus(const QString &interface);
-    
-#ifdef HAVE_QT_SERIALBUS
-    QCanBusDevice *m_canDevice;
+    bool openBusDevice(const QString &interface);
+    void closeBusDevice();
+
+    // Frames drained from the ring per event-loop turn
+    static constexpr int MaxDrainBatch = 512;
+
+    QThread *m_ingestThread;
+    CanIngestWorker *m_ingestWorker;
+#ifdef HAVE_SOCKETCAN
+    SocketCanReader *m_socketCanReader;
 #endif
-    QTimer *m_simulationTimer;
+    CanFrameRing *m_ring;
+    QVector<CanFrame> m_drainBuffer;
+    Backend m_backend;
+    QList<quint32> m_frameIdFilter;
+    int m_ringCapacity;
+    bool m_deviceOpen;
+    quint64 m_reportedDropped;
+    CanBusSimulator *m_simulator;
+    qint64 m_simulationSeed;
+    double m_simulationBusLoad;
+    int m_simulationBitRate;
+    CanLogWriter *m_recorder;
+    CanLogReplayer *m_replayer;
+    double m_replaySpeed;
     bool m_connected;
     QString m_status;
-    
-    // Simulated vehicle data counters
-    int m_speed;
-    int m_rpm;
-    int m_fuelLevel;
-    int m_engineTemp;
-    bool m_leftTurnSignal;
-    bool m_rightTurnSignal;
-    bool m_headlights;
-    bool m_engineRunning;
+
+    CanBusStatistics *m_statistics;
+    CanBusStatistics::Shard *m_decodeStatistics;   // Decoding done by frameReceived receivers
+    CanStatisticsModel *m_statisticsModel;
+    QTimer *m_statisticsTimer;
+    int m_busBitRate;                               // VEHICLESYS_CAN_BITRATE, for the bus load of live traffic
+    QString m_metricsPath;                          // VEHICLESYS_METRICS_FILE
+    int m_metricsInterval;                          // Samples between two writes
+    int m_samplesSinceWrite;
 };
 
 #endif // CANBUSCONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef CANBUSSIMULATOR_H
+#define CANBUSSIMULATOR_H
+
+#include <QThread>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <random>
+
+#include "canbusstatistics.h"
+#include "dbcdatabase.h"
+
+class CanFrameRing;
+
+/**
+ * @brief Deterministic multi-ECU bus simulator feeding the ingest ring.
+ *
+ * Every message of the loaded DBC is transmitted by its virtual ECU (the
+ * DBC transmitter) at its cycle time, each ECU starting at its own phase.
+ * Optionally all cycle times are scaled so the schedule reaches a target
+ * bus load at the configured bit rate. Payloads come from a simple vehicle
+ * model plus bounded random walks for the remaining signals.
+ *
+ * All randomness comes from one seeded generator and advances on the
+ * simulated clock, so a seed always yields the same frame sequence,
+ * whatever the host load. Runs on its own thread as the ring's producer.
+ */
+class CanBusSimulator : public QThread
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultBitRate = 500000;
+    static constexpr quint64 DefaultSeed = 1;
+
+    explicit CanBusSimulator(CanFrameRing *ring, QObject *parent = nullptr);
+    ~CanBusSimulator() override;
+
+    // Configuration is picked up by the next start()
+    bool loadDbc(const QString &path);
+    void setSeed(quint64 seed);
+    void setBitRate(int bitsPerSecond);
+    // Percent of the bit rate; 0 keeps the DBC cycle times as written
+    void setTargetBusLoad(double percent);
+    // Overrides the DBC cycle time of one message; 0 restores it
+    void setCycleTime(quint32 frameId, int cycleTimeMs);
+    QString errorString() const;
+    // Counters written from the simulator thread; set while it is stopped
+    void setStatistics(CanBusStatistics::Shard *statistics) { m_statistics = statistics; }
+
+    void stop();
+    quint64 framesGenerated() const { return m_framesGenerated.load(std::memory_order_relaxed); }
+    // Load the running schedule puts on the bus, in percent of the bit rate
+    double scheduledBusLoad() const;
+
+    // Worst-case bit count of a frame on the wire, stuff bits included
+    static int frameBits(int payloadLength, bool extended);
+
+signals:
+    void framesPending();
+
+protected:
+    void run() override;
+
+private:
+    // Where a signal's simulated value comes from
+    enum ValueSource {
+        RandomWalk,
+        EngineSpeed,
+        EngineLoad,
+        CoolantTemperature,
+        Throttle,
+        OilPressure,
+        FuelLevel,
+        VehicleSpeed,
+        GearPosition,
+        ParkStatus,
+        BatteryVoltage,
+        LeftTurnSignal,
+        RightTurnSignal,
+        Headlights,
+        Zero
+    };
+
+    struct SignalEncoding
+    {
+        double factor;
+        double offset;
+        double minimum;
+        double maximum;
+        double walkValue;   // Current value for RandomWalk signals
+        quint16 startBit;
+        quint8 length;
+        bool bigEndian;
+        bool isSigned;
+        ValueSource source;
+    };
+
+    struct ScheduledMessage
+    {
+        qint64 periodNs;
+        qint64 dueNs;       // Simulated time of the next transmission
+        quint32 id;
+        int firstSignal;
+        int signalCount;
+        quint8 length;
+        quint8 ecu;
+        bool extended;
+    };
+
+    // The same rules the old 10 Hz timer applied, stepped on simulated time
+    struct VehicleModel
+    {
+        int speed;
+        int rpm;
+        int fuelLevel;
+        int engineTemp;
+        bool leftTurnSignal;
+        bool rightTurnSignal;
+        bool headlights;
+        bool engineRunning;
+        qint64 ticks;
+    };
+
+    static constexpr qint64 ModelTickNs = 100000000; // 10 Hz
+
+    void buildSchedule();
+    void advanceModel(qint64 simulatedNs);
+    double modelValue(SignalEncoding &encoding);
+    static void encodeSignal(const SignalEncoding &encoding, double value, quint8 *payload);
+    static ValueSource valueSourceFor(const QString &signalName);
+    int randomInt(int low, int high); // [low, high)
+
+    CanFrameRing *m_ring;
+    CanBusStatistics::Shard *m_statistics;
+
+    // Configuration, guarded by m_configMutex
+    mutable QMutex m_configMutex;
+    QVector<DbcMessage> m_messages;
+    QHash<quint32, int> m_cycleTimeOverrides;
+    quint64 m_seed;
+    int m_bitRate;
+    double m_targetBusLoad;
+    double m_scheduledBusLoad;
+    QString m_errorString;
+
+    // Run state, only touched by the simulator thread
+    QVector<ScheduledMessage> m_schedule;   // Min-heap on dueNs
+    QVector<SignalEncoding> m_signals;
+    VehicleModel m_model;
+    std::mt19937_64 m_random;
+
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<quint64> m_framesGenerated;
+};
+
+#endif // CANBUSSIMULATOR_H
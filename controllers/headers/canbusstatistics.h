@@ -0,0 +1,234 @@
+#ifndef CANBUSSTATISTICS_H
+#define CANBUSSTATISTICS_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "canframe.h"
+
+/**
+ * @brief Bus and pipeline counters, kept per thread and summed on demand.
+ *
+ * Every thread that touches frames (each bus backend, the simulator, the
+ * replayer, the decoders) records into a Shard of its own. A shard has a
+ * single writer, so counting is a relaxed load and store with no locks or
+ * read-modify-write; readers on any thread see consistent-enough values.
+ * collect() adds all shards up and turns the difference to the previous
+ * call into rates, bus load and decode-time averages.
+ *
+ * Per frame ID a shard counts frames and wire bits, and keeps a histogram
+ * of inter-arrival jitter: how far each gap between two frames of the ID
+ * is from that ID's running mean gap.
+ */
+class CanBusStatistics
+{
+public:
+    // Upper bounds of the jitter histogram, in microseconds; one more bucket catches the rest
+    static constexpr int JitterBuckets = 8;
+    static const qint64 JitterBoundsUs[JitterBuckets - 1];
+
+    class Shard
+    {
+    public:
+        explicit Shard(const QString &name);
+        ~Shard();
+
+        const QString &name() const { return m_name; }
+
+        // --- Writer side: the thread that owns the shard ---
+        void recordFrame(const CanFrame &frame);
+        void recordErrorFrame() { increment(m_errorFrames, 1); }
+        // A frame the ingest ring had no room for
+        void recordDrop() { increment(m_drops, 1); }
+        void recordDecode(int frames, qint64 elapsedNs);
+
+    private:
+        friend class CanBusStatistics;
+        Q_DISABLE_COPY(Shard)
+
+        struct IdCounters
+        {
+            std::atomic<quint32> id{ EmptyId };
+            std::atomic<quint64> frames{ 0 };
+            std::atomic<quint64> bits{ 0 };
+            std::atomic<quint64> jitterSumNs{ 0 };
+            std::atomic<quint64> jitter[JitterBuckets] = {};
+            // Writer only
+            qint64 lastTimestampNs = 0;
+            qint64 meanIntervalNs = 0;
+        };
+
+        // Open addressing by frame ID, extended IDs with CanFrame::ExtendedIdFlag
+        // (never EmptyId); IDs beyond MaxIds are only counted in total
+        static constexpr int IdSlots = 2048;
+        static constexpr int MaxIds = IdSlots * 3 / 4;
+        static constexpr quint32 EmptyId = 0xffffffffu;
+
+        // Counters have a single writer, so a plain store is enough
+        static void increment(std::atomic<quint64> &counter, quint64 amount)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+        IdCounters *counters(quint32 id);
+
+        QString m_name;
+        alignas(64) std::atomic<quint64> m_frames{ 0 };
+        std::atomic<quint64> m_bits{ 0 };
+        std::atomic<quint64> m_errorFrames{ 0 };
+        std::atomic<quint64> m_drops{ 0 };
+        std::atomic<quint64> m_decodedFrames{ 0 };
+        std::atomic<quint64> m_decodeNs{ 0 };
+        std::atomic<quint64> m_decodeMaxNs{ 0 };
+        // Allocated by the writer on its first frame, so idle sources cost nothing
+        std::atomic<IdCounters *> m_ids{ nullptr };
+        int m_idCount = 0;  // Writer only
+    };
+
+    struct IdSample
+    {
+        quint32 id = 0;                 // Extended IDs carry CanFrame::ExtendedIdFlag
+        quint64 frames = 0;
+        quint64 bits = 0;
+        quint64 jitterSumNs = 0;
+        quint64 jitter[JitterBuckets] = {};
+        double frameRate = 0.0;         // Frames per second since the previous collect()
+        double busLoad = 0.0;           // Percent of the bit rate taken by this ID
+    };
+
+    struct ThreadSample
+    {
+        QString name;
+        quint64 frames = 0;
+        quint64 errorFrames = 0;
+        quint64 drops = 0;
+        quint64 decodedFrames = 0;
+        quint64 decodeNs = 0;
+        quint64 decodeMaxNs = 0;        // Longest single batch
+    };
+
+    struct Sample
+    {
+        qint64 timestampNs = 0;         // CLOCK_REALTIME, when collected
+        qint64 intervalNs = 0;          // Since the previous collect(), 0 for the first
+        int bitRate = 0;
+        quint64 frames = 0;
+        quint64 bits = 0;
+        quint64 errorFrames = 0;
+        quint64 drops = 0;
+        quint64 decodedFrames = 0;
+        quint64 decodeNs = 0;
+        double frameRate = 0.0;
+        double busLoad = 0.0;           // Percent of bitRate over the interval
+        double decodeNsPerFrame = 0.0;  // Over the interval
+        QVector<IdSample> ids;          // Ascending by ID
+        QVector<ThreadSample> threads;
+    };
+
+    CanBusStatistics();
+    ~CanBusStatistics();
+
+    /**
+     * @brief Returns a new shard for one writer thread.
+     * Shards live as long as this object; the name labels them in output.
+     */
+    Shard *createShard(const QString &name);
+
+    // Nominal bit rate the bus load is measured against
+    void setBitRate(int bitsPerSecond);
+    int bitRate() const { return m_bitRate.load(std::memory_order_relaxed); }
+
+    // Sums all shards; rates cover the time since the previous call.
+    // Call from one thread only
+    Sample collect();
+
+    // Prometheus text exposition format (version 0.0.4)
+    static QByteArray toPrometheus(const Sample &sample);
+
+private:
+    Q_DISABLE_COPY(CanBusStatistics)
+
+    mutable QMutex m_shardMutex;    // Registration and collection only, never per frame
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<int> m_bitRate;
+    Sample m_previous;
+    qint64 m_previousSteadyNs = 0;
+};
+
+inline void CanBusStatistics::Shard::recordFrame(const CanFrame &frame)
+{
+    const quint64 bits = static_cast<quint64>(CanFrame::wireBits(frame.length, frame.isExtended()));
+    increment(m_frames, 1);
+    increment(m_bits, bits);
+
+    IdCounters *entry = counters(frame.isExtended() ? (frame.id | CanFrame::ExtendedIdFlag) : frame.id);
+    if (!entry) {
+        return;
+    }
+    increment(entry->frames, 1);
+    increment(entry->bits, bits);
+
+    // Jitter: deviation of this gap from the running mean gap (1/16 weight)
+    if (frame.timestampNs > entry->lastTimestampNs && entry->lastTimestampNs > 0) {
+        const qint64 interval = frame.timestampNs - entry->lastTimestampNs;
+        if (entry->meanIntervalNs == 0) {
+            entry->meanIntervalNs = interval;
+        }
+        const qint64 jitterNs = qAbs(interval - entry->meanIntervalNs);
+        entry->meanIntervalNs += (interval - entry->meanIntervalNs) / 16;
+
+        int bucket = 0;
+        while (bucket < JitterBuckets - 1 && jitterNs > JitterBoundsUs[bucket] * 1000) {
+            ++bucket;
+        }
+        increment(entry->jitter[bucket], 1);
+        increment(entry->jitterSumNs, static_cast<quint64>(jitterNs));
+    }
+    if (frame.timestampNs > 0) {
+        entry->lastTimestampNs = frame.timestampNs;
+    }
+}
+
+inline void CanBusStatistics::Shard::recordDecode(int frames, qint64 elapsedNs)
+{
+    increment(m_decodedFrames, static_cast<quint64>(frames));
+    increment(m_decodeNs, static_cast<quint64>(elapsedNs));
+    if (static_cast<quint64>(elapsedNs) > m_decodeMaxNs.load(std::memory_order_relaxed)) {
+        m_decodeMaxNs.store(static_cast<quint64>(elapsedNs), std::memory_order_relaxed);
+    }
+}
+
+inline CanBusStatistics::Shard::IdCounters *CanBusStatistics::Shard::counters(quint32 id)
+{
+    IdCounters *table = m_ids.load(std::memory_order_relaxed);
+    if (!table) {
+        table = new IdCounters[IdSlots];
+        m_ids.store(table, std::memory_order_release);
+    }
+
+    quint32 slot = (id * 0x9e3779b1u) >> 21; // Top 11 bits: 0..IdSlots-1
+    while (true) {
+        IdCounters &entry = table[slot];
+        const quint32 entryId = entry.id.load(std::memory_order_relaxed);
+        if (entryId == id) {
+            return &entry;
+        }
+        if (entryId == EmptyId) {
+            if (m_idCount >= MaxIds) {
+                return nullptr;
+            }
+            ++m_idCount;
+            // Counters are zero already; publish the ID last
+            entry.id.store(id, std::memory_order_release);
+            return &entry;
+        }
+        slot = (slot + 1) & (IdSlots - 1);
+    }
+}
+
+#endif // CANBUSSTATISTICS_H
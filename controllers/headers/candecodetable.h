@@ -0,0 +1,180 @@
+#ifndef CANDECODETABLE_H
+#define CANDECODETABLE_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QVector>
+#include <QStringList>
+#include <cstring>
+
+class DbcDatabase;
+
+/**
+ * @brief Flat, precompiled decode table built from a DBC database.
+ *
+ * Every signal is reduced to "load 8 bytes at byteOffset, shift, mask,
+ * sign-extend, scale", so decoding a frame is a handful of integer ops
+ * per signal with no parsing or branching on the DBC description.
+ * Standard 11-bit IDs are resolved through a direct index; extended IDs
+ * through a sorted array, so 0x100 and extended 0x100 are different messages.
+ */
+class CanDecodeTable
+{
+public:
+    // Payload buffers handed to decode() must have this many readable
+    // bytes past the frame length (any value), so every 8-byte load is safe
+    static constexpr int PayloadPadding = 8;
+    static constexpr int MaxPayload = 64;
+    // decode() selects signals by position in their message, one bit each;
+    // signals past the first SelectableSignals are always decoded
+    static constexpr int SelectableSignals = 64;
+    static constexpr quint64 AllSignals = ~quint64(0);
+
+    enum SignalFlag : quint8 {
+        BigEndian   = 0x01,
+        Signed      = 0x02,
+        Multiplexor = 0x04,
+        Multiplexed = 0x08,
+        Wide        = 0x10 // Spans more than one 64-bit window; decoded bit by bit
+    };
+
+    struct Signal
+    {
+        quint64 mask;
+        double factor;
+        double offset;
+        qint32 multiplexValue;
+        quint16 byteOffset;
+        quint16 minLength;   // Payload bytes required for the signal to be present
+        quint16 startBit;    // Original DBC start bit (used by the Wide path)
+        quint8 shift;
+        quint8 length;
+        quint8 flags;
+    };
+
+    struct Message
+    {
+        quint32 id;
+        quint16 firstSignal;
+        quint16 signalCount;
+        qint16 multiplexor;  // Index into signals, or -1
+        quint8 length;
+        quint8 extended;
+        qint32 cycleTimeMs;
+    };
+
+    CanDecodeTable();
+
+    void compile(const DbcDatabase &database);
+    void clear();
+
+    const Message *find(quint32 id, bool extended) const;
+    const QVector<Message> &messages() const { return m_messages; }
+    const Signal &signalAt(int index) const { return m_signals[index]; }
+    int signalCount() const { return m_signals.size(); }
+    QString signalName(int index) const { return m_signalNames.value(index); }
+    int indexOfSignal(const QString &name) const { return m_signalNames.indexOf(name); }
+    // Sorted; extended IDs carry CanFrame::ExtendedIdFlag
+    QList<quint32> frameIds() const;
+
+    // Raw (unscaled, sign-extended) value of a signal
+    static qint64 rawValue(const Signal &signal, const quint8 *payload);
+    static double physicalValue(const Signal &signal, const quint8 *payload)
+    {
+        return static_cast<double>(rawValue(signal, payload)) * signal.factor + signal.offset;
+    }
+
+    /**
+     * @brief Decodes the selected signals of @p message present in the payload.
+     * @param payload Frame data followed by PayloadPadding readable bytes.
+     * @param sink Called as sink(signalIndex, physicalValue).
+     * @param selected Signals to decode, bit N for the Nth signal of the message.
+     */
+    template<typename Sink>
+    void decode(const Message &message, const quint8 *payload, int length, Sink &&sink,
+                quint64 selected = AllSignals) const;
+
+    static bool isSelected(quint64 selected, int ordinal)
+    {
+        return ordinal >= SelectableSignals || ((selected >> ordinal) & 1);
+    }
+
+private:
+    static quint64 loadLittleEndian(const quint8 *bytes);
+    static quint64 loadBigEndian(const quint8 *bytes);
+    static qint64 wideRawValue(const Signal &signal, const quint8 *payload);
+
+    QVector<Message> m_messages;
+    QVector<Signal> m_signals;
+    QStringList m_signalNames;
+    QVector<qint16> m_standardIndex;   // 2048 entries, -1 when unknown
+    QVector<quint32> m_extendedIds;     // Sorted
+    QVector<qint16> m_extendedIndex;    // Parallel to m_extendedIds
+};
+
+inline quint64 CanDecodeTable::loadLittleEndian(const quint8 *bytes)
+{
+    quint64 value;
+    std::memcpy(&value, bytes, sizeof(value));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline quint64 CanDecodeTable::loadBigEndian(const quint8 *bytes)
+{
+    quint64 value;
+    std::memcpy(&value, bytes, sizeof(value));
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline qint64 CanDecodeTable::rawValue(const Signal &signal, const quint8 *payload)
+{
+    if (Q_UNLIKELY(signal.flags & Wide)) {
+        return wideRawValue(signal, payload);
+    }
+
+    const quint8 *window = payload + signal.byteOffset;
+    quint64 raw = (signal.flags & BigEndian) ? loadBigEndian(window) : loadLittleEndian(window);
+    raw = (raw >> signal.shift) & signal.mask;
+
+    if ((signal.flags & Signed) && (raw & ~(signal.mask >> 1))) {
+        raw |= ~signal.mask;
+    }
+    return static_cast<qint64>(raw);
+}
+
+template<typename Sink>
+inline void CanDecodeTable::decode(const Message &message, const quint8 *payload, int length, Sink &&sink,
+                                   quint64 selected) const
+{
+    const Signal *first = m_signals.constData() + message.firstSignal;
+    const Signal *last = first + message.signalCount;
+
+    qint64 multiplexValue = -1;
+    if (message.multiplexor >= 0) {
+        const Signal &selector = m_signals[message.multiplexor];
+        if (selector.minLength <= length) {
+            multiplexValue = rawValue(selector, payload);
+        }
+    }
+
+    for (const Signal *signal = first; signal != last; ++signal) {
+        if (!isSelected(selected, static_cast<int>(signal - first))) {
+            continue;
+        }
+        if (signal->minLength > length) {
+            continue;
+        }
+        if ((signal->flags & Multiplexed) && signal->multiplexValue != multiplexValue) {
+            continue;
+        }
+        sink(static_cast<int>(signal - m_signals.constData()), physicalValue(*signal, payload));
+    }
+}
+
+#endif // CANDECODETABLE_H
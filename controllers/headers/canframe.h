@@ -0,0 +1,108 @@
+#ifndef CANFRAME_H
+#define CANFRAME_H
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Fixed-size CAN / CAN FD frame, passed by value from every source
+ * (bus backends, simulator) through the ingest ring to the decoder.
+ *
+ * Trivially copyable with an inline payload, so it lives in preallocated
+ * buffers and crosses queued connections without any heap allocation.
+ */
+struct CanFrame
+{
+    static constexpr int MaxPayload = 64;
+    // Marks an extended ID in ID lists and keys, as CAN_EFF_FLAG does in
+    // SocketCAN: the same number is a different frame in the other format
+    static constexpr quint32 ExtendedIdFlag = 0x80000000u;
+
+    enum Flag : quint8 {
+        ExtendedId    = 0x01, // 29-bit identifier
+        FlexibleData  = 0x02, // CAN FD frame, up to 64 payload bytes
+        BitRateSwitch = 0x04, // FD data phase sent at the faster bit rate
+        ErrorState    = 0x08, // FD ESI: transmitter is error passive
+        RemoteRequest = 0x10
+    };
+
+    qint64 timestampNs; // Receive time (CLOCK_REALTIME), 0 when unknown
+    quint32 id;
+    quint8 length;      // Payload bytes: 0-8 classic, 0-64 FD
+    quint8 flags;
+    quint8 bus;         // Index of the bus the frame was seen on
+    quint8 reserved;
+    quint8 data[MaxPayload];
+
+    bool isExtended() const { return flags & ExtendedId; }
+    bool isFlexibleData() const { return flags & FlexibleData; }
+    // Data length code for the payload size (FD sizes round up to a valid one)
+    quint8 dlc() const { return lengthToDlc(length); }
+
+    static CanFrame create(quint32 id, int length, quint8 flags = 0, quint8 bus = 0);
+    static quint8 lengthToDlc(int length);
+    static int dlcToLength(int dlc);
+    // Worst-case bit count on the wire, stuff bits included
+    static int wireBits(int length, bool extended);
+    static qint64 currentTimestampNs();
+};
+
+static_assert(std::is_trivially_copyable<CanFrame>::value, "CanFrame must stay trivially copyable");
+
+// Zeroed payload, FD flag derived from the length, stamped with the current time.
+// ExtendedId comes from the caller: a small ID can be an extended one
+inline CanFrame CanFrame::create(quint32 id, int length, quint8 flags, quint8 bus)
+{
+    CanFrame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    frame.id = id;
+    frame.length = static_cast<quint8>(qBound(0, length, static_cast<int>(MaxPayload)));
+    frame.flags = flags;
+    if (frame.length > 8) {
+        frame.flags |= FlexibleData;
+    }
+    frame.bus = bus;
+    frame.timestampNs = currentTimestampNs();
+    return frame;
+}
+
+inline quint8 CanFrame::lengthToDlc(int length)
+{
+    if (length <= 8) return static_cast<quint8>(qMax(0, length));
+    if (length <= 12) return 9;
+    if (length <= 16) return 10;
+    if (length <= 20) return 11;
+    if (length <= 24) return 12;
+    if (length <= 32) return 13;
+    if (length <= 48) return 14;
+    return 15;
+}
+
+inline int CanFrame::dlcToLength(int dlc)
+{
+    static constexpr quint8 lengths[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+    return lengths[dlc & 0x0F];
+}
+
+inline int CanFrame::wireBits(int length, bool extended)
+{
+    // Classic CAN worst case: 8n + g + 13 + floor((g + 8n - 1) / 4), with g
+    // = 34 or 54 header bits that are subject to stuffing. FD data phases are
+    // counted at the nominal rate, which overstates their load.
+    const int dataBits = 8 * length;
+    const int headerBits = extended ? 54 : 34;
+    return dataBits + headerBits + 13 + (headerBits + dataBits - 1) / 4;
+}
+
+inline qint64 CanFrame::currentTimestampNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Q_DECLARE_METATYPE(CanFrame)
+
+#endif // CANFRAME_H
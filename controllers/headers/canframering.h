@@ -0,0 +1,123 @@
+#ifndef CANFRAMERING_H
+#define CANFRAMERING_H
+
+#include <QtGlobal>
+#include <atomic>
+
+#include "canframe.h"
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring of CAN frames.
+ *
+ * The ingest thread is the only producer and the GUI thread the only
+ * consumer. Indices are free-running 32-bit counters masked into a
+ * power-of-two buffer, so neither side ever takes a lock or allocates.
+ * When the ring is full the newest frame is dropped and counted.
+ */
+class CanFrameRing
+{
+public:
+    static constexpr int DefaultCapacity = 4096;
+
+    explicit CanFrameRing(int capacity = DefaultCapacity);
+    ~CanFrameRing();
+
+    /**
+     * @brief Reallocates the buffer and clears all counters.
+     * Only valid while neither producer nor consumer is running.
+     * @param capacity Requested capacity, rounded up to a power of two.
+     */
+    void reset(int capacity);
+    int capacity() const { return static_cast<int>(m_mask + 1); }
+
+    // --- Producer side (ingest thread) ---
+    bool push(const CanFrame &frame);
+    // Slots free right now; lets a producer that must not drop wait instead
+    int freeSpace();
+    /**
+     * @brief Flags that the consumer has work to do.
+     * @return True if the consumer was idle and must be notified.
+     */
+    bool markPending() { return !m_pending.exchange(true, std::memory_order_acq_rel); }
+
+    // --- Consumer side (GUI thread) ---
+    int pop(CanFrame *out, int maxFrames);
+    void clearPending() { m_pending.store(false, std::memory_order_release); }
+    bool isEmpty() const;
+
+    // --- Statistics, readable from any thread ---
+    quint64 pushedCount() const { return m_pushed.load(std::memory_order_relaxed); }
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    int highWatermark() const { return static_cast<int>(m_highWatermark.load(std::memory_order_relaxed)); }
+
+private:
+    Q_DISABLE_COPY(CanFrameRing)
+
+    // Producer-owned line
+    alignas(64) std::atomic<quint32> m_head;
+    quint32 m_cachedTail;
+    std::atomic<quint64> m_pushed;
+    std::atomic<quint64> m_dropped;
+    std::atomic<quint32> m_highWatermark;
+
+    // Consumer-owned line
+    alignas(64) std::atomic<quint32> m_tail;
+    quint32 m_cachedHead;
+
+    alignas(64) std::atomic<bool> m_pending;
+    CanFrame *m_frames;
+    quint32 m_mask;
+};
+
+inline bool CanFrameRing::push(const CanFrame &frame)
+{
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    if (head - m_cachedTail > m_mask) {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        if (head - m_cachedTail > m_mask) {
+            // Counters have a single writer, so a plain store is enough
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    m_frames[head & m_mask] = frame;
+    m_head.store(head + 1, std::memory_order_release);
+
+    m_pushed.store(m_pushed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    const quint32 used = head + 1 - m_cachedTail;
+    if (used > m_highWatermark.load(std::memory_order_relaxed)) {
+        m_highWatermark.store(used, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+inline int CanFrameRing::freeSpace()
+{
+    m_cachedTail = m_tail.load(std::memory_order_acquire);
+    return static_cast<int>(m_mask + 1 - (m_head.load(std::memory_order_relaxed) - m_cachedTail));
+}
+
+inline int CanFrameRing::pop(CanFrame *out, int maxFrames)
+{
+    const quint32 tail = m_tail.load(std::memory_order_relaxed);
+    quint32 available = m_cachedHead - tail;
+    if (available < static_cast<quint32>(maxFrames)) {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        available = m_cachedHead - tail;
+    }
+
+    const quint32 count = qMin(available, static_cast<quint32>(maxFrames));
+    for (quint32 i = 0; i < count; ++i) {
+        out[i] = m_frames[(tail + i) & m_mask];
+    }
+    m_tail.store(tail + count, std::memory_order_release);
+    return static_cast<int>(count);
+}
+
+inline bool CanFrameRing::isEmpty() const
+{
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed);
+}
+
+#endif // CANFRAMERING_H
@@ -0,0 +1,68 @@
+#ifndef CANINGESTWORKER_H
+#define CANINGESTWORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+#ifdef HAVE_QT_SERIALBUS
+#include <QCanBusDevice>
+#endif
+
+#include "canbusstatistics.h"
+
+class CanFrameRing;
+
+/**
+ * @brief Owns the CAN bus device on the dedicated ingest thread.
+ *
+ * Every frame the device delivers is copied into the SPSC ring. The GUI
+ * side is poked with framesPending() only when it is not already
+ * scheduled to drain, so a burst costs one event-loop turn, not one
+ * signal per frame.
+ */
+class CanIngestWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CanIngestWorker(CanFrameRing *ring, QObject *parent = nullptr);
+    ~CanIngestWorker();
+
+    // Counters written from the ingest thread; set before the device opens
+    void setStatistics(CanBusStatistics::Shard *statistics) { m_statistics = statistics; }
+
+public slots:
+    bool openDevice(const QString &plugin, const QString &interface);
+    void closeDevice();
+    void writeFrame(quint32 frameId, const QByteArray &data);
+    void setFrameIdFilter(const QList<quint32> &frameIds);
+
+signals:
+    void framesPending();
+#ifdef HAVE_QT_SERIALBUS
+    void errorOccurred(const QString &errorString);
+    void stateChanged(QCanBusDevice::CanBusDeviceState state);
+#endif
+
+private slots:
+#ifdef HAVE_QT_SERIALBUS
+    void readFrames();
+    void handleDeviceError(QCanBusDevice::CanBusError error);
+#endif
+
+private:
+#ifdef HAVE_QT_SERIALBUS
+    void applyFrameIdFilter();
+#endif
+
+    CanFrameRing *m_ring;
+    CanBusStatistics::Shard *m_statistics;
+    QList<quint32> m_frameIdFilter;
+#ifdef HAVE_QT_SERIALBUS
+    QCanBusDevice *m_device;
+#endif
+};
+
+#endif // CANINGESTWORKER_H
@@ -0,0 +1,96 @@
+#ifndef CANLOGFORMAT_H
+#define CANLOGFORMAT_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+#include "canframe.h"
+
+/**
+ * On-disk layout of a CAN traffic log (.vscan).
+ *
+ *   [FileHeader, padded to HeaderSize]
+ *   [group 0: IndexBlock | Record x RecordsPerGroup]
+ *   [group 1: IndexBlock | Record x RecordsPerGroup]
+ *   ...
+ *
+ * Every slot is RecordSize bytes, so record N lives at a computable offset
+ * and a reader can binary-search the index blocks by time without touching
+ * the records in between. Values are stored in host byte order; the magic
+ * and version reject files from a different layout.
+ */
+namespace CanLog {
+
+constexpr char Magic[8] = { 'V', 'S', 'C', 'A', 'N', 'L', 'O', 'G' };
+constexpr quint32 Version = 1;
+constexpr int HeaderSize = 4096;
+constexpr int RecordSize = 80;
+constexpr int GroupSlots = 1024;
+constexpr int RecordsPerGroup = GroupSlots - 1;
+constexpr qint64 GroupBytes = qint64(GroupSlots) * RecordSize;
+constexpr quint32 IndexMagic = 0x58444E49; // "INDX"
+
+enum HeaderFlag : quint32 {
+    CleanClose = 0x1  // Writer closed the log; otherwise counts may trail a crash
+};
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 recordSize;
+    quint32 groupSlots;
+    quint32 flags;
+    quint64 recordCount;       // Kept current on every append
+    qint64 startTimestampNs;
+    qint64 endTimestampNs;
+    quint64 droppedCount;      // Frames lost because the log was full
+};
+
+// Summary of the records that follow it in the same group
+struct IndexBlock
+{
+    quint32 magic;             // IndexMagic once the block is written
+    quint32 group;
+    quint32 recordCount;
+    quint32 reserved;
+    qint64 firstTimestampNs;
+    qint64 lastTimestampNs;
+    quint64 idBloom;           // Bit (id % 64) set for every ID in the group
+    quint8 padding[RecordSize - 40];
+};
+
+// Same layout as CanFrame, so frames are stored with a single copy
+struct Record
+{
+    qint64 timestampNs;
+    quint32 id;
+    quint8 length;
+    quint8 flags;
+    quint8 bus;
+    quint8 reserved;
+    quint8 data[CanFrame::MaxPayload];
+};
+
+static_assert(sizeof(FileHeader) <= HeaderSize, "FileHeader must fit in HeaderSize");
+static_assert(sizeof(IndexBlock) == RecordSize, "IndexBlock must fill one slot");
+static_assert(sizeof(Record) == RecordSize, "Record must fill one slot");
+static_assert(sizeof(Record) == sizeof(CanFrame)
+              && offsetof(Record, id) == offsetof(CanFrame, id)
+              && offsetof(Record, length) == offsetof(CanFrame, length)
+              && offsetof(Record, data) == offsetof(CanFrame, data),
+              "Record must mirror CanFrame");
+
+inline qint64 indexOffset(quint64 group)
+{
+    return HeaderSize + static_cast<qint64>(group) * GroupBytes;
+}
+
+inline qint64 recordOffset(quint64 index)
+{
+    return indexOffset(index / RecordsPerGroup) + static_cast<qint64>(1 + index % RecordsPerGroup) * RecordSize;
+}
+
+} // namespace CanLog
+
+#endif // CANLOGFORMAT_H
@@ -0,0 +1,65 @@
+#ifndef CANLOGREADER_H
+#define CANLOGREADER_H
+
+#include <QString>
+#include <cstring>
+
+#include "canframe.h"
+#include "canlogformat.h"
+
+/**
+ * @brief Read-only, memory-mapped view of a CAN log written by CanLogWriter.
+ *
+ * Records are accessed in place by index; lowerBound() finds a point in
+ * time through the index blocks. Logs cut short by a crash open fine, up
+ * to the last record the header counted.
+ */
+class CanLogReader
+{
+public:
+    CanLogReader();
+    ~CanLogReader();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString path() const { return m_path; }
+    QString errorString() const { return m_errorString; }
+
+    quint64 recordCount() const { return m_recordCount; }
+    qint64 startTimestampNs() const;
+    qint64 endTimestampNs() const;
+    bool closedCleanly() const;
+
+    const CanLog::Record &record(quint64 index) const
+    {
+        return *reinterpret_cast<const CanLog::Record *>(m_map + CanLog::recordOffset(index));
+    }
+    void readFrame(quint64 index, CanFrame *frame) const
+    {
+        std::memcpy(frame, &record(index), CanLog::RecordSize);
+    }
+
+    // Page-cache hints for streaming: read a range ahead, drop one behind
+    void prefetch(quint64 first, quint64 count) const;
+    void release(quint64 first, quint64 count) const;
+
+    // First record stamped at or after timestampNs (records are in arrival order)
+    quint64 lowerBound(qint64 timestampNs) const;
+
+    // candump -l text: "(seconds.micros) interface ID#DATA", FD as "ID##<flags>DATA"
+    bool exportCandump(const QString &outputPath, const QString &interfaceName = QStringLiteral("can0"));
+
+private:
+    const CanLog::FileHeader &header() const { return *reinterpret_cast<const CanLog::FileHeader *>(m_map); }
+    void adviseRecords(quint64 first, quint64 count, int advice) const;
+
+    const uchar *m_map;
+    qint64 m_mapSize;
+    int m_fd;
+    quint64 m_recordCount;
+    QString m_path;
+    QString m_errorString;
+};
+
+#endif // CANLOGREADER_H
@@ -0,0 +1,66 @@
+#ifndef CANLOGREPLAYER_H
+#define CANLOGREPLAYER_H
+
+#include <QThread>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+#include "canbusstatistics.h"
+#include "canlogreader.h"
+
+class CanFrameRing;
+
+/**
+ * @brief Plays a recorded CAN log back into the ingest ring.
+ *
+ * At a positive speed frames keep their original spacing, divided by the
+ * speed (1.0 is real time); at speed 0 they are pushed as fast as the
+ * consumer drains them, for throughput measurement. A replay never drops:
+ * when the ring is full the replayer waits for room.
+ *
+ * The log is read in place through its mapping. A window ahead of the
+ * replay position is prefetched and the one behind released, so logs far
+ * larger than memory stream without being resident. Frames are restamped
+ * with the wall-clock time they are replayed at.
+ */
+class CanLogReplayer : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit CanLogReplayer(CanFrameRing *ring, QObject *parent = nullptr);
+    ~CanLogReplayer() override;
+
+    // Both are picked up by the next start()
+    bool open(const QString &path);
+    void setSpeed(double speed);
+    QString errorString() const;
+    // Counters written from the replay thread; set while it is stopped
+    void setStatistics(CanBusStatistics::Shard *statistics) { m_statistics = statistics; }
+
+    void stop();
+    quint64 recordCount() const { return m_reader.recordCount(); }
+    quint64 framesReplayed() const { return m_framesReplayed.load(std::memory_order_relaxed); }
+
+signals:
+    void framesPending();
+
+protected:
+    void run() override;
+
+private:
+    CanFrameRing *m_ring;
+    CanBusStatistics::Shard *m_statistics;
+    CanLogReader m_reader;
+    double m_speed;
+    QString m_errorString;
+
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<quint64> m_framesReplayed;
+};
+
+#endif // CANLOGREPLAYER_H
@@ -0,0 +1,103 @@
+#ifndef CANLOGWRITER_H
+#define CANLOGWRITER_H
+
+#include <QString>
+#include <cstring>
+
+#include "canframe.h"
+#include "canlogformat.h"
+
+/**
+ * @brief Appends frames to a preallocated, memory-mapped CAN log.
+ *
+ * open() reserves the whole file on disk and maps it once; append() is
+ * then a copy into the mapping plus a few counter updates, never an
+ * allocation. A background thread faults in the groups ahead of the one
+ * being filled, so page faults and system calls stay off the caller's
+ * thread. Once the file is full, further frames are counted as dropped.
+ */
+class CanLogWriter
+{
+public:
+    static constexpr qint64 DefaultMaxBytes = qint64(256) << 20;
+
+    CanLogWriter();
+    ~CanLogWriter();
+
+    bool open(const QString &path, qint64 maxBytes = DefaultMaxBytes);
+    // Writes the last index block, trims the file and unmaps it
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString path() const { return m_path; }
+    QString errorString() const { return m_errorString; }
+
+    bool append(const CanFrame &frame);
+    void append(const CanFrame *frames, int count);
+
+    quint64 recordCount() const { return m_recordCount; }
+    quint64 droppedCount() const { return m_droppedCount; }
+
+private:
+    class Prefaulter;
+
+    // Groups faulted in ahead of the one being filled
+    static constexpr quint64 PrefaultAhead = 2;
+
+    void finishGroup();
+    void writeIndexBlock();
+
+    Prefaulter *m_prefaulter;
+    uchar *m_map;
+    qint64 m_mapSize;
+    int m_fd;
+    CanLog::FileHeader *m_header;
+    uchar *m_nextSlot;          // Where the next record goes
+    quint64 m_capacity;         // Records that fit in the mapping
+    quint64 m_recordCount;
+    quint64 m_droppedCount;
+    quint64 m_group;
+    CanLog::IndexBlock m_groupIndex; // Built in memory, written when the group is done
+    QString m_path;
+    QString m_errorString;
+};
+
+inline bool CanLogWriter::append(const CanFrame &frame)
+{
+    if (Q_UNLIKELY(m_recordCount >= m_capacity)) {
+        ++m_droppedCount;
+        m_header->droppedCount = m_droppedCount;
+        return false;
+    }
+
+    std::memcpy(m_nextSlot, &frame, CanLog::RecordSize);
+    m_nextSlot += CanLog::RecordSize;
+
+    if (m_groupIndex.recordCount == 0) {
+        m_groupIndex.firstTimestampNs = frame.timestampNs;
+    }
+    m_groupIndex.lastTimestampNs = frame.timestampNs;
+    m_groupIndex.idBloom |= quint64(1) << (frame.id & 63);
+    ++m_groupIndex.recordCount;
+
+    // The header lives in the mapping too, so a crash still leaves the count
+    ++m_recordCount;
+    m_header->recordCount = m_recordCount;
+    m_header->endTimestampNs = frame.timestampNs;
+    if (Q_UNLIKELY(m_recordCount == 1)) {
+        m_header->startTimestampNs = frame.timestampNs;
+    }
+
+    if (Q_UNLIKELY(m_groupIndex.recordCount == CanLog::RecordsPerGroup)) {
+        finishGroup();
+    }
+    return true;
+}
+
+inline void CanLogWriter::append(const CanFrame *frames, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        append(frames[i]);
+    }
+}
+
+#endif // CANLOGWRITER_H
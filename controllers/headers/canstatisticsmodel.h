@@ -0,0 +1,75 @@
+#ifndef CANSTATISTICSMODEL_H
+#define CANSTATISTICSMODEL_H
+
+#include <QAbstractListModel>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include "canbusstatistics.h"
+
+/**
+ * @brief Bus statistics as a QML list model, one row per frame ID.
+ *
+ * Filled from CanBusStatistics::collect() samples; rows carry counts,
+ * rates, bus load share and the jitter histogram of one ID, and the
+ * properties hold the bus-wide figures. Everything changes at the
+ * sampling rate only, so a diagnostics page costs nothing per frame.
+ */
+class CanStatisticsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(double busLoad READ busLoad NOTIFY updated)
+    Q_PROPERTY(double frameRate READ frameRate NOTIFY updated)
+    Q_PROPERTY(qint64 totalFrames READ totalFrames NOTIFY updated)
+    Q_PROPERTY(qint64 errorFrames READ errorFrames NOTIFY updated)
+    Q_PROPERTY(qint64 droppedFrames READ droppedFrames NOTIFY updated)
+    Q_PROPERTY(double decodeTimeNs READ decodeTimeNs NOTIFY updated)
+    Q_PROPERTY(int bitRate READ bitRate NOTIFY updated)
+    // Per thread: name, frames, errorFrames, drops, decodedFrames, decodeTimeNs, decodeBatchMaxNs
+    Q_PROPERTY(QVariantList threads READ threads NOTIFY updated)
+
+public:
+    enum Role {
+        FrameIdRole = Qt::UserRole + 1,
+        ExtendedRole,
+        FramesRole,
+        FrameRateRole,
+        BusLoadRole,
+        JitterMeanRole,         // Microseconds
+        JitterHistogramRole,    // Counts per bucket, see jitterBounds
+        Jitter99Role            // Upper bound of the bucket holding the 99th percentile, -1 past the last
+    };
+    Q_ENUM(Role)
+
+    explicit CanStatisticsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    double busLoad() const { return m_sample.busLoad; }
+    double frameRate() const { return m_sample.frameRate; }
+    qint64 totalFrames() const { return static_cast<qint64>(m_sample.frames); }
+    qint64 errorFrames() const { return static_cast<qint64>(m_sample.errorFrames); }
+    qint64 droppedFrames() const { return static_cast<qint64>(m_sample.drops); }
+    double decodeTimeNs() const { return m_sample.decodeNsPerFrame; }
+    int bitRate() const { return m_sample.bitRate; }
+    QVariantList threads() const;
+
+    // Upper bounds of the jitter histogram buckets in microseconds
+    Q_INVOKABLE QVariantList jitterBounds() const;
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+    const CanBusStatistics::Sample &sample() const { return m_sample; }
+    void update(const CanBusStatistics::Sample &sample);
+
+signals:
+    void countChanged();
+    void updated();
+
+private:
+    CanBusStatistics::Sample m_sample;
+};
+
+#endif // CANSTATISTICSMODEL_H
@@ -0,0 +1,84 @@
+#ifndef DBCDATABASE_H
+#define DBCDATABASE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QMap>
+
+/**
+ * @brief One signal (SG_) of a DBC message, as written in the file.
+ */
+struct DbcSignal
+{
+    enum MultiplexMode {
+        Plain,          // Always present
+        Multiplexor,    // "M": selects which multiplexed signals are present
+        Multiplexed     // "mN": present only when the multiplexor equals N
+    };
+
+    QString name;
+    int startBit = 0;
+    int length = 0;
+    bool bigEndian = false; // @0 = Motorola, @1 = Intel
+    bool isSigned = false;
+    double factor = 1.0;
+    double offset = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    QString unit;
+    MultiplexMode multiplexMode = Plain;
+    int multiplexValue = 0;
+    QMap<qint64, QString> valueNames; // VAL_ table
+};
+
+/**
+ * @brief One message (BO_) of a DBC file.
+ */
+struct DbcMessage
+{
+    quint32 id = 0;
+    bool extended = false;
+    QString name;
+    int length = 0;
+    QString transmitter;
+    int cycleTimeMs = 0; // GenMsgCycleTime, 0 when not given
+    QVector<DbcSignal> signalList;
+};
+
+/**
+ * @brief Minimal DBC parser covering the subset needed for decoding.
+ *
+ * Understands BO_, SG_ (including multiplexing), VAL_ and the
+ * GenMsgCycleTime attribute; everything else is skipped.
+ */
+class DbcDatabase
+{
+public:
+    bool load(const QString &path);
+    bool parse(const QByteArray &text);
+
+    const QVector<DbcMessage> &messages() const { return m_messages; }
+    // Standard and extended messages can share an ID
+    const DbcMessage *message(quint32 id, bool extended) const;
+    QString errorString() const { return m_errorString; }
+    // FNV-1a of the parsed text; ties generated decoders to their source file
+    quint32 checksum() const { return m_checksum; }
+    static quint32 checksum(const QByteArray &text);
+
+private:
+    bool parseMessage(const QByteArray &line);
+    bool parseSignal(const QByteArray &line);
+    void parseAttribute(const QByteArray &line);
+    void parseValueTable(const QByteArray &line);
+    // @p rawId as written in the DBC, bit 31 marking an extended ID
+    DbcMessage *findMessage(quint32 rawId);
+
+    QVector<DbcMessage> m_messages;
+    int m_defaultCycleTimeMs = 0;
+    int m_lineNumber = 0;
+    quint32 m_checksum = 0;
+    QString m_errorString;
+};
+
+#endif // DBCDATABASE_H
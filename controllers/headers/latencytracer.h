@@ -0,0 +1,155 @@
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QPointer>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+class QQuickWindow;
+class QTimer;
+
+/**
+ * @brief Log-linear histogram of nanosecond latencies.
+ *
+ * Eight buckets per power of two, so a percentile is off by at most 12.5%;
+ * the maximum is exact. Values from 2^40 ns (about 18 minutes) up are
+ * clamped.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() { clear(); }
+
+    void record(qint64 ns);
+    void clear();
+
+    quint64 count() const { return m_count; }
+    qint64 max() const { return m_max; }
+    double mean() const { return m_count ? double(m_sum) / m_count : 0.0; }
+    qint64 sum() const { return m_sum; }
+    // Upper bound of the bucket holding quantile @p q (0..1), at most max()
+    qint64 percentile(double q) const;
+
+private:
+    static constexpr int SubBucketBits = 3;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxBits = 40;
+    static constexpr int Buckets = (MaxBits - SubBucketBits + 1) * SubBuckets;
+
+    static int bucketOf(qint64 ns);
+    static qint64 bucketUpperBound(int bucket);
+
+    quint32 m_buckets[Buckets];
+    quint64 m_count;
+    qint64 m_sum;
+    qint64 m_max;
+};
+
+/**
+ * @brief Measures how long a CAN value takes to reach the screen.
+ *
+ * Each traced change carries four timestamps, all CLOCK_REALTIME:
+ * receive (kernel, simulator or replay time of the frame), decode, the
+ * property NOTIFY that a gauge reacted to, and the scene graph sync and
+ * buffer swap of the first frame rendered after it. A gauge reports the
+ * NOTIFY itself, from the handler that repaints it:
+ *
+ *     function onSpeedChanged() {
+ *         speedometerCanvas.requestPaint()
+ *         latencyTracer.markChanged("VehicleSpeed")
+ *     }
+ *
+ * Receive and decode times come from the source (a VehicleDataController
+ * or VehicleDataProxy, through its receivedAtNs(QString)/decodedAtNs(QString)
+ * invokables), which only stamps decodes of signals asked for with
+ * traceLatency(QString). Sync and swap come from the window's
+ * afterSynchronizing() and frameSwapped(), on the render thread.
+ *
+ * A change replaced by another before any frame showed it counts as
+ * superseded; only the value that was rendered is measured.
+ */
+class LatencyTracer : public QObject
+{
+    Q_OBJECT
+    // Per traced signal: name, samples, superseded, and per stage its
+    // p50/p99/max/mean in microseconds
+    Q_PROPERTY(QVariantList statistics READ statistics NOTIFY updated)
+
+public:
+    enum Stage {
+        ReceiveToDecode,
+        DecodeToNotify,
+        NotifyToSync,
+        SyncToSwap,
+        ReceiveToSwap,      // End to end
+        StageCount
+    };
+    Q_ENUM(Stage)
+
+    explicit LatencyTracer(QObject *parent = nullptr);
+    ~LatencyTracer() override;
+
+    void setSource(QObject *source);
+    // Stamps sync and swap of @p window; it must outlive this tracer's use
+    void attachWindow(QQuickWindow *window);
+
+    // Called by a gauge when it takes a new value of @p signalName
+    Q_INVOKABLE void markChanged(const QString &signalName);
+    QVariantList statistics() const;
+    Q_INVOKABLE void reset();
+
+    // Prometheus text format: a summary per signal and stage
+    QByteArray toPrometheus() const;
+    Q_INVOKABLE bool writeReport(const QString &path) const;
+
+    static QString stageName(Stage stage);
+
+signals:
+    // At most once a second while samples come in
+    void updated();
+
+private slots:
+    void emitUpdated();
+
+private:
+    struct Stamps
+    {
+        qint64 receivedNs = 0;
+        qint64 decodedNs = 0;
+        qint64 notifiedNs = 0;      // 0: nothing pending
+        qint64 synchronizedNs = 0;
+    };
+
+    struct Trace
+    {
+        QString name;
+        Stamps pending;             // Notified, waiting for a sync
+        LatencyHistogram stages[StageCount];
+        quint64 superseded = 0;
+    };
+
+    // Render thread, with a direct connection
+    void handleAfterSynchronizing();
+    void handleFrameSwapped();
+    void recordLocked(Trace &trace, const Stamps &stamps, qint64 swappedNs);
+
+    QPointer<QObject> m_source;
+    QString m_reportPath;           // VEHICLESYS_LATENCY_REPORT, written on destruction
+
+    mutable QMutex m_mutex;         // GUI and render thread, a few times per frame
+    QHash<QString, int> m_traceIndex;
+    QVector<Trace> m_traces;
+    QVector<int> m_pendingTraces;   // Indices with pending.notifiedNs set
+    QVector<QPair<int, Stamps>> m_inFlight;  // Synchronized, waiting for the swap
+    bool m_recorded;
+
+    QTimer *m_updateTimer;
+};
+
+#endif // LATENCYTRACER_H
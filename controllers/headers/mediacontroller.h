@@ -7,6 +7,12 @@
 #include <QDir>
 #include <QTimer>
 
+#include "musicscanner.h"
+#include "musicsearch.h"
+#include "musicwatcher.h"
+#include "playlistmodel.h"
+#include "searchresultsmodel.h"
+
 #ifdef HAVE_QT_MULTIMEDIA
 #include <QMediaPlayer>
 #include <QMediaPlaylist>
@@ -21,10 +27,12 @@ class MediaController : public QObject
     Q_PROPERTY(qint64 currentTime READ currentTime NOTIFY currentTimeChanged)
     Q_PROPERTY(qint64 totalTime READ totalTime NOTIFY totalTimeChanged)
     Q_PROPERTY(int volume READ volume WRITE setVolume NOTIFY volumeChanged)
-    Q_PROPERTY(QStringList playlist READ playlist NOTIFY playlistChanged)
+    Q_PROPERTY(PlaylistModel *playlist READ playlistModel CONSTANT)
+    Q_PROPERTY(SearchResultsModel *search READ searchModel CONSTANT)
     Q_PROPERTY(int currentIndex READ currentIndex NOTIFY currentIndexChanged)
     Q_PROPERTY(bool shuffle READ shuffle WRITE setShuffle NOTIFY shuffleChanged)
     Q_PROPERTY(bool repeat READ repeat WRITE setRepeat NOTIFY repeatChanged)
+    Q_PROPERTY(bool scanning READ scanning NOTIFY scanningChanged)
 
 public:
     explicit MediaController(QObject *parent = nullptr);
@@ -37,10 +45,12 @@ public:
     qint64 currentTime() const;
     qint64 totalTime() const;
     int volume() const;
-    QStringList playlist() const;
+    PlaylistModel *playlistModel() const { return m_playlistModel; }
+    SearchResultsModel *searchModel() const { return m_searchModel; }
     int currentIndex() const;
     bool shuffle() const;
     bool repeat() const;
+    bool scanning() const;
 
 public slots:
     // Media control
@@ -51,12 +61,19 @@ public slots:
     void next();
     void previous();
     
-    // Playlist management
+    // Playlist management. The directory is scanned on a worker thread;
+    // tracks are appended in batches as they are found, and files added to
+    // or removed from it later are added and removed as they change
     void loadMusicDirectory(const QString &path = "");
+    void cancelScan();
+    // Appended once the scanner thread has read its tags
     void addFile(const QString &filePath);
     void removeFile(int index);
+    void moveTrack(int from, int to);
     void clearPlaylist();
     void playTrack(int index);
+    // Plays the listed track at @p filePath, e.g. a search result
+    void playFile(const QString &filePath);
     
     // Settings
     void setVolume(int volume);
@@ -71,10 +88,10 @@ signals:
     void currentTimeChanged(qint64 currentTime);
     void totalTimeChanged(qint64 totalTime);
     void volumeChanged(int volume);
-    void playlistChanged();
     void currentIndexChanged(int index);
     void shuffleChanged(bool shuffle);
     void repeatChanged(bool repeat);
+    void scanningChanged(bool scanning);
     void mediaError(const QString &error);
 
 private slots:
@@ -88,13 +105,16 @@ private slots:
 #endif
     void updateCurrentTime();
     void simulatePlayback();
+    void handleFilesFound(int scanId, const QStringList &paths, const QVector<MediaTags> &tags);
+    void handleScanFinished(int scanId, int fileCount, bool cancelled);
+    void handleFilesChanged(int scanId, const QStringList &paths, const QVector<MediaTags> &tags);
+    void handleFilesRemoved(int scanId, const QStringList &files, const QStringList &directories);
 
 private:
-    void extractMetadata(const QString &filePath);
-    QString getFileTitle(const QString &filePath);
-    QString getFileArtist(const QString &filePath);
-    QStringList getSupportedAudioFiles(const QDir &dir);
+    void extractMetadata(int index);
     void loadCurrentTrack();
+    void appendTracks(const QStringList &paths, const QVector<MediaTags> &tags);
+    void removeTracks(int first, int count);
     
 #ifdef HAVE_QT_MULTIMEDIA
     QMediaPlayer *m_player;
@@ -102,6 +122,10 @@ private:
 #endif
     QTimer *m_positionTimer;
     QTimer *m_simulationTimer;
+    MusicScanner *m_scanner;
+    MusicWatcher *m_watcher;
+    QString m_scanPath;
+    bool m_scanning;
     
     // Current track info
     QString m_currentTitle;
@@ -115,8 +139,11 @@ private:
     bool m_repeat;
     bool m_isPlaying;
     
-    // File list for playlist display
-    QStringList m_playlistFiles;
+    // Mirrors the playback order for display
+    PlaylistModel *m_playlistModel;
+    // Indexes what the playlist shows, for the search model
+    MusicSearch *m_search;
+    SearchResultsModel *m_searchModel;
     int m_currentIndex;
     
     // Supported audio formats
@@ -0,0 +1,60 @@
+#ifndef MEDIAINDEX_H
+#define MEDIAINDEX_H
+
+#include <QHash>
+#include <QString>
+
+#include "tagreader.h"
+
+/**
+ * @brief Tags of previously scanned files, kept on disk between runs.
+ *
+ * Entries are keyed by path and remember the size and modification time the
+ * tags were read at, so a rescan only parses files that are new or changed.
+ * Each scan marks the entries it looks up or inserts; prune() then drops
+ * those under the scanned root that were not seen, i.e. deleted files.
+ *
+ * Not thread-safe: the music scanner uses it from its own thread only.
+ */
+class MediaIndex
+{
+public:
+    MediaIndex();
+
+    // VEHICLESYS_MEDIA_INDEX, else "media-index" in the cache directory
+    static QString defaultPath();
+
+    // A missing, foreign or older-version file leaves the index empty
+    bool load(const QString &path);
+    bool save(const QString &path);
+    bool isDirty() const { return m_dirty; }
+    int count() const { return m_entries.size(); }
+
+    // Starts marking entries as seen
+    void beginScan();
+    // True and the stored tags if @p path is indexed with this size and time
+    bool lookup(const QString &path, qint64 size, qint64 modifiedMs, MediaTags *tags);
+    void insert(const QString &path, qint64 size, qint64 modifiedMs, const MediaTags &tags);
+    // Drops entries under @p root not seen since beginScan()
+    void prune(const QString &root);
+    void remove(const QString &path);
+    void removeUnder(const QString &directory);
+
+private:
+    template<typename Predicate>
+    void removeIf(const QString &directory, Predicate predicate);
+
+    struct Entry
+    {
+        qint64 size = 0;
+        qint64 modifiedMs = 0;
+        MediaTags tags;
+        quint32 seenInScan = 0;
+    };
+
+    QHash<QString, Entry> m_entries;
+    quint32 m_scan;
+    bool m_dirty;
+};
+
+#endif // MEDIAINDEX_H
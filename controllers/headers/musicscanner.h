@@ -0,0 +1,100 @@
+#ifndef MUSICSCANNER_H
+#define MUSICSCANNER_H
+
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+
+#include "mediaindex.h"
+#include "musicwatcher.h"
+
+/**
+ * @brief Walks a music directory tree on its own thread.
+ *
+ * Matching files are sent in batches while the walk goes on: the first as
+ * soon as the first directory with music has been listed, then every
+ * BatchSize files or BatchInterval, whichever comes first. Directories are
+ * visited depth first and both files and subdirectories in name order, so
+ * the overall order is stable. Symbolic links to directories are not
+ * followed.
+ *
+ * Each file comes with its tags. They are taken from the MediaIndex when the
+ * file's size and modification time match what was indexed, and otherwise
+ * read with TagReader, the misses of a batch in parallel on all cores. The
+ * index is loaded on the first scan and saved after every scan that changed
+ * it; a completed scan also forgets files that have gone from the tree.
+ *
+ * With a MusicWatcher set, every directory walked is watched, and update()
+ * applies the watcher's changes on the scanner thread, after the walk if
+ * one is running: removals go out as filesRemoved(), new and rewritten
+ * files (and those in new directories) as filesChanged(), in the same
+ * batches as a walk, and the index follows both.
+ *
+ * Every scan gets a new id, carried by its signals; batches of a scan that
+ * was cancelled or replaced can still be queued at the receiver, which
+ * drops those whose id is no longer current.
+ */
+class MusicScanner : public QThread
+{
+    Q_OBJECT
+
+public:
+    static constexpr int BatchSize = 128;
+    static constexpr int BatchIntervalMs = 100;
+
+    explicit MusicScanner(QObject *parent = nullptr);
+    ~MusicScanner() override;
+
+    // Cancels any scan in progress and starts one of @p root; returns its id
+    int scan(const QString &root, const QStringList &nameFilters);
+    // Cancels the scan in progress and waits for the thread
+    void stop();
+    int scanId() const { return m_scanId; }
+
+    // Set before the first scan; must outlive the scanner's thread
+    void setWatcher(MusicWatcher *watcher) { m_watcher = watcher; }
+    // Queues changes under the current root; dropped by the next scan()
+    void update(const MusicChanges &changes);
+
+signals:
+    // @p tags holds one entry per path
+    void filesFound(int scanId, const QStringList &paths, const QVector<MediaTags> &tags);
+    void scanFinished(int scanId, int fileCount, bool cancelled);
+    // Files that may already be listed, with their current tags
+    void filesChanged(int scanId, const QStringList &paths, const QVector<MediaTags> &tags);
+    // @p directories stand for every file below them
+    void filesRemoved(int scanId, const QStringList &files, const QStringList &directories);
+
+protected:
+    void run() override;
+
+private:
+    class Batch;
+
+    void walk(const QString &root, Batch *batch);
+    void applyChanges(int scanId, const MusicChanges &changes);
+    // Fills the @p rows of @p tags from the files at the same rows of @p paths
+    void readTags(const QStringList &paths, const QVector<int> &rows, QVector<MediaTags> *tags);
+
+    MediaIndex m_index;
+    QString m_indexPath;
+    bool m_indexLoaded;
+    QThreadPool m_tagReaders;
+    QString m_root;
+    QStringList m_nameFilters;
+    int m_scanId;
+    bool m_walkRequested;
+    std::atomic<bool> m_stopRequested;
+    MusicWatcher *m_watcher;
+
+    // Guards the queue and whether the thread is idle, i.e. about to return
+    QMutex m_mutex;
+    QVector<MusicChanges> m_pendingChanges;
+    bool m_idle;
+};
+
+#endif // MUSICSCANNER_H
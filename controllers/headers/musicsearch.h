@@ -0,0 +1,74 @@
+#ifndef MUSICSEARCH_H
+#define MUSICSEARCH_H
+
+#include <QMutex>
+#include <QThread>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+
+#include "musicsearchindex.h"
+
+/**
+ * @brief Keeps a MusicSearchIndex on its own thread and runs queries there.
+ *
+ * Changes to the library and queries are queued from the GUI thread; the
+ * worker applies the changes in order, then runs the latest query. A new
+ * query cancels one still running and replaces one not yet started, so
+ * typing never queues up stale work. When the library changes, the
+ * current query runs again, at most every RefreshIntervalMs, and its
+ * results are sent again under the same id, so they follow the scan as it
+ * goes.
+ */
+class MusicSearch : public QThread
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultLimit = 50;
+    static constexpr int RefreshIntervalMs = 500;
+
+    explicit MusicSearch(QObject *parent = nullptr);
+    ~MusicSearch() override;
+
+    // @p tags holds one entry per path; known paths are replaced
+    void add(const QStringList &paths, const QVector<MediaTags> &tags);
+    void remove(const QStringList &paths);
+    void clear();
+
+    // Results arrive with resultsReady(); an empty @p text ends the query
+    int query(const QString &text, int limit = DefaultLimit);
+    void stop();
+
+signals:
+    void resultsReady(int queryId, const QVector<SearchResult> &results);
+
+protected:
+    void run() override;
+
+private:
+    struct Change
+    {
+        enum Kind { Add, Remove, Clear } kind;
+        QStringList paths;
+        QVector<MediaTags> tags;
+    };
+
+    void enqueue(const Change &change);
+
+    MusicSearchIndex m_index;   // Worker thread only
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QVector<Change> m_changes;
+    QString m_query;
+    int m_queryLimit;
+    int m_queryId;
+    bool m_queryPending;
+    bool m_stopRequested;
+    std::atomic<bool> m_cancelQuery;
+};
+
+#endif // MUSICSEARCH_H
@@ -0,0 +1,102 @@
+#ifndef MUSICSEARCHINDEX_H
+#define MUSICSEARCHINDEX_H
+
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+
+#include "tagreader.h"
+
+struct SearchResult
+{
+    QString path;
+    MediaTags tags;
+    float score = 0.0f;
+};
+
+Q_DECLARE_METATYPE(SearchResult)
+
+/**
+ * @brief In-memory search over the title, artist and album of each track.
+ *
+ * Text is folded before indexing and before searching: decomposed, stripped
+ * of accents, case-folded, and split into words at anything that is not a
+ * letter or digit, so "Beyoncé" is found as "beyonce". Every word goes into
+ * a prefix trie pointing at the tracks that contain it, and its trigrams
+ * into a trigram table.
+ *
+ * A query matches the tracks that have every query word as a word prefix,
+ * in any field. Title matches rank above artist matches, which rank above
+ * album matches; a whole-word match counts double. When fewer tracks than
+ * asked for match that way, the rest are filled with fuzzy matches: tracks
+ * sharing at least half of the query's trigrams, which tolerates typos.
+ *
+ * Tracks are added and removed one at a time, keyed by path. Removed tracks
+ * are skipped until they make up half the index, then it is rebuilt.
+ * Not thread-safe; MusicSearch owns one on its worker thread.
+ */
+class MusicSearchIndex
+{
+public:
+    MusicSearchIndex();
+
+    static QString fold(const QString &text);
+
+    // Replaces the track at @p path if it is already indexed
+    void add(const QString &path, const MediaTags &tags);
+    void remove(const QString &path);
+    void clear();
+    int count() const { return m_docByPath.size(); }
+
+    // At most @p limit results, best first; empty once @p cancelled is set
+    QVector<SearchResult> search(const QString &query, int limit, const std::atomic<bool> *cancelled) const;
+
+private:
+    enum Field : quint8 {
+        TitleField,
+        ArtistField,
+        AlbumField
+    };
+
+    struct Posting
+    {
+        int doc;
+        Field field;
+    };
+
+    // Children are a singly linked list; the root is node 0
+    struct TrieNode
+    {
+        QChar ch;
+        int firstChild = -1;
+        int nextSibling = -1;
+        int word = -1;
+    };
+
+    struct Doc
+    {
+        QString path;
+        MediaTags tags;
+        bool alive = true;
+    };
+
+    static quint64 trigram(const QChar *p);
+
+    void indexField(int doc, Field field, const QString &text);
+    int wordId(const QString &word);
+    int findNode(const QString &prefix) const;
+    void rebuild();
+
+    QVector<Doc> m_docs;
+    QHash<QString, int> m_docByPath;
+    int m_dead;
+
+    QVector<TrieNode> m_nodes;
+    QVector<QVector<Posting>> m_postings;   // By word id
+    QHash<quint64, QVector<int>> m_trigrams;
+};
+
+#endif // MUSICSEARCHINDEX_H
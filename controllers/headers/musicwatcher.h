@@ -0,0 +1,89 @@
+#ifndef MUSICWATCHER_H
+#define MUSICWATCHER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QTimer>
+
+class QSocketNotifier;
+
+// What changed under a watched tree since the last report. Each path is in
+// at most one list; directories stand for everything below them
+struct MusicChanges
+{
+    QStringList files;                  // Written, or moved in
+    QStringList removedFiles;           // Deleted, or moved out
+    QStringList directories;            // Created or moved in; contents unknown
+    QStringList removedDirectories;     // Deleted or moved out
+
+    bool isEmpty() const
+    {
+        return files.isEmpty() && removedFiles.isEmpty()
+                && directories.isEmpty() && removedDirectories.isEmpty();
+    }
+};
+
+/**
+ * @brief Reports music files appearing in and vanishing from a tree.
+ *
+ * One inotify instance with a watch per directory. Directories are added
+ * with watchDirectory(), which the music scanner calls for each directory
+ * it walks, before listing it, from its own thread; events are read on the
+ * watcher's thread. Events are coalesced until none has arrived for QuietMs,
+ * keeping only the last state of each path, so copying an album arrives as
+ * one change rather than one per file; a steady stream of events is still
+ * reported every MaxLatencyMs. A file counts as added once it is closed
+ * after writing, not when it is created.
+ *
+ * A rename is reported as a removal and an addition. When the kernel queue
+ * overflows, events have been lost and overflowed() asks for a full scan.
+ */
+class MusicWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int QuietMs = 250;
+    static constexpr int MaxLatencyMs = 2000;
+
+    explicit MusicWatcher(QObject *parent = nullptr);
+    ~MusicWatcher() override;
+
+    bool isValid() const { return m_fd >= 0; }
+    // Drops every watch and pending change; reported files match @p nameFilters
+    void reset(const QString &root, const QStringList &nameFilters);
+    // Thread-safe
+    void watchDirectory(const QString &path);
+
+signals:
+    void changed(const MusicChanges &changes);
+    void overflowed();
+
+private slots:
+    void readEvents();
+    void flush();
+
+private:
+    // m_mutex held
+    void unwatchTree(const QString &path);
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    QTimer m_coalesceTimer;
+    QElapsedTimer m_pendingSince;       // Since the oldest change not yet reported
+    QString m_root;
+    QStringList m_nameFilters;
+
+    QMutex m_mutex;
+    QHash<int, QString> m_directories;  // By watch descriptor
+    bool m_warnedLimit;
+
+    // Whether each path exists, as of its last event
+    QHash<QString, bool> m_files;
+    QHash<QString, bool> m_pendingDirectories;
+};
+
+#endif // MUSICWATCHER_H
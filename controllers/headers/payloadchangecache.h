@@ -0,0 +1,130 @@
+#ifndef PAYLOADCHANGECACHE_H
+#define PAYLOADCHANGECACHE_H
+
+#include <QtGlobal>
+#include <QVector>
+#include <QtAlgorithms>
+#include <cstring>
+
+#include "candecodetable.h"
+#include "canframe.h"
+
+/**
+ * @brief Last payload of every DBC message, compared before decoding.
+ *
+ * Cyclic messages mostly repeat byte for byte. Each frame is compared with
+ * the previous one of its message a 64-bit word at a time (one compare for
+ * a classic frame); the bytes that differ are turned into the signals that
+ * read them through a byte -> signals map built from the decode table, and
+ * only those are decoded. Entries are indexed like CanDecodeTable::messages().
+ */
+class PayloadChangeCache
+{
+public:
+    struct Stats
+    {
+        quint64 frames = 0;
+        quint64 unchanged = 0;          // Frames with no wanted signal to decode
+        quint64 signalsDecoded = 0;
+        quint64 signalsSkipped = 0;     // Wanted, but their bytes were unchanged
+    };
+
+    void rebuild(const CanDecodeTable &table);
+    // The next frame of every message is decoded in full
+    void invalidate();
+
+    /**
+     * @brief Remembers @p payload and returns the wanted signals it changed.
+     * @param wanted Signals of the message to consider, by position (see
+     * CanDecodeTable::decode()).
+     * @return The subset of @p wanted whose bytes differ from the previous
+     * frame; all of them for the first frame or a new length, 0 if none.
+     */
+    quint64 select(int messageIndex, const quint8 *payload, int length, quint64 wanted);
+
+    int messageCount() const { return m_entries.size(); }
+    quint32 frameId(int messageIndex) const { return m_entries[messageIndex].frameId; }
+    const Stats &stats(int messageIndex) const { return m_entries[messageIndex].stats; }
+    void resetStats();
+
+private:
+    static constexpr int Words = CanFrame::MaxPayload / 8;
+
+    struct Entry
+    {
+        quint64 payload[Words];
+        quint64 byteSignals[CanFrame::MaxPayload];   // Byte -> signals reading it
+        quint64 signalMask;                           // Every signal of the message
+        Stats stats;
+        quint32 frameId;
+        int length;     // -1 until the first frame
+    };
+
+    // Index of the payload byte behind bit @p bit of a word loaded with memcpy
+    static int byteOfBit(int bit)
+    {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        return bit >> 3;
+#else
+        return 7 - (bit >> 3);
+#endif
+    }
+    // Word mask covering the first @p bytes payload bytes of a word
+    static quint64 leadingBytes(int bytes)
+    {
+        if (bytes >= 8) {
+            return ~quint64(0);
+        }
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        return (quint64(1) << (bytes * 8)) - 1;
+#else
+        return ~quint64(0) << ((8 - bytes) * 8);
+#endif
+    }
+
+    QVector<Entry> m_entries;
+};
+
+inline quint64 PayloadChangeCache::select(int messageIndex, const quint8 *payload, int length, quint64 wanted)
+{
+    Entry &entry = m_entries[messageIndex];
+    ++entry.stats.frames;
+    wanted &= entry.signalMask;
+
+    quint64 changed = 0;
+    if (Q_UNLIKELY(entry.length != length)) {
+        // First frame, or the sender changed the length: nothing to compare with
+        std::memset(entry.payload, 0, sizeof(entry.payload));
+        std::memcpy(entry.payload, payload, length);
+        entry.length = length;
+        changed = wanted;
+    } else {
+        // Bytes past the length are not part of the frame; mask them out
+        for (int word = 0; word * 8 < length; ++word) {
+            quint64 current;
+            std::memcpy(&current, payload + word * 8, sizeof(current));
+            current &= leadingBytes(length - word * 8);
+            quint64 diff = current ^ entry.payload[word];
+            if (diff == 0) {
+                continue;
+            }
+            entry.payload[word] = current;
+            while (diff) {
+                const int bit = static_cast<int>(qCountTrailingZeroBits(diff));
+                diff &= ~(quint64(0xFF) << (bit & ~7));
+                changed |= entry.byteSignals[word * 8 + byteOfBit(bit)];
+            }
+        }
+        changed &= wanted;
+    }
+
+    const int decoded = qPopulationCount(changed);
+    entry.stats.signalsDecoded += decoded;
+    entry.stats.signalsSkipped += qPopulationCount(wanted) - decoded;
+    if (!changed) {
+        ++entry.stats.unchanged;
+    }
+    return changed;
+}
+
+#endif // PAYLOADCHANGECACHE_H
@@ -0,0 +1,90 @@
+#ifndef PLAYLISTMODEL_H
+#define PLAYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+#include "tagreader.h"
+
+/**
+ * @brief The playlist as a QML list model, one row per track.
+ *
+ * Rows are added a batch at a time with one beginInsertRows(), and removed
+ * and moved individually, so a view only creates delegates for what is
+ * visible and never rebuilds the rest. Tracks come with the tags the music
+ * scanner read; a title or artist the tags lack is parsed from the file
+ * name ("Artist - Title") the first time a view asks for it, and
+ * setMetadata() and setDuration() fill in what playback learns later.
+ *
+ * The model only mirrors the playlist: MediaController owns the playback
+ * order and is the one to change it, so the model is read-only from QML.
+ */
+class PlaylistModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        TitleRole = Qt::UserRole + 1,
+        ArtistRole,
+        AlbumRole,
+        DurationRole,
+        PathRole
+    };
+    Q_ENUM(Role)
+
+    explicit PlaylistModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Every role of one row, keyed by role name
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+    QString path(int row) const;
+    QString title(int row) const;
+    QString artist(int row) const;
+    qint64 duration(int row) const;
+
+    void append(const QStringList &paths);
+    // @p tags holds one entry per path
+    void append(const QStringList &paths, const QVector<MediaTags> &tags);
+    void remove(int row, int count = 1);
+    // @p to is the row the track ends up at
+    bool move(int from, int to);
+    void clear();
+
+    // Tag metadata, replacing what the file name suggested; empty strings
+    // keep the current value
+    void setMetadata(int row, const QString &title, const QString &artist, const QString &album);
+    void setDuration(int row, qint64 durationMs);
+
+    // "Artist - Title" file names; the whole base name is the title otherwise
+    static QString titleFromFileName(const QString &path);
+    static QString artistFromFileName(const QString &path);
+
+signals:
+    void countChanged();
+
+private:
+    struct Track
+    {
+        QString path;
+        // Filled from the file name on first use if the tags had none
+        mutable QString title;
+        mutable QString artist;
+        QString album;
+        qint64 durationMs = 0;
+        mutable bool named = false;
+    };
+
+    const Track &named(int row) const;
+
+    QVector<Track> m_tracks;
+};
+
+#endif // PLAYLISTMODEL_H
@@ -0,0 +1,66 @@
+#ifndef SEARCHRESULTSMODEL_H
+#define SEARCHRESULTSMODEL_H
+
+#include <QAbstractListModel>
+#include <QVariantMap>
+#include <QVector>
+
+#include "musicsearchindex.h"
+
+class MusicSearch;
+
+/**
+ * @brief The results of an as-you-type library search, as a QML list model.
+ *
+ * Setting query sends it to MusicSearch and returns at once; the rows are
+ * replaced when the results arrive. If the library changes while the query
+ * stands, its new results are applied in place, as row insertions,
+ * removals and moves. Results of a query that has since been superseded
+ * are dropped. An empty query leaves the model empty.
+ */
+class SearchResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        TitleRole = Qt::UserRole + 1,
+        ArtistRole,
+        AlbumRole,
+        DurationRole,
+        PathRole
+    };
+    Q_ENUM(Role)
+
+    explicit SearchResultsModel(MusicSearch *search, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Every role of one row, keyed by role name
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+    QString query() const { return m_query; }
+    void setQuery(const QString &query);
+
+signals:
+    void queryChanged(const QString &query);
+    void countChanged();
+
+private slots:
+    void handleResults(int queryId, const QVector<SearchResult> &results);
+
+private:
+    void updateResults(const QVector<SearchResult> &results);
+
+    MusicSearch *m_search;
+    QString m_query;
+    int m_queryId;
+    int m_resultsQueryId;   // The query m_results answer
+    QVector<SearchResult> m_results;
+};
+
+#endif // SEARCHRESULTSMODEL_H
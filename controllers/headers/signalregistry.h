@@ -0,0 +1,165 @@
+#ifndef SIGNALREGISTRY_H
+#define SIGNALREGISTRY_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+class DbcDatabase;
+
+/**
+ * @brief Latest value of every signal in the loaded DBC.
+ *
+ * Signal IDs are positions in DBC order, the same indices CanDecodeTable
+ * uses, so a decoded value is stored without any lookup. Values,
+ * timestamps and generation counters live in separate arrays; metadata is
+ * kept apart and never touched per frame. Changed values and staleness
+ * are tracked in a bitmap until the next takeChanges(), so a consumer
+ * publishes in batches.
+ */
+class SignalRegistry
+{
+public:
+    struct SignalInfo
+    {
+        QString name;
+        QString message;
+        QString unit;
+        double minimum;     // Both 0 when the DBC gives no range
+        double maximum;
+        double factor;
+        double offset;
+        quint32 frameId;
+        bool extendedFrame;
+    };
+
+    void rebuild(const DbcDatabase &database);
+
+    int count() const { return m_values.size(); }
+    // "Signal" or "Message.Signal"; -1 when unknown
+    int indexOf(const QString &name) const { return m_indexByName.value(name, -1); }
+    const SignalInfo &info(int id) const { return m_info[id]; }
+
+    double value(int id) const { return m_values[id]; }
+    // Receive time of the last decoded sample. Frames that repeat the
+    // signal's bytes are not decoded, so neither this nor the generation
+    // advances for them
+    qint64 timestampNs(int id) const { return m_timestamps[id]; }
+    // Samples stored since the DBC was loaded, changed or not
+    quint32 generation(int id) const { return m_generations[id]; }
+    // Set while the signal's message is overdue; the value is the last one received
+    bool isStale(int id) const { return m_stale[id]; }
+
+    /**
+     * @brief Stores a decoded sample.
+     * @return True if the value differs from the previous one.
+     */
+    bool update(int id, double value, qint64 timestampNs);
+
+    /**
+     * @brief Stores a sample taken from another registry of the same DBC.
+     * @return True if the value differs from the previous one.
+     */
+    bool assign(int id, double value, qint64 timestampNs, quint32 generation);
+
+    // Marks a signal stale or fresh; true if that changed its state
+    bool setStale(int id, bool stale);
+
+    // Whole columns, indexed by signal ID
+    const QVector<double> &values() const { return m_values; }
+    const QVector<qint64> &timestamps() const { return m_timestamps; }
+    const QVector<quint32> &generations() const { return m_generations; }
+    const QVector<bool> &staleFlags() const { return m_stale; }
+
+    bool hasChanges() const { return m_changeCount > 0; }
+    // Calls visit(firstId, lastId) for each run of changed IDs, then clears them
+    template<typename Visit>
+    void takeChanges(Visit &&visit);
+
+private:
+    void markChanged(int id);
+
+    QVector<double> m_values;
+    QVector<qint64> m_timestamps;
+    QVector<quint32> m_generations;
+    QVector<bool> m_stale;
+    QVector<quint64> m_changed;     // One bit per signal
+    int m_changeCount = 0;          // Words of m_changed with a bit set
+
+    QVector<SignalInfo> m_info;
+    QHash<QString, int> m_indexByName;
+};
+
+inline bool SignalRegistry::update(int id, double value, qint64 timestampNs)
+{
+    return assign(id, value, timestampNs, m_generations[id] + 1);
+}
+
+inline bool SignalRegistry::assign(int id, double value, qint64 timestampNs, quint32 generation)
+{
+    m_timestamps[id] = timestampNs;
+    m_generations[id] = generation;
+    if (m_values[id] == value) {
+        return false;
+    }
+
+    m_values[id] = value;
+    markChanged(id);
+    return true;
+}
+
+inline bool SignalRegistry::setStale(int id, bool stale)
+{
+    if (m_stale[id] == stale) {
+        return false;
+    }
+
+    m_stale[id] = stale;
+    markChanged(id);
+    return true;
+}
+
+inline void SignalRegistry::markChanged(int id)
+{
+    quint64 &word = m_changed[id >> 6];
+    if (word == 0) {
+        ++m_changeCount;
+    }
+    word |= quint64(1) << (id & 63);
+}
+
+template<typename Visit>
+inline void SignalRegistry::takeChanges(Visit &&visit)
+{
+    if (m_changeCount == 0) {
+        return;
+    }
+
+    int runStart = -1;
+    for (int wordIndex = 0; wordIndex < m_changed.size(); ++wordIndex) {
+        quint64 word = m_changed[wordIndex];
+        m_changed[wordIndex] = 0;
+        for (int bit = 0; bit < 64; ++bit) {
+            const int id = wordIndex * 64 + bit;
+            if (word == 0 && runStart < 0) {
+                break; // Rest of the word is clean
+            }
+            if (word & 1) {
+                if (runStart < 0) {
+                    runStart = id;
+                }
+            } else if (runStart >= 0) {
+                visit(runStart, id - 1);
+                runStart = -1;
+            }
+            word >>= 1;
+        }
+    }
+    if (runStart >= 0) {
+        visit(runStart, count() - 1);
+    }
+    m_changeCount = 0;
+}
+
+#endif // SIGNALREGISTRY_H
@@ -0,0 +1,71 @@
+#ifndef SIGNALSUBSCRIPTION_H
+#define SIGNALSUBSCRIPTION_H
+
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+
+/**
+ * @brief Declares from QML which vehicle signals a component displays.
+ *
+ *     SignalSubscription {
+ *         source: vehicleData
+ *         signalNames: ["VehicleSpeed", "EngineSpeed"]
+ *         active: dashboard.visible
+ *     }
+ *
+ * Holds one subscription per name on the source while active, and drops
+ * them when deactivated or destroyed, so a hidden or unloaded screen stops
+ * costing decode time. The source is a VehicleDataController or a
+ * VehicleDataProxy; anything with subscribe(QString)/unsubscribe(QString)
+ * invokables works.
+ *
+ * stale is true while any of the signals is stale on the source (its
+ * isStale(QString) and stalenessChanged()), so a gauge can grey out:
+ *
+ *     opacity: speedSubscription.stale ? 0.4 : 1.0
+ */
+class SignalSubscription : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QObject *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QStringList signalNames READ signalNames WRITE setSignalNames NOTIFY signalNamesChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(bool stale READ stale NOTIFY staleChanged)
+
+public:
+    explicit SignalSubscription(QObject *parent = nullptr);
+    ~SignalSubscription() override;
+
+    QObject *source() const { return m_source; }
+    void setSource(QObject *source);
+
+    QStringList signalNames() const { return m_signalNames; }
+    void setSignalNames(const QStringList &signalNames);
+
+    bool active() const { return m_active; }
+    void setActive(bool active);
+
+    bool stale() const { return m_stale; }
+
+signals:
+    void sourceChanged();
+    void signalNamesChanged();
+    void activeChanged();
+    void staleChanged();
+
+private slots:
+    void updateStale();
+
+private:
+    void acquire();
+    void release();
+
+    QPointer<QObject> m_source;
+    QStringList m_signalNames;
+    QStringList m_held;     // Names currently subscribed on m_source
+    bool m_active;
+    bool m_stale;
+};
+
+#endif // SIGNALSUBSCRIPTION_H
@@ -0,0 +1,59 @@
+#ifndef SNAPSHOTBUFFER_H
+#define SNAPSHOTBUFFER_H
+
+#include <QtGlobal>
+#include <atomic>
+
+/**
+ * @brief Lock-free latest-value mailbox from one writer thread to one reader.
+ *
+ * Triple buffering: the writer fills its own slot and publishes it by
+ * swapping it with the shared middle slot; the reader swaps the middle slot
+ * for its own when it holds something newer. Each slot belongs to exactly
+ * one side at a time, so T may own memory, and neither side ever waits: a
+ * slow reader just skips to the newest snapshot, and the writer overwrites
+ * whatever the reader has not taken yet.
+ */
+template<typename T>
+class SnapshotBuffer
+{
+public:
+    // --- Writer side ---
+    // Contents are from an older snapshot; overwrite everything that matters
+    T &writeSlot() { return m_slots[m_back]; }
+    /**
+     * @brief Hands the write slot to the reader.
+     * @return True if the reader had taken the previous snapshot and must
+     * be told about this one.
+     */
+    bool publish()
+    {
+        const int previous = m_middle.exchange(m_back | Fresh, std::memory_order_acq_rel);
+        m_back = previous & IndexMask;
+        return !(previous & Fresh);
+    }
+
+    // --- Reader side ---
+    // Takes the newest snapshot, if one was published since the last call
+    bool consume()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & Fresh)) {
+            return false;
+        }
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+    // The snapshot taken by the last successful consume()
+    const T &readSlot() const { return m_slots[m_front]; }
+
+private:
+    static constexpr int IndexMask = 0x3;
+    static constexpr int Fresh = 0x4;
+
+    T m_slots[3];
+    int m_back = 0;                   // Writer only
+    alignas(64) std::atomic<int> m_middle{1};
+    alignas(64) int m_front = 2;      // Reader only
+};
+
+#endif // SNAPSHOTBUFFER_H
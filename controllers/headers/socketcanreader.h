@@ -0,0 +1,67 @@
+#ifndef SOCKETCANREADER_H
+#define SOCKETCANREADER_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <atomic>
+
+#include "canbusstatistics.h"
+
+class CanFrameRing;
+
+/**
+ * @brief Native SocketCAN backend reading a raw AF_CAN socket directly.
+ *
+ * Bypasses QtSerialBus: frames are read in batches with recvmmsg(), each
+ * one carrying its kernel receive timestamp from SO_TIMESTAMPING, and
+ * copied straight into the ingest ring without any per-frame allocation.
+ * Classic and FD frames share the socket (CAN_RAW_FD_FRAMES).
+ */
+class SocketCanReader : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SocketCanReader(CanFrameRing *ring, QObject *parent = nullptr);
+    ~SocketCanReader() override;
+
+    // Opens and binds the socket; call start() afterwards to begin reading
+    bool open(const QString &interface);
+    void close();
+    bool isOpen() const;
+    bool writeFrame(quint32 frameId, const QByteArray &data);
+    // Installs CAN_RAW_FILTER now if open, and on every later open()
+    void setFrameIdFilter(const QList<quint32> &frameIds);
+    QString errorString() const;
+    // Counters written from the reader thread; set while it is stopped
+    void setStatistics(CanBusStatistics::Shard *statistics) { m_statistics = statistics; }
+
+signals:
+    void framesPending();
+    // The read loop hit a socket error and has stopped
+    void readFailed(const QString &errorString);
+
+protected:
+    void run() override;
+
+private:
+    struct Buffers;
+
+    void applyFrameIdFilter();
+
+    // Frames requested per recvmmsg() call
+    static constexpr int BatchSize = 64;
+
+    CanFrameRing *m_ring;
+    CanBusStatistics::Shard *m_statistics;
+    Buffers *m_buffers;
+    int m_socket;
+    int m_wakeFd;
+    std::atomic<bool> m_stopRequested;
+    QList<quint32> m_frameIdFilter;
+    QString m_errorString;
+};
+
+#endif // SOCKETCANREADER_H
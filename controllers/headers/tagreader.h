@@ -0,0 +1,41 @@
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QMetaType>
+#include <QString>
+
+// What a track's tags say about it; empty fields are unknown
+struct MediaTags
+{
+    QString title;
+    QString artist;
+    QString album;
+    qint64 durationMs = 0;
+};
+
+Q_DECLARE_METATYPE(MediaTags)
+
+/**
+ * Native tag parsing for the formats the music scanner picks up.
+ *
+ *   MP3    ID3v2.2-2.4 text frames; duration from TLEN, else the Xing/Info
+ *          or VBRI frame count, else the first frame's bitrate
+ *   FLAC   Vorbis comments and STREAMINFO (an ID3v2 tag in front is skipped)
+ *   OGG    Vorbis or Opus comments; duration from the last page's granule
+ *   MP4    ilst atoms (M4A, AAC in MP4) and mvhd duration
+ *   WAV    duration from the fmt and data chunks
+ *
+ * Only the byte ranges holding headers are read, with pread(), even where
+ * the metadata sits at the end (MP4 moov, Ogg). Every length is
+ * bounds-checked against what was read, so a truncated or corrupt file,
+ * or one shrinking while it is read, yields partial or no tags, never a
+ * crash. Safe to call from any thread.
+ */
+namespace TagReader {
+
+// False if the file cannot be read or holds nothing recognized
+bool read(const QString &path, MediaTags *tags);
+
+} // namespace TagReader
+
+#endif // TAGREADER_H
@@ -0,0 +1,104 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * @brief Hierarchical timing wheel for a fixed set of timers, one per index.
+ *
+ * Four levels of 256 slots, one tick per slot on the first level, so a
+ * timer reaches 2^32 ticks ahead. Timers are nodes of intrusive lists kept
+ * in one array; scheduling, rescheduling and cancelling are O(1). An
+ * occupancy bitmap per level lets advance() jump straight to the next slot
+ * that holds timers, so its cost follows the number of timers due (plus
+ * the occasional cascade of a higher-level slot), not the time elapsed.
+ * There is no clock inside: the owner advances it with whatever time it
+ * observes.
+ */
+class TimingWheel
+{
+public:
+    // Clears every timer and sets the current tick
+    void reset(int timerCount, qint64 now);
+    int timerCount() const { return m_nodes.size(); }
+    qint64 now() const { return m_now; }
+    int scheduledCount() const { return m_scheduled; }
+
+    // (Re)arms @p timer; expiries not after now() fire on the next tick
+    void schedule(int timer, qint64 expiry);
+    void cancel(int timer);
+    bool isScheduled(int timer) const { return m_nodes[timer].slot >= 0; }
+
+    /**
+     * @brief Moves the wheel to @p now, calling expire(timer) for every
+     * timer due by then, in expiry order. Earlier times are ignored.
+     * A timer is disarmed before its callback, which may schedule timers again.
+     */
+    template<typename Expire>
+    void advance(qint64 now, Expire &&expire);
+
+private:
+    static constexpr int SlotBits = 8;
+    static constexpr int Slots = 1 << SlotBits;
+    static constexpr int Levels = 4;
+
+    struct Node
+    {
+        qint64 expiry;
+        int prev;
+        int next;
+        int slot;   // Level * Slots + index, -1 when not scheduled
+    };
+
+    // Files a timer by its expiry, which must not be before now()
+    void file(int timer);
+    void link(int timer, int slot);
+    void unlink(int timer);
+    // Re-files the timers of a higher-level slot now that it is next
+    void cascade(int level);
+    // First tick after now() at which a slot with timers is reached, or -1
+    qint64 nextEvent() const;
+    // Slots from @p index to the next occupied one on @p level (1..256), or 0
+    int distanceToOccupied(int level, int index) const;
+
+    QVector<Node> m_nodes;
+    QVector<int> m_heads;           // First timer per slot, -1 when empty
+    QVector<quint64> m_occupied;    // One bit per slot with timers
+    qint64 m_now = 0;
+    int m_scheduled = 0;
+};
+
+template<typename Expire>
+void TimingWheel::advance(qint64 now, Expire &&expire)
+{
+    while (m_now < now) {
+        // Empty slots in between need neither expiry nor cascade
+        const qint64 next = nextEvent();
+        if (next < 0 || next > now) {
+            m_now = now;
+            return;
+        }
+
+        m_now = next;
+        const int index = static_cast<int>(m_now & (Slots - 1));
+        if (index == 0) {
+            // Entering a new first-level cycle: bring down the next slot above
+            for (int level = 1; level < Levels; ++level) {
+                cascade(level);
+                if ((m_now >> (level * SlotBits)) & (Slots - 1)) {
+                    break;
+                }
+            }
+        }
+
+        // Rescheduled timers land in later slots, never this one
+        int timer;
+        while ((timer = m_heads[index]) >= 0) {
+            unlink(timer);
+            expire(timer);
+        }
+    }
+}
+
+#endif // TIMINGWHEEL_H
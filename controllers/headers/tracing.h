@@ -0,0 +1,80 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+/**
+ * Timeline zones for finding stalls, exported as Chrome trace JSON
+ * (chrome://tracing, ui.perfetto.dev).
+ *
+ *     void CanBusController::handleFramesReceived()
+ *     {
+ *         VEHICLESYS_TRACE_ZONE("CanBusController::handleFramesReceived");
+ *         ...
+ *     }
+ *
+ * Only built with -DVEHICLESYS_ENABLE_TRACING=ON, which defines
+ * VEHICLESYS_TRACING; otherwise the macro expands to an empty statement and
+ * nothing of this layer is compiled or linked.
+ *
+ * Each thread records finished zones into a ring of its own (the newest
+ * RingSize are kept), with one relaxed load and a release store per zone and
+ * no locks. Rings are registered on a thread's first zone and live until
+ * exit, so zones of finished threads can still be written out.
+ */
+
+#ifdef VEHICLESYS_TRACING
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+
+namespace Tracing {
+
+// Zones kept per thread
+constexpr int RingSize = 8192;
+
+// Monotonic clock the zones are stamped with, in nanoseconds
+qint64 now();
+
+// Records a zone that ran on the calling thread. @p name must outlive the
+// process (a string literal), since only the pointer is stored
+void complete(const char *name, qint64 beginNs, qint64 endNs);
+
+// Every ring, oldest zone first per thread, as Chrome trace JSON
+QByteArray chromeTrace();
+bool writeChromeTrace(const QString &path);
+
+// Writes the trace to @p path at exit and on every SIGUSR1; needs a
+// QCoreApplication
+void installDumpTriggers(const QString &path);
+
+class Zone
+{
+public:
+    explicit Zone(const char *name)
+        : m_name(name)
+        , m_beginNs(now())
+    {
+    }
+    ~Zone() { complete(m_name, m_beginNs, now()); }
+
+private:
+    Q_DISABLE_COPY(Zone)
+
+    const char *m_name;
+    qint64 m_beginNs;
+};
+
+} // namespace Tracing
+
+#define VEHICLESYS_TRACE_CONCAT_(a, b) a##b
+#define VEHICLESYS_TRACE_CONCAT(a, b) VEHICLESYS_TRACE_CONCAT_(a, b)
+#define VEHICLESYS_TRACE_ZONE(name) \
+    const Tracing::Zone VEHICLESYS_TRACE_CONCAT(traceZone, __LINE__)(name)
+
+#else
+
+#define VEHICLESYS_TRACE_ZONE(name) do { } while (false)
+
+#endif // VEHICLESYS_TRACING
+
+#endif // TRACING_H
@@ -4,6 +4,21 @@
 #include <QObject>
 #include <QString>
 #include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+#include <QVariant>
+#include <functional>
+
+#include "canbusstatistics.h"
+#include "candecodetable.h"
+#include "canframe.h"
+#include "payloadchangecache.h"
+#include "signalregistry.h"
+#include "snapshotbuffer.h"
+#include "timingwheel.h"
+#include "vehiclesignalmodel.h"
 
 class VehicleDataController : public QObject
 {
@@ -22,8 +37,55 @@ class VehicleDataController : public QObject
     Q_PROPERTY(bool engineRunning READ engineRunning NOTIFY engineRunningChanged)
     Q_PROPERTY(bool seatbelt READ seatbelt NOTIFY seatbeltChanged)
     Q_PROPERTY(bool doorOpen READ doorOpen NOTIFY doorOpenChanged)
+    Q_PROPERTY(PublishMode publishMode READ publishMode WRITE setPublishMode NOTIFY publishModeChanged)
+    // Every signal of the loaded DBC, with its metadata, for generic gauges
+    Q_PROPERTY(VehicleSignalModel *signalModel READ signalModel CONSTANT)
+    // Signals whose message is overdue, e.g. because its ECU left the bus
+    Q_PROPERTY(int staleSignalCount READ staleSignalCount NOTIFY stalenessChanged)
 
 public:
+    // When property changes reach QML
+    enum PublishMode {
+        ImmediatePublish,   // NOTIFY on every change, at bus rate
+        FramePublish,       // Collected, then published once per rendered frame
+        SnapshotPublish     // Written to snapshots() for a VehicleDataProxy on another thread
+    };
+    Q_ENUM(PublishMode)
+
+    // Everything QML reads, as of one publish; see VehicleDataProxy
+    struct Snapshot
+    {
+        enum Warning : quint8 {
+            LowFuel         = 0x01,
+            EngineOverheat  = 0x02,
+            BatteryLow      = 0x04
+        };
+
+        int speed = 0;
+        int rpm = 0;
+        int fuelLevel = 0;
+        int engineTemperature = 0;
+        int batteryVoltage = 0;
+        double odometer = 0.0;
+        QString gear;
+        bool leftTurnSignal = false;
+        bool rightTurnSignal = false;
+        bool headlights = false;
+        bool parkingBrake = false;
+        bool engineRunning = false;
+        bool seatbelt = false;
+        bool doorOpen = false;
+        quint8 warnings = 0;            // Warning conditions met by these values
+
+        // Signal registry columns, by signal ID
+        QVector<double> values;
+        QVector<qint64> timestamps;
+        QVector<quint32> generations;
+        QVector<bool> stale;
+        QVector<qint64> decodedNs;
+        int staleSignalCount = 0;
+    };
+
     explicit VehicleDataController(QObject *parent = nullptr);
 
     // Getters
@@ -42,10 +104,80 @@ public:
     bool seatbelt() const;
     bool doorOpen() const;
 
+    PublishMode publishMode() const { return m_publishMode; }
+    void setPublishMode(PublishMode mode);
+
+    VehicleSignalModel *signalModel() const { return m_signalModel; }
+    const SignalRegistry &signalRegistry() const { return m_signalRegistry; }
+    // Read side for the one proxy consuming SnapshotPublish output
+    SnapshotBuffer<Snapshot> &snapshots() { return m_snapshots; }
+
+    // CAN IDs in the loaded DBC, extended ones marked with CanFrame::ExtendedIdFlag;
+    // everything else can be dropped in the kernel
+    QList<quint32> handledFrameIds() const;
+
+    // Replaces the decode table; the built-in vehicle DBC is loaded at startup
+    Q_INVOKABLE bool loadDbc(const QString &path);
+    QString dbcPath() const { return m_dbcPath; }
+
+    /**
+     * @brief Registers interest in a signal ("Signal" or "Message.Signal").
+     *
+     * Only subscribed signals are decoded, stored and bound to properties;
+     * a frame carrying none of them is dropped before decoding. Subscriptions
+     * are reference-counted and kept by name, so they survive a DBC reload.
+     * @return False if the loaded DBC has no such signal (it stays registered).
+     */
+    Q_INVOKABLE bool subscribe(const QString &signalName);
+    Q_INVOKABLE void unsubscribe(const QString &signalName);
+    Q_INVOKABLE int subscriberCount(const QString &signalName) const;
+
+    // Per message: frames, frames skipped as unchanged, signals decoded and
+    // signals skipped by the payload change cache, plus the skip rates,
+    // whether the message is stale and how often it went stale
+    Q_INVOKABLE QVariantList decodeStatistics() const;
+    Q_INVOKABLE void resetDecodeStatistics();
+    const PayloadChangeCache &payloadCache() const { return m_payloadCache; }
+
+    /**
+     * @brief Whether a signal's message has missed its deadline.
+     *
+     * A message is stale once nothing arrived for VEHICLESYS_STALE_CYCLES
+     * (default 3) of its DBC cycle times, and fresh again with its next
+     * frame. Messages without a cycle time never go stale. Deadlines sit in
+     * one timing wheel advanced by frame receive times, and by a coarse
+     * timer while the bus is silent.
+     */
+    Q_INVOKABLE bool isStale(const QString &signalName) const;
+    int staleSignalCount() const { return m_staleSignalCount; }
+    // Stale and stale signal counts, plus fresh-to-stale and stale-to-fresh
+    // transitions of messages since startup
+    Q_INVOKABLE QVariantMap stalenessStatistics() const;
+
+    /**
+     * @brief Stamps when a signal is decoded, for LatencyTracer.
+     *
+     * Off by default: decoding a traced signal's message costs one clock
+     * read. Kept by name, so it survives a DBC reload.
+     */
+    Q_INVOKABLE void traceLatency(const QString &signalName);
+    // Receive time of the signal's last decoded sample; 0 if unknown
+    Q_INVOKABLE qint64 receivedAtNs(const QString &signalName) const;
+    // When that sample was decoded; 0 unless the signal is traced
+    Q_INVOKABLE qint64 decodedAtNs(const QString &signalName) const;
+
+    // Decode time of processCanFrames() batches is recorded here; set it
+    // before the controller moves to its thread
+    void setStatistics(CanBusStatistics::Shard *statistics) { m_statistics = statistics; }
+
 public slots:
-    void processCanFrame(quint32 frameId, const QByteArray &data);
+    void processCanFrame(const CanFrame &frame);
+    void processCanFrames(const QVector<CanFrame> &frames);
     void resetTripOdometer();
     void toggleEngineState();
+    // Emits the final value of every property changed since the last call;
+    // driven by the window's frame clock in FramePublish mode
+    void publishPendingChanges();
 
 signals:
     void speedChanged(int speed);
@@ -62,6 +194,15 @@ signals:
     void engineRunningChanged(bool engineRunning);
     void seatbeltChanged(bool seatbelt);
     void doorOpenChanged(bool doorOpen);
+    void handledFrameIdsChanged(const QList<quint32> &frameIds);
+    void dbcLoaded(const QString &path);
+    void publishModeChanged(PublishMode mode);
+    // First change after a publish: the owner should schedule a frame
+    void publishRequested();
+    // SnapshotPublish: a snapshot is waiting and the reader had taken the last one
+    void snapshotPublished();
+    // Some signals went stale or fresh; see isStale()
+    void stalenessChanged();
     
     // Warning signals
     void lowFuelWarning();
@@ -70,8 +211,51 @@ signals:
 
 private slots:
     void updateOdometer();
+    // Expires deadlines while no frames arrive to advance the wheel
+    void checkStaleness();
 
 private:
+    using SignalBinding = std::function<void(double value)>;
+
+    // One bit per property in the pending-change mask
+    enum Property {
+        SpeedProperty,
+        RpmProperty,
+        FuelLevelProperty,
+        EngineTemperatureProperty,
+        LeftTurnSignalProperty,
+        RightTurnSignalProperty,
+        HeadlightsProperty,
+        ParkingBrakeProperty,
+        GearProperty,
+        OdometerProperty,
+        BatteryVoltageProperty,
+        EngineRunningProperty,
+        SeatbeltProperty,
+        DoorOpenProperty
+    };
+
+    void markChanged(Property property);
+    void emitChanged(Property property);
+    void requestPublish();
+    // Announces registry changes now, or schedules them with the next publish
+    void finishFrame();
+    void writeSnapshot();
+
+    void setupSignalBindings();
+    void resolveSignalBindings();
+    // Rebuilds the per-message decode masks from m_subscriptions
+    void resolveSubscriptions();
+    void resolveTracedSignals();
+    // Restarts every message deadline from @p nowMs
+    void resetStaleness(qint64 nowMs);
+    // Fires overdue deadlines, then re-arms @p messageIndex (or none, when -1)
+    void advanceStaleness(qint64 nowMs, int messageIndex);
+    void setMessageStale(int messageIndex, bool stale);
+    // Staleness clock: steady, read when a frame is processed
+    static qint64 monotonicMs();
+    static QString gearName(int gearValue);
+
     void setSpeed(int speed);
     void setRpm(int rpm);
     void setFuelLevel(int fuelLevel);
@@ -103,6 +287,55 @@ private:
     bool m_seatbelt;
     bool m_doorOpen;
     
+    // DBC-driven decoding: property bindings by signal name, resolved
+    // to decode-table indices whenever a DBC is loaded
+    CanDecodeTable m_decodeTable;
+    QString m_dbcPath;
+    QHash<QString, SignalBinding> m_signalBindings;
+    QVector<SignalBinding> m_boundSignals;
+    // Build-time decoders from dbc2cpp, used only while the loaded DBC is
+    // the one they were generated from
+    QVector<SignalBinding> m_generatedBindings;
+    QVector<int> m_generatedSignalIds;   // Generated signal index -> registry ID, or -1
+    bool m_useGeneratedDecoders = false;
+
+    // Lazy decoding: what is subscribed, flattened for the per-frame path
+    QHash<QString, int> m_subscriptions;   // Subscriber count by signal name
+    QVector<quint64> m_messageEnabled;     // Per table message, subscribed signals (decode() selection)
+    bool m_decodeAll;                      // VEHICLESYS_DECODE=all
+    // Skips signals whose bytes did not change since the previous frame
+    PayloadChangeCache m_payloadCache;
+    quint8 m_payload[CanDecodeTable::MaxPayload + CanDecodeTable::PayloadPadding]; // Long FD frames
+    QSet<quint32> m_reportedUnknownIds;
+
+    // Staleness: one deadline per table message, in monotonicMs() milliseconds
+    TimingWheel m_staleWheel;
+    QVector<bool> m_messageStale;
+    QVector<quint32> m_staleTransitionCounts;  // Per message, fresh to stale
+    quint64 m_staleTransitions;
+    quint64 m_freshTransitions;
+    int m_staleMessageCount;
+    int m_staleSignalCount;
+    int m_staleCycles;                          // VEHICLESYS_STALE_CYCLES, 0 disables
+    bool m_stalenessChanged;
+    QTimer *m_staleTimer;
+
+    CanBusStatistics::Shard *m_statistics;
+
+    // Latency tracing: decode times of traced signals, by signal ID
+    QSet<QString> m_tracedSignals;
+    QVector<bool> m_messageTraced;  // Per table message
+    QVector<qint64> m_decodedNs;
+
+    // Every decoded signal by ID, whether or not a property is bound to it
+    SignalRegistry m_signalRegistry;
+    VehicleSignalModel *m_signalModel;
+
+    PublishMode m_publishMode;
+    quint32 m_pendingChanges;   // Property bits awaiting publishPendingChanges()
+    bool m_publishRequested;
+    SnapshotBuffer<Snapshot> m_snapshots;
+
     // Timers and helpers
     QTimer *m_odometerTimer;
     int m_previousSpeed;
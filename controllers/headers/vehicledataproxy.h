@@ -0,0 +1,144 @@
+#ifndef VEHICLEDATAPROXY_H
+#define VEHICLEDATAPROXY_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QThread>
+
+#include "signalregistry.h"
+#include "vehicledatacontroller.h"
+#include "vehiclesignalmodel.h"
+
+/**
+ * @brief GUI-thread face of a VehicleDataController running on its own thread.
+ *
+ * Takes ownership of the controller and moves it to a "VehicleData" thread,
+ * where decoding, warning checks and the odometer run. The controller
+ * publishes snapshots of its state through a lock-free SnapshotBuffer;
+ * publishPendingChanges() takes the newest one and emits NOTIFY for every
+ * property that differs, so QML binds to the same properties as on the
+ * controller. Neither thread ever waits for the other. Requests (trip reset,
+ * engine toggle, subscriptions, DBC reload) are forwarded as queued calls.
+ */
+class VehicleDataProxy : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int speed READ speed NOTIFY speedChanged)
+    Q_PROPERTY(int rpm READ rpm NOTIFY rpmChanged)
+    Q_PROPERTY(int fuelLevel READ fuelLevel NOTIFY fuelLevelChanged)
+    Q_PROPERTY(int engineTemperature READ engineTemperature NOTIFY engineTemperatureChanged)
+    Q_PROPERTY(bool leftTurnSignal READ leftTurnSignal NOTIFY leftTurnSignalChanged)
+    Q_PROPERTY(bool rightTurnSignal READ rightTurnSignal NOTIFY rightTurnSignalChanged)
+    Q_PROPERTY(bool headlights READ headlights NOTIFY headlightsChanged)
+    Q_PROPERTY(bool parkingBrake READ parkingBrake NOTIFY parkingBrakeChanged)
+    Q_PROPERTY(QString gear READ gear NOTIFY gearChanged)
+    Q_PROPERTY(double odometer READ odometer NOTIFY odometerChanged)
+    Q_PROPERTY(int batteryVoltage READ batteryVoltage NOTIFY batteryVoltageChanged)
+    Q_PROPERTY(bool engineRunning READ engineRunning NOTIFY engineRunningChanged)
+    Q_PROPERTY(bool seatbelt READ seatbelt NOTIFY seatbeltChanged)
+    Q_PROPERTY(bool doorOpen READ doorOpen NOTIFY doorOpenChanged)
+    Q_PROPERTY(VehicleSignalModel *signalModel READ signalModel CONSTANT)
+    Q_PROPERTY(int staleSignalCount READ staleSignalCount NOTIFY stalenessChanged)
+
+public:
+    // Takes ownership of @p controller, which must not have a parent
+    explicit VehicleDataProxy(VehicleDataController *controller, QObject *parent = nullptr);
+    ~VehicleDataProxy();
+
+    int speed() const { return m_state.speed; }
+    int rpm() const { return m_state.rpm; }
+    int fuelLevel() const { return m_state.fuelLevel; }
+    int engineTemperature() const { return m_state.engineTemperature; }
+    bool leftTurnSignal() const { return m_state.leftTurnSignal; }
+    bool rightTurnSignal() const { return m_state.rightTurnSignal; }
+    bool headlights() const { return m_state.headlights; }
+    bool parkingBrake() const { return m_state.parkingBrake; }
+    QString gear() const { return m_state.gear; }
+    double odometer() const { return m_state.odometer; }
+    int batteryVoltage() const { return m_state.batteryVoltage; }
+    bool engineRunning() const { return m_state.engineRunning; }
+    bool seatbelt() const { return m_state.seatbelt; }
+    bool doorOpen() const { return m_state.doorOpen; }
+
+    VehicleSignalModel *signalModel() const { return m_signalModel; }
+    int staleSignalCount() const { return m_state.staleSignalCount; }
+    // As of the last applied snapshot
+    Q_INVOKABLE bool isStale(const QString &signalName) const;
+    // Lives on the decode thread: only for queued connections
+    VehicleDataController *controller() const { return m_controller; }
+
+    // As last reported by the controller
+    QList<quint32> handledFrameIds() const { return m_handledFrameIds; }
+    QString dbcPath() const { return m_dbcPath; }
+
+    // Queued to the controller; the result arrives as dbcLoaded()
+    Q_INVOKABLE void loadDbc(const QString &path);
+    // Queued to the controller; false if the current DBC has no such signal
+    Q_INVOKABLE bool subscribe(const QString &signalName);
+    Q_INVOKABLE void unsubscribe(const QString &signalName);
+    // Queued to the controller; stamps arrive with the following snapshots
+    Q_INVOKABLE void traceLatency(const QString &signalName);
+    // As of the last applied snapshot, like the controller's
+    Q_INVOKABLE qint64 receivedAtNs(const QString &signalName) const;
+    Q_INVOKABLE qint64 decodedAtNs(const QString &signalName) const;
+
+public slots:
+    void resetTripOdometer();
+    void toggleEngineState();
+    // Applies the newest snapshot, if any, and emits what changed
+    void publishPendingChanges();
+
+signals:
+    void speedChanged(int speed);
+    void rpmChanged(int rpm);
+    void fuelLevelChanged(int fuelLevel);
+    void engineTemperatureChanged(int engineTemperature);
+    void leftTurnSignalChanged(bool leftTurnSignal);
+    void rightTurnSignalChanged(bool rightTurnSignal);
+    void headlightsChanged(bool headlights);
+    void parkingBrakeChanged(bool parkingBrake);
+    void gearChanged(const QString &gear);
+    void odometerChanged(double odometer);
+    void batteryVoltageChanged(int batteryVoltage);
+    void engineRunningChanged(bool engineRunning);
+    void seatbeltChanged(bool seatbelt);
+    void doorOpenChanged(bool doorOpen);
+    void handledFrameIdsChanged(const QList<quint32> &frameIds);
+    void dbcLoaded(const QString &path);
+    // A snapshot is waiting: the owner should schedule a frame
+    void publishRequested();
+    void stalenessChanged();
+
+    // Warning signals
+    void lowFuelWarning();
+    void engineOverheatWarning();
+    void batteryLowWarning();
+
+private slots:
+    void handleDbcLoaded(const QString &path);
+    void handleHandledFrameIdsChanged(const QList<quint32> &frameIds);
+
+private:
+    using Snapshot = VehicleDataController::Snapshot;
+
+    template<typename T, typename Notify>
+    bool publish(T &current, const T &next, Notify notify);
+    // Copies the registry columns of @p snapshot into the local registry;
+    // true if any signal went stale or fresh
+    bool applySignals(const Snapshot &snapshot);
+    void rebuildRegistry(const QString &path);
+
+    VehicleDataController *m_controller;
+    SnapshotBuffer<Snapshot> *m_snapshots;
+    QThread *m_thread;
+
+    Snapshot m_state;               // Properties as last published (columns unused)
+    SignalRegistry m_signalRegistry;
+    QVector<qint64> m_decodedNs;    // Snapshot column, by signal ID
+    VehicleSignalModel *m_signalModel;
+    QList<quint32> m_handledFrameIds;
+    QString m_dbcPath;
+};
+
+#endif // VEHICLEDATAPROXY_H
@@ -0,0 +1,67 @@
+#ifndef VEHICLESIGNALMODEL_H
+#define VEHICLESIGNALMODEL_H
+
+#include <QAbstractListModel>
+#include <QVariantMap>
+
+class SignalRegistry;
+
+/**
+ * @brief Every DBC signal as a QML list model, one row per signal ID.
+ *
+ * Values come from the SignalRegistry; publishChanges() turns the
+ * registry's changed-ID runs into one dataChanged() per run, so QML cost
+ * follows the number of changed rows, not the number of decoded samples.
+ * Metadata roles (unit, range, scaling) let a generic gauge configure
+ * itself from the DBC.
+ */
+class VehicleSignalModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        NameRole = Qt::UserRole + 1,
+        MessageRole,
+        FrameIdRole,
+        UnitRole,
+        MinimumRole,
+        MaximumRole,
+        FactorRole,
+        OffsetRole,
+        ValueRole,
+        TimestampRole,
+        GenerationRole,
+        StaleRole
+    };
+    Q_ENUM(Role)
+
+    explicit VehicleSignalModel(SignalRegistry *registry, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // "Signal" or "Message.Signal"; -1 when the DBC has no such signal
+    Q_INVOKABLE int indexOf(const QString &name) const;
+    // Every role of one row, keyed by role name
+    Q_INVOKABLE QVariantMap get(int row) const;
+    Q_INVOKABLE double value(int row) const;
+
+    // Bracket a registry rebuild (DBC reload)
+    void beginRebuild();
+    void endRebuild();
+
+    // Announces rows changed in the registry since the last call
+    void publishChanges();
+
+signals:
+    void countChanged();
+
+private:
+    SignalRegistry *m_registry;
+    QVector<int> m_valueRoles;
+};
+
+#endif // VEHICLESIGNALMODEL_H
@@ -0,0 +1,599 @@
+#include "binarylogger.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <vector>
+
+VEHICLESYS_LOG_CATEGORY(logCan, "vehiclesys.can")
+VEHICLESYS_LOG_CATEGORY(logMedia, "vehiclesys.media")
+
+namespace {
+
+using namespace BinaryLog;
+
+struct RecordHeader
+{
+    quint32 size;           // Header included, a multiple of 8
+    quint32 payloadSize;
+    const Site *site;       // nullptr for padding up to the end of the ring
+    LogCategory *category;
+    qint64 timestampNs;
+};
+
+struct ThreadRing
+{
+    static constexpr quint32 Capacity = 1 << 16;
+
+    QByteArray threadName;
+    std::atomic<quint64> head{ 0 };     // Bytes ever written; owner thread only
+    char headPadding[56];               // Keeps head and tail on separate cache lines
+    std::atomic<quint64> tail{ 0 };     // Bytes ever read; writer thread only
+    char tailPadding[56];
+    std::atomic<quint64> dropped{ 0 };  // Records that found the ring full
+    alignas(8) char data[Capacity];
+};
+
+// Rings and categories are never freed, so finished threads' records still drain
+struct Registry
+{
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::vector<LogCategory *> categories;
+    QHash<QByteArray, LogCategory *> categoriesByName;
+    QHash<QByteArray, int> rateLimits;
+    int defaultRateLimit = 0;
+};
+
+Registry &registry()
+{
+    static Registry *instance = [] {
+        auto *created = new Registry;   // Outlives every thread that may still log at exit
+
+        // "name=limit,..." with "*" for every other category
+        const QStringList entries = qEnvironmentVariable("VEHICLESYS_LOG_RATE")
+                .split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (const QString &entry : entries) {
+            const int separator = entry.indexOf(QLatin1Char('='));
+            bool ok = false;
+            const int limit = separator > 0 ? entry.mid(separator + 1).trimmed().toInt(&ok) : 0;
+            if (!ok || limit < 0) {
+                std::fprintf(stderr, "BinaryLogger: ignoring VEHICLESYS_LOG_RATE entry \"%s\"\n",
+                             qPrintable(entry));
+                continue;
+            }
+            const QByteArray name = entry.left(separator).trimmed().toUtf8();
+            if (name == "*") {
+                created->defaultRateLimit = limit;
+            } else {
+                created->rateLimits.insert(name, limit);
+            }
+        }
+        return created;
+    }();
+    return *instance;
+}
+
+std::atomic<bool> s_running{ false };
+QtMessageHandler s_previousHandler = nullptr;
+
+thread_local ThreadRing *t_ring = nullptr;
+thread_local quint64 t_pendingHead = 0;
+thread_local std::vector<char> t_scratch;   // The record being written while no logger runs
+
+ThreadRing *registerThread()
+{
+    auto ring = std::make_unique<ThreadRing>();
+    QThread *thread = QThread::currentThread();
+    ring->threadName = thread ? thread->objectName().toUtf8() : QByteArray();
+    if (ring->threadName.isEmpty()) {
+        QCoreApplication *app = QCoreApplication::instance();
+        ring->threadName = thread && app && thread == app->thread()
+                ? QByteArray("GUI") : QByteArray("Thread");
+    }
+
+    Registry &instance = registry();
+    QMutexLocker locker(&instance.mutex);
+    instance.rings.push_back(std::move(ring));
+    return instance.rings.back().get();
+}
+
+const char *levelName(Level level)
+{
+    switch (level) {
+    case Debug: return "debug";
+    case Info: return "info";
+    case Warning: return "warning";
+    case Critical: return "critical";
+    }
+    return "";
+}
+
+QStringList decodeArguments(const char *payload, quint32 size)
+{
+    QStringList arguments;
+    const char *p = payload;
+    const char *end = payload + size;
+    while (p < end) {
+        const auto tag = static_cast<detail::Tag>(*p++);
+        switch (tag) {
+        case detail::IntTag: {
+            qint64 value;
+            std::memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            arguments.append(QString::number(value));
+            break;
+        }
+        case detail::UIntTag:
+        case detail::HexTag: {
+            quint64 value;
+            std::memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            arguments.append(tag == detail::HexTag
+                             ? QStringLiteral("0x") + QString::number(value, 16)
+                             : QString::number(value));
+            break;
+        }
+        case detail::DoubleTag: {
+            double value;
+            std::memcpy(&value, p, sizeof(value));
+            p += sizeof(value);
+            arguments.append(QString::number(value));
+            break;
+        }
+        case detail::BoolTag:
+            arguments.append(*p++ ? QStringLiteral("true") : QStringLiteral("false"));
+            break;
+        case detail::Utf8Tag:
+        case detail::Utf16Tag: {
+            quint16 units;
+            std::memcpy(&units, p, sizeof(units));
+            p += sizeof(units);
+            if (tag == detail::Utf8Tag) {
+                arguments.append(QString::fromUtf8(p, units));
+                p += units;
+            } else {
+                QString text(units, Qt::Uninitialized);
+                std::memcpy(text.data(), p, units * sizeof(QChar));
+                arguments.append(text);
+                p += units * sizeof(QChar);
+            }
+            break;
+        }
+        default:
+            return arguments;   // Corrupt; show what was read
+        }
+    }
+    return arguments;
+}
+
+// "%1".."%9" in one pass, so arguments containing '%' are left alone
+QString substitute(const char *format, const QStringList &arguments)
+{
+    const QString pattern = QString::fromUtf8(format);
+    QString result;
+    result.reserve(pattern.size() + 16 * arguments.size());
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        if (c == QLatin1Char('%') && i + 1 < pattern.size()) {
+            const int index = pattern.at(i + 1).digitValue();
+            if (index >= 1 && index <= arguments.size()) {
+                result += arguments.at(index - 1);
+                ++i;
+                continue;
+            }
+        }
+        result += c;
+    }
+    return result;
+}
+
+QByteArray formatLine(const RecordHeader &header, const char *payload, const QString &suffix = QString())
+{
+    const QString time = QDateTime::fromMSecsSinceEpoch(header.timestampNs / 1000000)
+            .toString(QStringLiteral("HH:mm:ss.zzz"));
+    return time.toUtf8() + ' ' + levelName(header.site->level) + ' ' + header.category->name() + ": "
+            + substitute(header.site->format, decodeArguments(payload, header.payloadSize)).toUtf8()
+            + suffix.toUtf8() + '\n';
+}
+
+/**
+ * Drains every ring in time order and writes the formatted lines. Repeat
+ * state is per call site (and category, for qDebug() ones), so a burst of
+ * one message does not hide the others interleaved with it.
+ */
+class LogWriter : public QThread
+{
+public:
+    LogWriter()
+        : m_stopping(false)
+        , m_output(stderr)
+        , m_lastReportNs(0)
+    {
+        setObjectName(QStringLiteral("BinaryLogger"));
+        const QString path = qEnvironmentVariable("VEHICLESYS_LOG_FILE");
+        if (!path.isEmpty()) {
+            FILE *file = std::fopen(QFile::encodeName(path).constData(), "a");
+            if (file) {
+                m_output = file;
+            } else {
+                std::fprintf(stderr, "BinaryLogger: cannot open %s, logging to stderr\n", qPrintable(path));
+            }
+        }
+    }
+
+    ~LogWriter() override
+    {
+        if (m_output != stderr) {
+            std::fclose(m_output);
+        }
+    }
+
+    void stop()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopping = true;
+            m_wake.wakeOne();
+        }
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_stopping) {
+            locker.unlock();
+            const bool drained = drain();
+            locker.relock();
+            if (!drained && !m_stopping) {
+                m_wake.wait(&m_mutex, 20);
+            }
+        }
+        locker.unlock();
+        drain();
+        flushRepeats(std::numeric_limits<qint64>::max());
+        std::fflush(m_output);
+    }
+
+private:
+    struct Pending
+    {
+        ThreadRing *ring;
+        const RecordHeader *header;
+    };
+
+    struct Repeat
+    {
+        QByteArray payload;
+        QByteArray lastLine;
+        quint32 count = 0;
+        qint64 firstNs = 0;
+    };
+
+    using RepeatKey = QPair<const Site *, LogCategory *>;
+
+    bool drain()
+    {
+        std::vector<ThreadRing *> rings;
+        {
+            Registry &instance = registry();
+            QMutexLocker locker(&instance.mutex);
+            rings.reserve(instance.rings.size());
+            for (const std::unique_ptr<ThreadRing> &ring : instance.rings) {
+                rings.push_back(ring.get());
+            }
+        }
+
+        // Collect up to each ring's head, merge by time, then hand the space back
+        m_pending.clear();
+        std::vector<quint64> heads(rings.size());
+        for (size_t i = 0; i < rings.size(); ++i) {
+            ThreadRing *ring = rings[i];
+            heads[i] = ring->head.load(std::memory_order_acquire);
+            quint64 position = ring->tail.load(std::memory_order_relaxed);
+            while (position < heads[i]) {
+                const quint32 offset = position & (ThreadRing::Capacity - 1);
+                const quint32 contiguous = ThreadRing::Capacity - offset;
+                if (contiguous < sizeof(RecordHeader)) {
+                    position += contiguous;     // Too short for a padding record
+                    continue;
+                }
+                const auto *header = reinterpret_cast<const RecordHeader *>(ring->data + offset);
+                if (header->site) {
+                    m_pending.push_back(Pending{ ring, header });
+                }
+                position += header->size;
+            }
+        }
+        std::stable_sort(m_pending.begin(), m_pending.end(), [](const Pending &a, const Pending &b) {
+            return a.header->timestampNs < b.header->timestampNs;
+        });
+
+        for (const Pending &pending : m_pending) {
+            write(*pending.header, reinterpret_cast<const char *>(pending.header + 1));
+        }
+        for (size_t i = 0; i < rings.size(); ++i) {
+            rings[i]->tail.store(heads[i], std::memory_order_release);
+        }
+
+        const qint64 now = detail::now();
+        flushRepeats(now - 1000000000);
+        if (now - m_lastReportNs >= 1000000000) {
+            m_lastReportNs = now;
+            reportLosses(rings);
+        }
+        if (!m_pending.empty()) {
+            std::fflush(m_output);
+        }
+        return !m_pending.empty();
+    }
+
+    void write(const RecordHeader &header, const char *payload)
+    {
+        Repeat &repeat = m_repeats[qMakePair(header.site, header.category)];
+        const QByteArray bytes = QByteArray::fromRawData(payload, static_cast<int>(header.payloadSize));
+        if (!repeat.lastLine.isEmpty() && repeat.payload == bytes) {
+            if (repeat.count++ == 0) {
+                repeat.firstNs = header.timestampNs;
+            }
+            repeat.lastLine = formatLine(header, payload, QStringLiteral(" [repeated %1 times]"));
+            return;
+        }
+        flushRepeat(repeat);
+        repeat.payload = QByteArray(payload, static_cast<int>(header.payloadSize));
+        const QByteArray line = formatLine(header, payload);
+        repeat.lastLine = line;
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), m_output);
+    }
+
+    void flushRepeat(Repeat &repeat)
+    {
+        if (repeat.count == 0) {
+            return;
+        }
+        const QByteArray line = repeat.lastLine.replace(" [repeated %1 times]",
+                                                        " [repeated " + QByteArray::number(repeat.count) + " times]");
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), m_output);
+        repeat.count = 0;
+    }
+
+    // Summaries for repeats that started before @p olderThanNs
+    void flushRepeats(qint64 olderThanNs)
+    {
+        bool wrote = false;
+        for (Repeat &repeat : m_repeats) {
+            if (repeat.count > 0 && repeat.firstNs < olderThanNs) {
+                flushRepeat(repeat);
+                wrote = true;
+            }
+        }
+        if (wrote) {
+            std::fflush(m_output);
+        }
+    }
+
+    void reportLosses(const std::vector<ThreadRing *> &rings)
+    {
+        std::vector<LogCategory *> categories;
+        {
+            Registry &instance = registry();
+            QMutexLocker locker(&instance.mutex);
+            categories = instance.categories;
+        }
+        for (LogCategory *category : categories) {
+            if (const quint64 limited = category->takeRateLimited()) {
+                std::fprintf(m_output, "BinaryLogger: %llu %s messages over the rate limit\n",
+                             static_cast<unsigned long long>(limited), category->name());
+            }
+        }
+        for (ThreadRing *ring : rings) {
+            if (const quint64 dropped = ring->dropped.exchange(0, std::memory_order_relaxed)) {
+                std::fprintf(m_output, "BinaryLogger: %llu messages dropped, %s thread's ring full\n",
+                             static_cast<unsigned long long>(dropped), ring->threadName.constData());
+            }
+        }
+    }
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping;
+    FILE *m_output;
+    qint64 m_lastReportNs;
+    std::vector<Pending> m_pending;
+    QHash<RepeatKey, Repeat> m_repeats;
+};
+
+LogWriter *s_writer = nullptr;
+
+// qDebug() categories are named by string literals, so the pointer is the key
+LogCategory *qtCategory(const char *name)
+{
+    thread_local QHash<const char *, LogCategory *> cache;
+    LogCategory *&category = cache[name];
+    if (!category) {
+        Registry &instance = registry();
+        QMutexLocker locker(&instance.mutex);
+        category = instance.categoriesByName.value(QByteArray(name));
+        if (!category) {
+            locker.unlock();
+            category = new LogCategory(qstrdup(name));  // Lives as long as the registry
+        }
+    }
+    return category;
+}
+
+const Site &qtSite(QtMsgType type)
+{
+    static const Site sites[] = {
+        { nullptr, Debug, "%1", nullptr, 0 },
+        { nullptr, Info, "%1", nullptr, 0 },
+        { nullptr, Warning, "%1", nullptr, 0 },
+        { nullptr, Critical, "%1", nullptr, 0 },
+    };
+    switch (type) {
+    case QtInfoMsg: return sites[1];
+    case QtWarningMsg: return sites[2];
+    case QtCriticalMsg: return sites[3];
+    default: return sites[0];
+    }
+}
+
+void handleQtMessage(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    if (type == QtFatalMsg) {
+        // Get everything before it out, then let Qt abort
+        if (s_writer) {
+            s_running.store(false, std::memory_order_release);
+            s_writer->stop();
+        }
+        s_previousHandler(type, context, message);
+        return;
+    }
+
+    LogCategory *category = qtCategory(context.category ? context.category : "default");
+    const qint64 timestampNs = detail::now();
+    if (!category->admit(timestampNs)) {
+        return;
+    }
+    const Site &site = qtSite(type);
+    char *out = detail::beginRecord(site, category, timestampNs, detail::payloadSize(message));
+    if (out) {
+        detail::encode(out, message);
+        detail::commitRecord();
+    }
+}
+
+} // namespace
+
+LogCategory::LogCategory(const char *name)
+    : m_name(name)
+    , m_rateLimit(0)
+    , m_windowSecond(-1)
+    , m_windowCount(0)
+    , m_rateLimited(0)
+{
+    Registry &instance = registry();
+    QMutexLocker locker(&instance.mutex);
+    m_rateLimit.store(instance.rateLimits.value(QByteArray(name), instance.defaultRateLimit),
+                      std::memory_order_relaxed);
+    instance.categories.push_back(this);
+    instance.categoriesByName.insert(QByteArray(name), this);
+}
+
+void LogCategory::setRateLimit(int messagesPerSecond)
+{
+    m_rateLimit.store(qMax(0, messagesPerSecond), std::memory_order_relaxed);
+}
+
+bool LogCategory::admit(qint64 nowNs)
+{
+    const int limit = m_rateLimit.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+    const qint64 second = nowNs / 1000000000;
+    qint64 window = m_windowSecond.load(std::memory_order_relaxed);
+    if (window != second && m_windowSecond.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+        m_windowCount.store(0, std::memory_order_relaxed);
+    }
+    if (m_windowCount.fetch_add(1, std::memory_order_relaxed) < limit) {
+        return true;
+    }
+    m_rateLimited.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+qint64 BinaryLog::detail::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+char *BinaryLog::detail::beginRecord(const Site &site, LogCategory *category, qint64 timestampNs, int payloadSize)
+{
+    const quint32 size = (sizeof(RecordHeader) + static_cast<quint32>(payloadSize) + 7) & ~7u;
+    RecordHeader *header;
+    if (!s_running.load(std::memory_order_acquire)) {
+        t_scratch.resize(size);
+        header = reinterpret_cast<RecordHeader *>(t_scratch.data());
+        t_pendingHead = 0;
+    } else {
+        ThreadRing *ring = t_ring;
+        if (!ring) {
+            ring = t_ring = registerThread();
+        }
+
+        // Single producer: only the writer moves tail, and only forward
+        quint64 head = ring->head.load(std::memory_order_relaxed);
+        const quint64 tail = ring->tail.load(std::memory_order_acquire);
+        quint32 offset = head & (ThreadRing::Capacity - 1);
+        const quint32 contiguous = ThreadRing::Capacity - offset;
+        const quint32 needed = size <= contiguous ? size : size + contiguous;
+        if (size > ThreadRing::Capacity / 4 || ThreadRing::Capacity - (head - tail) < needed) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (size > contiguous) {
+            if (contiguous >= sizeof(RecordHeader)) {
+                auto *padding = reinterpret_cast<RecordHeader *>(ring->data + offset);
+                padding->size = contiguous;
+                padding->site = nullptr;
+            }
+            head += contiguous;
+            offset = 0;
+        }
+        header = reinterpret_cast<RecordHeader *>(ring->data + offset);
+        t_pendingHead = head + size;
+    }
+
+    header->size = size;
+    header->payloadSize = static_cast<quint32>(payloadSize);
+    header->site = &site;
+    header->category = category;
+    header->timestampNs = timestampNs;
+    return reinterpret_cast<char *>(header + 1);
+}
+
+void BinaryLog::detail::commitRecord()
+{
+    if (t_pendingHead == 0) {
+        const auto *header = reinterpret_cast<const RecordHeader *>(t_scratch.data());
+        const QByteArray line = formatLine(*header, reinterpret_cast<const char *>(header + 1));
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stderr);
+        return;
+    }
+    t_ring->head.store(t_pendingHead, std::memory_order_release);
+}
+
+BinaryLogger::BinaryLogger()
+{
+    Q_ASSERT(!s_writer);
+    s_writer = new LogWriter;
+    s_writer->start(QThread::LowPriority);
+    s_running.store(true, std::memory_order_release);
+    s_previousHandler = qInstallMessageHandler(handleQtMessage);
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    qInstallMessageHandler(s_previousHandler);
+    s_running.store(false, std::memory_order_release);
+    if (s_writer->isRunning()) {
+        s_writer->stop();
+    }
+    delete s_writer;
+    s_writer = nullptr;
+}
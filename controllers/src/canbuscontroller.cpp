@@ -1,42 +1,152 @@
 #include "canbuscontroller.h"
-#include <QDebug>
-#include <QRandomGenerator>
-
-#ifdef HAVE_QT_SERIALBUS
-#include <QCanBus>
+#include "canframering.h"
+#include "caningestworker.h"
+#include "canbussimulator.h"
+#include "canlogwriter.h"
+#include "canlogreader.h"
+#include "canlogreplayer.h"
+#include "tracing.h"
+#ifdef HAVE_SOCKETCAN
+#include "socketcanreader.h"
 #endif
+#include <QDebug>
+#include <QMetaMethod>
+#include <QSaveFile>
+#include <chrono>
 
 CanBusController::CanBusController(QObject *parent)
     : QObject(parent)
+    , m_ingestThread(new QThread(this))
+    , m_ingestWorker(nullptr)
+#ifdef HAVE_SOCKETCAN
+    , m_socketCanReader(nullptr)
+#endif
+    , m_ring(new CanFrameRing(CanFrameRing::DefaultCapacity))
+    , m_drainBuffer(MaxDrainBatch)
 #ifdef HAVE_QT_SERIALBUS
-    , m_canDevice(nullptr)
+    , m_backend(QtSerialBusBackend)
+#else
+    , m_backend(NativeSocketCanBackend)
 #endif
-    , m_simulationTimer(new QTimer(this))
+    , m_ringCapacity(CanFrameRing::DefaultCapacity)
+    , m_deviceOpen(false)
+    , m_reportedDropped(0)
+    , m_simulator(nullptr)
+    , m_simulationSeed(CanBusSimulator::DefaultSeed)
+    , m_simulationBusLoad(0.0)
+    , m_simulationBitRate(CanBusSimulator::DefaultBitRate)
+    , m_recorder(new CanLogWriter)
+    , m_replayer(nullptr)
+    , m_replaySpeed(1.0)
     , m_connected(false)
     , m_status("Disconnected")
-    , m_speed(0)
-    , m_rpm(800)
-    , m_fuelLevel(85)
-    , m_engineTemp(90)
-    , m_leftTurnSignal(false)
-    , m_rightTurnSignal(false)
-    , m_headlights(false)
-    , m_engineRunning(true)
+    , m_statistics(new CanBusStatistics)
+    , m_decodeStatistics(m_statistics->createShard(QStringLiteral("GUI")))
+    , m_statisticsModel(new CanStatisticsModel(this))
+    , m_statisticsTimer(new QTimer(this))
+    , m_busBitRate(CanBusSimulator::DefaultBitRate)
+    , m_metricsInterval(15)
+    , m_samplesSinceWrite(0)
 {
-    connect(m_simulationTimer, &QTimer::timeout, this, &CanBusController::simulateVehicleData);
-    setupSimulatedData();
-}
+    qRegisterMetaType<CanFrame>();
 
-CanBusController::~CanBusController()
-{
+    // Simulated traffic comes from its own thread through the same ring
+    m_simulator = new CanBusSimulator(m_ring, this);
+    m_simulator->setStatistics(m_statistics->createShard(m_simulator->objectName()));
+    connect(m_simulator, &CanBusSimulator::framesPending, this, &CanBusController::handleFramesReceived);
+
+    // So does a replayed log
+    m_replayer = new CanLogReplayer(m_ring, this);
+    m_replayer->setStatistics(m_statistics->createShard(m_replayer->objectName()));
+    connect(m_replayer, &CanLogReplayer::framesPending, this, &CanBusController::handleFramesReceived);
+    connect(m_replayer, &QThread::finished, this, &CanBusController::handleReplayFinished);
+
+    // Reproducible load tests without a rebuild:
+    // VEHICLESYS_SIM_SEED, VEHICLESYS_SIM_BUSLOAD (percent), VEHICLESYS_SIM_BITRATE
+    bool ok = false;
+    const qint64 seed = qEnvironmentVariable("VEHICLESYS_SIM_SEED").toLongLong(&ok);
+    if (ok) {
+        m_simulationSeed = seed;
+    }
+    const double busLoad = qEnvironmentVariable("VEHICLESYS_SIM_BUSLOAD").toDouble(&ok);
+    if (ok) {
+        m_simulationBusLoad = qBound(0.0, busLoad, 100.0);
+    }
+    const int bitRate = qEnvironmentVariableIntValue("VEHICLESYS_SIM_BITRATE", &ok);
+    if (ok && bitRate > 0) {
+        m_simulationBitRate = bitRate;
+    }
+    const double replaySpeed = qEnvironmentVariable("VEHICLESYS_REPLAY_SPEED").toDouble(&ok);
+    if (ok) {
+        m_replaySpeed = qMax(0.0, replaySpeed);
+    }
+
+    // Statistics for fleet tooling: VEHICLESYS_METRICS_FILE=<file>, VEHICLESYS_METRICS_INTERVAL (seconds);
+    // VEHICLESYS_CAN_BITRATE is the live bus bit rate the load is measured against
+    const int busBitRate = qEnvironmentVariableIntValue("VEHICLESYS_CAN_BITRATE", &ok);
+    if (ok && busBitRate > 0) {
+        m_busBitRate = busBitRate;
+    }
+    m_metricsPath = qEnvironmentVariable("VEHICLESYS_METRICS_FILE");
+    const int metricsInterval = qEnvironmentVariableIntValue("VEHICLESYS_METRICS_INTERVAL", &ok);
+    if (ok && metricsInterval > 0) {
+        m_metricsInterval = metricsInterval;
+    }
+    m_statistics->setBitRate(m_busBitRate);
+    connect(m_statisticsTimer, &QTimer::timeout, this, &CanBusController::sampleStatistics);
+    m_statisticsTimer->start(1000);
+
+    // Capture a session from the first frame: VEHICLESYS_RECORD=<file>, VEHICLESYS_RECORD_MB
+    const QString recordPath = qEnvironmentVariable("VEHICLESYS_RECORD");
+    if (!recordPath.isEmpty()) {
+        const int recordMegabytes = qEnvironmentVariableIntValue("VEHICLESYS_RECORD_MB", &ok);
+        startRecording(recordPath, ok && recordMegabytes > 0 ? qint64(recordMegabytes) << 20 : 0);
+    }
+
+    // The bus device lives on its own thread; only drained batches reach this one
+    m_ingestThread->setObjectName(QStringLiteral("CanIngest"));
+    m_ingestWorker = new CanIngestWorker(m_ring);
+    m_ingestWorker->setStatistics(m_statistics->createShard(m_ingestThread->objectName()));
+    m_ingestWorker->moveToThread(m_ingestThread);
+    connect(m_ingestThread, &QThread::finished, m_ingestWorker, &QObject::deleteLater);
+    connect(m_ingestWorker, &CanIngestWorker::framesPending, this, &CanBusController::handleFramesReceived);
 #ifdef HAVE_QT_SERIALBUS
-    if (m_canDevice) {
-        m_canDevice->disconnectDevice();
-        delete m_canDevice;
+    qRegisterMetaType<QCanBusDevice::CanBusDeviceState>();
+    connect(m_ingestWorker, &CanIngestWorker::errorOccurred, this, &CanBusController::handleErrorOccurred);
+    connect(m_ingestWorker, &CanIngestWorker::stateChanged, this, &CanBusController::handleStateChanged);
+#endif
+    m_ingestThread->start();
+
+#ifdef HAVE_SOCKETCAN
+    // Native backend runs its own blocking read loop and shares the same ring
+    m_socketCanReader = new SocketCanReader(m_ring, this);
+    m_socketCanReader->setStatistics(m_statistics->createShard(m_socketCanReader->objectName()));
+    connect(m_socketCanReader, &SocketCanReader::framesPending, this, &CanBusController::handleFramesReceived);
+    connect(m_socketCanReader, &SocketCanReader::readFailed, this, &CanBusController::handleReaderFailed);
+
+    // Allow A/B measurement without a rebuild: VEHICLESYS_CAN_BACKEND=native|qt
+    const QByteArray requestedBackend = qgetenv("VEHICLESYS_CAN_BACKEND");
+    if (requestedBackend == "native") {
+        m_backend = NativeSocketCanBackend;
+    } else if (requestedBackend == "qt") {
+        m_backend = QtSerialBusBackend;
     }
 #endif
 }
 
+CanBusController::~CanBusController()
+{
+    m_simulator->stop();
+    m_replayer->stop();
+    closeBusDevice();
+    m_ingestThread->quit();
+    m_ingestThread->wait();
+    m_recorder->close();
+    delete m_recorder;
+    delete m_ring;
+    delete m_statistics;
+}
+
 bool CanBusController::connected() const
 {
     return m_connected;
@@ -47,19 +157,205 @@ QString CanBusController::status() const
     return m_status;
 }
 
+CanBusController::Backend CanBusController::backend() const
+{
+    return m_backend;
+}
+
+int CanBusController::ringCapacity() const
+{
+    return m_ringCapacity;
+}
+
+qint64 CanBusController::droppedFrames() const
+{
+    return static_cast<qint64>(m_ring->droppedCount());
+}
+
+int CanBusController::ringHighWatermark() const
+{
+    return m_ring->highWatermark();
+}
+
+qint64 CanBusController::simulationSeed() const
+{
+    return m_simulationSeed;
+}
+
+double CanBusController::simulationBusLoad() const
+{
+    return m_simulationBusLoad;
+}
+
+int CanBusController::simulationBitRate() const
+{
+    return m_simulationBitRate;
+}
+
+double CanBusController::scheduledBusLoad() const
+{
+    return m_simulator->scheduledBusLoad();
+}
+
+void CanBusController::setSimulationSeed(qint64 seed)
+{
+    if (m_simulationSeed != seed) {
+        m_simulationSeed = seed;
+        emit simulationSeedChanged(m_simulationSeed);
+    }
+}
+
+void CanBusController::setSimulationBusLoad(double percent)
+{
+    percent = qBound(0.0, percent, 100.0);
+    if (!qFuzzyCompare(m_simulationBusLoad + 1.0, percent + 1.0)) {
+        m_simulationBusLoad = percent;
+        emit simulationBusLoadChanged(m_simulationBusLoad);
+    }
+}
+
+void CanBusController::setSimulationBitRate(int bitsPerSecond)
+{
+    bitsPerSecond = qMax(10000, bitsPerSecond);
+    if (m_simulationBitRate != bitsPerSecond) {
+        m_simulationBitRate = bitsPerSecond;
+        emit simulationBitRateChanged(m_simulationBitRate);
+    }
+}
+
+void CanBusController::setSimulationCycleTime(quint32 frameId, int cycleTimeMs)
+{
+    m_simulator->setCycleTime(frameId, cycleTimeMs);
+}
+
+bool CanBusController::recording() const
+{
+    return m_recorder->isOpen();
+}
+
+bool CanBusController::startRecording(const QString &path, qint64 maxBytes)
+{
+    const bool wasRecording = m_recorder->isOpen();
+    if (!m_recorder->open(path, maxBytes > 0 ? maxBytes : CanLogWriter::DefaultMaxBytes)) {
+        qWarning() << "CanBusController: cannot record:" << m_recorder->errorString();
+        emit errorOccurred(m_recorder->errorString());
+        if (wasRecording) {
+            emit recordingChanged(false);
+        }
+        return false;
+    }
+
+    qDebug() << "Recording CAN traffic to" << path;
+    if (!wasRecording) {
+        emit recordingChanged(true);
+    }
+    return true;
+}
+
+void CanBusController::stopRecording()
+{
+    if (!m_recorder->isOpen()) {
+        return;
+    }
+    m_recorder->close();
+    emit recordingChanged(false);
+}
+
+qint64 CanBusController::recordedFrames() const
+{
+    return static_cast<qint64>(m_recorder->recordCount());
+}
+
+bool CanBusController::exportRecording(const QString &logPath, const QString &candumpPath)
+{
+    CanLogReader reader;
+    if (!reader.open(logPath) || !reader.exportCandump(candumpPath)) {
+        qWarning() << "CanBusController: cannot export recording:" << reader.errorString();
+        emit errorOccurred(reader.errorString());
+        return false;
+    }
+    qDebug() << "Exported" << reader.recordCount() << "frames to" << candumpPath;
+    return true;
+}
+
+double CanBusController::replaySpeed() const
+{
+    return m_replaySpeed;
+}
+
+void CanBusController::setReplaySpeed(double speed)
+{
+    speed = qMax(0.0, speed);
+    if (!qFuzzyCompare(m_replaySpeed + 1.0, speed + 1.0)) {
+        m_replaySpeed = speed;
+        emit replaySpeedChanged(m_replaySpeed);
+    }
+}
+
+bool CanBusController::writeStatistics(const QString &path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(CanBusStatistics::toPrometheus(m_statisticsModel->sample())) < 0
+            || !file.commit()) {
+        qWarning() << "CanBusController: cannot write statistics:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void CanBusController::sampleStatistics()
+{
+    m_statisticsModel->update(m_statistics->collect());
+
+    if (!m_metricsPath.isEmpty() && ++m_samplesSinceWrite >= m_metricsInterval) {
+        m_samplesSinceWrite = 0;
+        writeStatistics(m_metricsPath);
+    }
+}
+
+double CanBusController::replayProgress() const
+{
+    const quint64 total = m_replayer->recordCount();
+    return total > 0 ? static_cast<double>(m_replayer->framesReplayed()) / total : 0.0;
+}
+
+void CanBusController::setSimulationDbc(const QString &path)
+{
+    if (!m_simulator->loadDbc(path)) {
+        qWarning() << "CanBusController: simulator cannot load DBC:" << m_simulator->errorString();
+    }
+}
+
+void CanBusController::setBackend(Backend backend)
+{
+    if (m_backend != backend) {
+        m_backend = backend;
+        emit backendChanged(m_backend);
+    }
+}
+
+void CanBusController::setRingCapacity(int capacity)
+{
+    capacity = qMax(capacity, 16);
+    if (m_ringCapacity != capacity) {
+        m_ringCapacity = capacity;
+        emit ringCapacityChanged(m_ringCapacity);
+    }
+}
+
 void CanBusController::connectToSimulator()
 {
     // Always allow switching to simulation mode, regardless of current state
     if (m_status != "Simulation Mode Active") {
         // First disconnect from any existing connection
-        if (m_connected) {
-            disconnectFromSimulator();
-        }
+        m_replayer->stop();
+        closeBusDevice();
         
         // Start simulation mode
+        startSimulation();
         m_status = "Simulation Mode Active";
         m_connected = true;
-        m_simulationTimer->start(100); // 10Hz update rate
         
         emit statusChanged(m_status);
         emit connectedChanged(m_connected);
@@ -73,44 +369,15 @@ void CanBusController::connectToBus(const QString &interface)
         return;
     }
 
-#ifdef HAVE_QT_SERIALBUS
     // Try to connect to specified interface (e.g., vcan0 for virtual CAN)
-    qDebug() << "Attempting to connect to CAN interface:" << interface;
-    
-    // Create device using socketcan plugin with specified interface
-    m_canDevice = QCanBus::instance()->createDevice(QStringLiteral("socketcan"), interface);
-    
-    if (!m_canDevice) {
-        qDebug() << "Failed to create CAN device for interface:" << interface;
-        // Check available devices
-        QString errorString;
-        auto availableDevices = QCanBus::instance()->availableDevices(QStringLiteral("socketcan"), &errorString);
-        qDebug() << "Available devices:" << availableDevices.size();
-        for (const auto &device : availableDevices) {
-            qDebug() << "  -" << device.name() << device.description();
-        }
-    }
-
-    if (m_canDevice) {
-        connect(m_canDevice, &QCanBusDevice::framesReceived, this, &CanBusController::handleFramesReceived);
-        connect(m_canDevice, &QCanBusDevice::errorOccurred, this, &CanBusController::handleErrorOccurred);
-        connect(m_canDevice, &QCanBusDevice::stateChanged, this, &CanBusController::handleStateChanged);
-
-        if (m_canDevice->connectDevice()) {
-            m_status = "Connecting to CAN Bus...";
-            emit statusChanged(m_status);
-            return;
-        } else {
-            delete m_canDevice;
-            m_canDevice = nullptr;
-        }
+    if (openBusDevice(interface)) {
+        return;
     }
-#endif
 
     // Start simulation mode (fallback or when SerialBus not available)
+    startSimulation();
     m_status = "Simulation Mode Active";
     m_connected = true;
-    m_simulationTimer->start(100); // 10Hz update rate
     emit connectedChanged(m_connected);
     emit statusChanged(m_status);
 }
@@ -118,34 +385,13 @@ void CanBusController::connectToBus(const QString &interface)
 void CanBusController::disconnectFromSimulator()
 {
     // Always allow switching to CAN control mode
-    m_simulationTimer->stop();
-    
-#ifdef HAVE_QT_SERIALBUS
-    if (m_canDevice) {
-        m_canDevice->disconnectDevice();
-        delete m_canDevice;
-        m_canDevice = nullptr;
-    }
+    m_simulator->stop();
+    m_replayer->stop();
+    closeBusDevice();
     
     // Try to connect to actual CAN bus
-    qDebug() << "Attempting to connect to CAN interface: vcan0";
-    
-    // Create device using socketcan plugin
-    m_canDevice = QCanBus::instance()->createDevice(QStringLiteral("socketcan"), "vcan0");
-    
-    if (m_canDevice) {
-        connect(m_canDevice, &QCanBusDevice::framesReceived, this, &CanBusController::handleFramesReceived);
-        connect(m_canDevice, &QCanBusDevice::errorOccurred, this, &CanBusController::handleErrorOccurred);
-        connect(m_canDevice, &QCanBusDevice::stateChanged, this, &CanBusController::handleStateChanged);
-
-        if (m_canDevice->connectDevice()) {
-            m_status = "Connecting to CAN Bus...";
-            emit statusChanged(m_status);
-            return;
-        } else {
-            delete m_canDevice;
-            m_canDevice = nullptr;
-        }
+    if (openBusDevice(QStringLiteral("vcan0"))) {
+        return;
     }
     
     // If CAN connection failed, show CAN control mode but indicate no CAN available
@@ -154,54 +400,191 @@ void CanBusController::disconnectFromSimulator()
     emit connectedChanged(m_connected);
     emit statusChanged(m_status);
     qDebug() << "Switched to CAN control mode, but no CAN bus available";
-#else
-    // If no SerialBus support, show CAN control mode but indicate no CAN available
-    m_connected = false;
-    m_status = "CAN Control Mode (No CAN Bus Available)";
+}
+
+bool CanBusController::connectToReplay(const QString &path)
+{
+    m_simulator->stop();
+    closeBusDevice();
+    if (!m_replayer->open(path)) {
+        qWarning() << "CanBusController: cannot replay:" << m_replayer->errorString();
+        emit errorOccurred(m_replayer->errorString());
+        return false;
+    }
+
+    // The replayer becomes the ring's only producer
+    m_ring->reset(m_ringCapacity);
+    m_reportedDropped = 0;
+    emit ringStatisticsChanged();
+
+    m_statistics->setBitRate(m_busBitRate);
+    m_replayer->setSpeed(m_replaySpeed);
+    m_replayer->start(QThread::HighPriority);
+    m_connected = true;
+    m_status = "Replaying CAN Log";
     emit connectedChanged(m_connected);
     emit statusChanged(m_status);
-    qDebug() << "Switched to CAN control mode, but no CAN bus support available";
-#endif
+    qDebug() << "Replaying" << path << "at speed" << m_replaySpeed;
+    return true;
 }
 
 void CanBusController::sendFrame(quint32 frameId, const QByteArray &data)
 {
-#ifdef HAVE_QT_SERIALBUS
-    if (!m_canDevice || !m_connected) {
+    if (!m_deviceOpen || !m_connected) {
         return;
     }
 
-    QCanBusFrame frame(frameId, data);
-    m_canDevice->writeFrame(frame);
-#else
-    Q_UNUSED(frameId)
-    Q_UNUSED(data)
+#ifdef HAVE_SOCKETCAN
+    if (m_socketCanReader->isOpen()) {
+        m_socketCanReader->writeFrame(frameId, data);
+        return;
+    }
 #endif
+
+    QMetaObject::invokeMethod(m_ingestWorker, [this, frameId, data]() {
+        m_ingestWorker->writeFrame(frameId, data);
+    }, Qt::QueuedConnection);
 }
 
-#ifdef HAVE_QT_SERIALBUS
-void CanBusController::handleFramesReceived()
+void CanBusController::setFrameIdFilter(const QList<quint32> &frameIds)
+{
+    m_frameIdFilter = frameIds;
+    qDebug() << "CAN receive filter:" << frameIds.size() << "IDs";
+
+    // Applied to the open device now, and again by each backend on open
+#ifdef HAVE_SOCKETCAN
+    m_socketCanReader->setFrameIdFilter(frameIds);
+#endif
+    QMetaObject::invokeMethod(m_ingestWorker, [this, frameIds]() {
+        m_ingestWorker->setFrameIdFilter(frameIds);
+    }, Qt::QueuedConnection);
+}
+
+void CanBusController::startSimulation()
+{
+    // The simulator becomes the ring's only producer
+    m_simulator->stop();
+    m_ring->reset(m_ringCapacity);
+    m_reportedDropped = 0;
+    emit ringStatisticsChanged();
+
+    m_simulator->setSeed(static_cast<quint64>(m_simulationSeed));
+    m_simulator->setBitRate(m_simulationBitRate);
+    m_statistics->setBitRate(m_simulationBitRate);
+    m_simulator->setTargetBusLoad(m_simulationBusLoad);
+    m_simulator->start(QThread::HighPriority);
+}
+
+bool CanBusController::openBusDevice(const QString &interface)
+{
+    qDebug() << "Attempting to connect to CAN interface:" << interface << "backend:" << m_backend;
+
+    // No producer is running here, so the ring can be resized safely
+    m_ring->reset(m_ringCapacity);
+    m_reportedDropped = 0;
+    emit ringStatisticsChanged();
+    m_statistics->setBitRate(m_busBitRate);
+
+#ifdef HAVE_SOCKETCAN
+    if (m_backend == NativeSocketCanBackend) {
+        if (!m_socketCanReader->open(interface)) {
+            qDebug() << "Native SocketCAN open failed:" << m_socketCanReader->errorString();
+            return false;
+        }
+        m_socketCanReader->start(QThread::HighPriority);
+        m_deviceOpen = true;
+
+        // A bound raw socket is live immediately; there is no connect handshake
+        m_connected = true;
+        m_status = "Connected to CAN Bus";
+        emit connectedChanged(m_connected);
+        emit statusChanged(m_status);
+        return true;
+    }
+#endif
+
+    bool opened = false;
+    QMetaObject::invokeMethod(m_ingestWorker, [this, interface, &opened]() {
+        opened = m_ingestWorker->openDevice(QStringLiteral("socketcan"), interface);
+    }, Qt::BlockingQueuedConnection);
+
+    m_deviceOpen = opened;
+    if (opened) {
+        m_status = "Connecting to CAN Bus...";
+        emit statusChanged(m_status);
+    }
+    return opened;
+}
+
+void CanBusController::closeBusDevice()
 {
-    if (!m_canDevice) {
+    if (!m_deviceOpen) {
         return;
     }
 
-    while (m_canDevice->framesAvailable()) {
-        const QCanBusFrame frame = m_canDevice->readFrame();
-        if (frame.isValid()) {
-            emit frameReceived(frame.frameId(), frame.payload());
-        }
+#ifdef HAVE_SOCKETCAN
+    m_socketCanReader->close();
+#endif
+    QMetaObject::invokeMethod(m_ingestWorker, [this]() {
+        m_ingestWorker->closeDevice();
+    }, Qt::BlockingQueuedConnection);
+    m_deviceOpen = false;
+}
+
+void CanBusController::handleFramesReceived()
+{
+    VEHICLESYS_TRACE_ZONE("CanBusController::handleFramesReceived");
+    // Clear first: frames pushed while we drain will schedule another turn
+    m_ring->clearPending();
+
+    CanFrame *frames = m_drainBuffer.data();
+    const int count = m_ring->pop(frames, MaxDrainBatch);
+    if (m_recorder->isOpen()) {
+        m_recorder->append(frames, count);
+    }
+    // Direct receivers decode inside emit, so this times the decoding
+    const bool decodeHere = count > 0 && isSignalConnected(QMetaMethod::fromSignal(&CanBusController::frameReceived));
+    const auto decodeStart = decodeHere ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    for (int i = 0; i < count; ++i) {
+        emit frameReceived(frames[i]);
+    }
+    if (decodeHere) {
+        m_decodeStatistics->recordDecode(count, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - decodeStart).count());
+    }
+    if (count > 0 && isSignalConnected(QMetaMethod::fromSignal(&CanBusController::framesReceived))) {
+        emit framesReceived(QVector<CanFrame>(frames, frames + count));
+    }
+
+    // Leave the rest for the next turn so a backlog cannot starve rendering
+    if (!m_ring->isEmpty() && m_ring->markPending()) {
+        QMetaObject::invokeMethod(this, &CanBusController::handleFramesReceived, Qt::QueuedConnection);
+    }
+
+    if (m_ring->droppedCount() != m_reportedDropped) {
+        m_reportedDropped = m_ring->droppedCount();
+        emit ringStatisticsChanged();
     }
 }
 
-void CanBusController::handleErrorOccurred(QCanBusDevice::CanBusError error)
+void CanBusController::handleReplayFinished()
 {
-    if (m_canDevice) {
-        QString errorString = m_canDevice->errorString();
-        m_status = "Error: " + errorString;
-        emit statusChanged(m_status);
-        emit errorOccurred(errorString);
+    // Stopped on purpose when switching sources; only report a log that ran out
+    if (m_status != "Replaying CAN Log" || m_replayer->isRunning()) {
+        return;
     }
+    m_connected = false;
+    m_status = "Replay Finished";
+    emit connectedChanged(m_connected);
+    emit statusChanged(m_status);
+}
+
+#ifdef HAVE_QT_SERIALBUS
+void CanBusController::handleErrorOccurred(const QString &errorString)
+{
+    m_status = "Error: " + errorString;
+    emit statusChanged(m_status);
+    emit errorOccurred(errorString);
 }
 
 void CanBusController::handleStateChanged(QCanBusDevice::CanBusDeviceState state)
@@ -218,6 +601,8 @@ void CanBusController::handleStateChanged(QCanBusDevice::CanBusDeviceState state
         m_connected = false;
         m_status = "Disconnected from CAN Bus";
         break;
+    default:
+        break;
     }
     
     emit connectedChanged(m_connected);
@@ -225,125 +610,15 @@ void CanBusController::handleStateChanged(QCanBusDevice::CanBusDeviceState state
 }
 #endif
 
-void CanBusController::simulateVehicleData()
+#ifdef HAVE_SOCKETCAN
+void CanBusController::handleReaderFailed(const QString &errorString)
 {
-    // Simulate realistic vehicle behavior
-    QRandomGenerator *rng = QRandomGenerator::global();
-    
-    // Speed variation (0-120 km/h)
-    int speedChange = rng->bounded(-2, 3);
-    m_speed = qBound(0, m_speed + speedChange, 120);
-    
-    // RPM correlates with speed and engine state
-    int targetRpm = 800 + (m_speed * 25); // Idle + speed-based RPM
-    m_rpm = qBound(700, targetRpm + rng->bounded(-100, 101), 6000);
-    
-    // Engine running determination
-    m_engineRunning = (m_rpm > 500);
-    
-    // Fuel consumption (very slow decrease)
-    if (m_speed > 0 && rng->bounded(0, 1000) < 1) {
-        m_fuelLevel = qMax(0, m_fuelLevel - 1);
-    }
-    
-    // Engine temperature (stable around 90°C)
-    int tempChange = rng->bounded(-1, 2);
-    m_engineTemp = qBound(70, m_engineTemp + tempChange, 110);
-    
-    // Random turn signals
-    if (rng->bounded(0, 100) < 2) {
-        m_leftTurnSignal = !m_leftTurnSignal;
-        m_rightTurnSignal = false;
-    }
-    if (rng->bounded(0, 100) < 2) {
-        m_rightTurnSignal = !m_rightTurnSignal;
-        m_leftTurnSignal = false;
-    }
-    
-    // Headlights based on time simulation
-    static int timeCounter = 0;
-    timeCounter++;
-    if (timeCounter % 300 == 0) { // Change every 30 seconds
-        m_headlights = !m_headlights;
-    }
-
-    // Emit CAN frames with simulated data matching DBC format and VehicleDataController expectations
-    
-    // 0x100: Engine_Data (RPM, load, temperature, fuel) - 8 bytes
-    QByteArray engineData(8, 0);
-    // Engine Speed (RPM) - bytes 0-1, scale 0.25, so multiply by 4 for raw value
-    quint16 rpmRaw = m_rpm * 4;
-    engineData[0] = static_cast<char>(rpmRaw & 0xFF);
-    engineData[1] = static_cast<char>((rpmRaw >> 8) & 0xFF);
-    // Engine Load - byte 2 (not used in simulation, set to reasonable value)
-    engineData[2] = static_cast<char>(50); // 50% load
-    // Engine Coolant Temperature - byte 3, offset +40, so add 40 to actual temp
-    engineData[3] = static_cast<char>(m_engineTemp + 40);
-    // Throttle Position - byte 4 (correlate with speed)
-    engineData[4] = static_cast<char>(qMin(100, m_speed * 2));
-    // Engine Oil Pressure - bytes 5-6 (not critical for simulation)
-    engineData[5] = static_cast<char>(150); // Low byte of reasonable pressure
-    engineData[6] = static_cast<char>(0);   // High byte
-    // Fuel Level - byte 7, scale 0.392157, so divide by 0.392157 for raw
-    engineData[7] = static_cast<char>(m_fuelLevel / 0.392157);
-    emit frameReceived(0x100, engineData);
-
-    // 0x200: Vehicle_Speed - 8 bytes
-    QByteArray speedData(8, 0);
-    // Vehicle Speed - bytes 0-1, scale 0.1, so multiply by 10 for raw value
-    quint16 speedRaw = m_speed * 10;
-    speedData[0] = static_cast<char>(speedRaw & 0xFF);
-    speedData[1] = static_cast<char>((speedRaw >> 8) & 0xFF);
-    // Wheel speeds (simulate same as vehicle speed)
-    speedData[2] = speedData[0]; // Wheel FL low
-    speedData[3] = speedData[1]; // Wheel FL high  
-    speedData[4] = speedData[0]; // Wheel FR low
-    speedData[5] = speedData[1]; // Wheel FR high
-    speedData[6] = speedData[0]; // Wheel RL low
-    speedData[7] = speedData[1]; // Wheel RL high
-    emit frameReceived(0x200, speedData);
-
-    // 0x400: Transmission_Data - 8 bytes
-    QByteArray transData(8, 0);
-    // Gear position in lower 4 bits (simulate Drive = 3)
-    quint8 gearValue = (m_speed > 0) ? 3 : 0; // Drive if moving, Park if stopped
-    transData[0] = static_cast<char>(gearValue & 0x0F);
-    // Park status in bit 1 of byte 2
-    quint8 parkStatus = (m_speed == 0) ? 0x02 : 0x00;
-    transData[2] = static_cast<char>(parkStatus);
-    emit frameReceived(0x400, transData);
-
-    // 0x500: Battery_Status - 8 bytes  
-    QByteArray batteryData(8, 0);
-    // Battery voltage - bytes 0-1, scale 0.01, so multiply by 100 for raw
-    quint16 voltageRaw = 1400; // 14.0V typical running voltage
-    if (!m_engineRunning) voltageRaw = 1200; // 12.0V when engine off
-    batteryData[0] = static_cast<char>(voltageRaw & 0xFF);
-    batteryData[1] = static_cast<char>((voltageRaw >> 8) & 0xFF);
-    emit frameReceived(0x500, batteryData);
-
-    // 0x600: Warning_Lights - 8 bytes
-    QByteArray signalsData(8, 0);
-    // Warnings in byte 0 (not used in current simulation)
-    signalsData[0] = 0;
-    // Signal bits in byte 1
-    quint8 signalBits = 0;
-    if (m_leftTurnSignal) signalBits |= 0x01;
-    if (m_rightTurnSignal) signalBits |= 0x02;
-    if (m_headlights) signalBits |= 0x04;
-    signalsData[1] = static_cast<char>(signalBits);
-    emit frameReceived(0x600, signalsData);
-}
-
-void CanBusController::setupSimulatedData()
-{
-    // Initialize with realistic starting values
-    m_speed = 0;
-    m_rpm = 800; // Idle RPM
-    m_fuelLevel = 85; // 85% fuel
-    m_engineTemp = 90; // Normal operating temperature
-    m_leftTurnSignal = false;
-    m_rightTurnSignal = false;
-    m_headlights = false;
-    m_engineRunning = true; // Engine running by default in simulation
-}
\ No newline at end of file
+    // The read loop has already returned; release the socket as well
+    closeBusDevice();
+    m_connected = false;
+    m_status = "Error: " + errorString;
+    emit connectedChanged(m_connected);
+    emit statusChanged(m_status);
+    emit errorOccurred(errorString);
+}
+#endif
@@ -0,0 +1,415 @@
+#include "canbussimulator.h"
+#include "canframering.h"
+#include "canframe.h"
+#include <QDebug>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+// Messages without a cycle time are sent at this rate
+constexpr int FallbackCycleTimeMs = 100;
+// Shortest period a bus-load target may scale a message down to
+constexpr qint64 MinPeriodNs = 20000;
+// Frames pushed before the consumer is poked, when catching up
+constexpr int MaxBatch = 256;
+
+// Min-heap order on due time; ties by ID keep the sequence deterministic
+struct LaterDue
+{
+    template<typename Message>
+    bool operator()(const Message &a, const Message &b) const
+    {
+        return a.dueNs > b.dueNs || (a.dueNs == b.dueNs && a.id > b.id);
+    }
+};
+}
+
+CanBusSimulator::CanBusSimulator(CanFrameRing *ring, QObject *parent)
+    : QThread(parent)
+    , m_ring(ring)
+    , m_statistics(nullptr)
+    , m_seed(DefaultSeed)
+    , m_bitRate(DefaultBitRate)
+    , m_targetBusLoad(0.0)
+    , m_scheduledBusLoad(0.0)
+    , m_model{}
+    , m_stopRequested(false)
+    , m_framesGenerated(0)
+{
+    setObjectName(QStringLiteral("CanSimulator"));
+}
+
+CanBusSimulator::~CanBusSimulator()
+{
+    stop();
+}
+
+bool CanBusSimulator::loadDbc(const QString &path)
+{
+    DbcDatabase database;
+    if (!database.load(path)) {
+        QMutexLocker locker(&m_configMutex);
+        m_errorString = database.errorString();
+        return false;
+    }
+
+    QMutexLocker locker(&m_configMutex);
+    m_messages = database.messages();
+    m_errorString.clear();
+    return true;
+}
+
+void CanBusSimulator::setSeed(quint64 seed)
+{
+    QMutexLocker locker(&m_configMutex);
+    m_seed = seed;
+}
+
+void CanBusSimulator::setBitRate(int bitsPerSecond)
+{
+    QMutexLocker locker(&m_configMutex);
+    m_bitRate = qMax(10000, bitsPerSecond);
+}
+
+void CanBusSimulator::setTargetBusLoad(double percent)
+{
+    QMutexLocker locker(&m_configMutex);
+    m_targetBusLoad = qBound(0.0, percent, 100.0);
+}
+
+void CanBusSimulator::setCycleTime(quint32 frameId, int cycleTimeMs)
+{
+    QMutexLocker locker(&m_configMutex);
+    if (cycleTimeMs > 0) {
+        m_cycleTimeOverrides.insert(frameId, cycleTimeMs);
+    } else {
+        m_cycleTimeOverrides.remove(frameId);
+    }
+}
+
+QString CanBusSimulator::errorString() const
+{
+    QMutexLocker locker(&m_configMutex);
+    return m_errorString;
+}
+
+double CanBusSimulator::scheduledBusLoad() const
+{
+    QMutexLocker locker(&m_configMutex);
+    return m_scheduledBusLoad;
+}
+
+void CanBusSimulator::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopRequested.store(true);
+        m_wakeCondition.wakeAll();
+    }
+    wait();
+}
+
+int CanBusSimulator::frameBits(int payloadLength, bool extended)
+{
+    return CanFrame::wireBits(payloadLength, extended);
+}
+
+void CanBusSimulator::run()
+{
+    buildSchedule();
+    m_framesGenerated.store(0, std::memory_order_relaxed);
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    const qint64 realtimeStart = CanFrame::currentTimestampNs();
+
+    while (!m_stopRequested.load(std::memory_order_relaxed)) {
+        const qint64 nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - wallStart).count();
+
+        bool pushed = false;
+        int batch = 0;
+        while (!m_schedule.isEmpty() && m_schedule.first().dueNs <= nowNs && batch < MaxBatch) {
+            std::pop_heap(m_schedule.begin(), m_schedule.end(), LaterDue());
+            ScheduledMessage &message = m_schedule.last();
+
+            advanceModel(message.dueNs);
+            CanFrame frame = CanFrame::create(message.id, message.length,
+                                              message.extended ? CanFrame::ExtendedId : 0);
+            for (int i = message.firstSignal; i < message.firstSignal + message.signalCount; ++i) {
+                SignalEncoding &encoding = m_signals[i];
+                encodeSignal(encoding, modelValue(encoding), frame.data);
+            }
+            // Stamped with the scheduled time, not when this thread got to it
+            frame.timestampNs = realtimeStart + message.dueNs;
+
+            if (m_statistics) {
+                m_statistics->recordFrame(frame);
+            }
+            if (m_ring->push(frame)) {
+                pushed = true;
+            } else if (m_statistics) {
+                m_statistics->recordDrop();
+            }
+            m_framesGenerated.fetch_add(1, std::memory_order_relaxed);
+            ++batch;
+
+            message.dueNs += message.periodNs;
+            std::push_heap(m_schedule.begin(), m_schedule.end(), LaterDue());
+        }
+
+        if (pushed && m_ring->markPending()) {
+            emit framesPending();
+        }
+        if (batch == MaxBatch) {
+            continue; // Behind schedule: keep going without sleeping
+        }
+
+        QMutexLocker locker(&m_wakeMutex);
+        if (m_stopRequested.load()) {
+            break;
+        }
+        if (m_schedule.isEmpty()) {
+            m_wakeCondition.wait(&m_wakeMutex);
+            continue;
+        }
+        const qint64 remainingNs = m_schedule.first().dueNs - std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - wallStart).count();
+        if (remainingNs > 0) {
+            QDeadlineTimer deadline(Qt::PreciseTimer);
+            deadline.setPreciseRemainingTime(0, remainingNs, Qt::PreciseTimer);
+            m_wakeCondition.wait(&m_wakeMutex, deadline);
+        }
+    }
+
+    m_stopRequested.store(false);
+}
+
+void CanBusSimulator::buildSchedule()
+{
+    QMutexLocker locker(&m_configMutex);
+
+    m_random.seed(m_seed);
+    m_model = VehicleModel{0, 800, 85, 90, false, false, false, true, 0};
+    m_schedule.clear();
+    m_signals.clear();
+
+    // One virtual ECU per DBC transmitter, each starting at its own phase
+    QHash<QString, int> ecuIndex;
+    QVector<qint64> ecuPhaseNs;
+    double bitsPerSecond = 0.0;
+
+    for (const DbcMessage &dbcMessage : qAsConst(m_messages)) {
+        if (dbcMessage.length <= 0) {
+            continue;
+        }
+
+        int ecu = ecuIndex.value(dbcMessage.transmitter, -1);
+        if (ecu < 0) {
+            ecu = ecuPhaseNs.size();
+            ecuIndex.insert(dbcMessage.transmitter, ecu);
+            ecuPhaseNs.append(static_cast<qint64>(randomInt(0, 1000)) * 100000); // 0-100 ms
+        }
+
+        int cycleTimeMs = m_cycleTimeOverrides.value(dbcMessage.id, dbcMessage.cycleTimeMs);
+        if (cycleTimeMs <= 0) {
+            cycleTimeMs = FallbackCycleTimeMs;
+        }
+
+        ScheduledMessage message;
+        message.periodNs = static_cast<qint64>(cycleTimeMs) * 1000000;
+        message.dueNs = ecuPhaseNs.at(ecu) % message.periodNs;
+        message.id = dbcMessage.id;
+        message.firstSignal = m_signals.size();
+        message.length = static_cast<quint8>(qMin(dbcMessage.length, static_cast<int>(CanFrame::MaxPayload)));
+        message.ecu = static_cast<quint8>(ecu);
+        message.extended = dbcMessage.extended;
+
+        for (const DbcSignal &dbcSignal : dbcMessage.signalList) {
+            // Signals that do not fit the frame cannot be encoded; leave them out
+            const int startByte = dbcSignal.startBit / 8;
+            const int endByte = dbcSignal.bigEndian
+                    ? startByte + (7 - dbcSignal.startBit % 8 + dbcSignal.length - 1) / 8
+                    : (dbcSignal.startBit + dbcSignal.length - 1) / 8;
+            if (endByte >= message.length) {
+                continue;
+            }
+
+            SignalEncoding encoding;
+            encoding.factor = dbcSignal.factor != 0.0 ? dbcSignal.factor : 1.0;
+            encoding.offset = dbcSignal.offset;
+            encoding.minimum = dbcSignal.minimum;
+            encoding.maximum = dbcSignal.maximum;
+            if (encoding.maximum <= encoding.minimum) {
+                // No physical range given: use what the raw bits can hold
+                const double rawMax = dbcSignal.length >= 53 ? 9007199254740991.0 : std::ldexp(1.0, dbcSignal.length) - 1;
+                const double rawMin = dbcSignal.isSigned ? -(rawMax + 1) / 2 : 0.0;
+                const double rawTop = dbcSignal.isSigned ? (rawMax - 1) / 2 : rawMax;
+                encoding.minimum = qMin(rawMin, rawTop) * encoding.factor + encoding.offset;
+                encoding.maximum = qMax(rawMin, rawTop) * encoding.factor + encoding.offset;
+                if (encoding.factor < 0) {
+                    std::swap(encoding.minimum, encoding.maximum);
+                }
+            }
+            encoding.walkValue = qBound(encoding.minimum, 0.0, encoding.maximum);
+            encoding.startBit = static_cast<quint16>(dbcSignal.startBit);
+            encoding.length = static_cast<quint8>(dbcSignal.length);
+            encoding.bigEndian = dbcSignal.bigEndian;
+            encoding.isSigned = dbcSignal.isSigned;
+            encoding.source = valueSourceFor(dbcSignal.name);
+            m_signals.append(encoding);
+        }
+        message.signalCount = m_signals.size() - message.firstSignal;
+
+        bitsPerSecond += frameBits(message.length, message.extended) * 1e9 / message.periodNs;
+        m_schedule.append(message);
+    }
+
+    // Scale every period by the same factor so relative rates stay as in the DBC
+    if (m_targetBusLoad > 0.0 && bitsPerSecond > 0.0) {
+        const double scale = bitsPerSecond / (m_targetBusLoad / 100.0 * m_bitRate);
+        bitsPerSecond = 0.0;
+        for (ScheduledMessage &message : m_schedule) {
+            message.periodNs = qMax(MinPeriodNs, static_cast<qint64>(std::llround(message.periodNs * scale)));
+            message.dueNs %= message.periodNs;
+            bitsPerSecond += frameBits(message.length, message.extended) * 1e9 / message.periodNs;
+        }
+    }
+    m_scheduledBusLoad = bitsPerSecond * 100.0 / m_bitRate;
+
+    std::make_heap(m_schedule.begin(), m_schedule.end(), LaterDue());
+    qDebug() << "CanBusSimulator:" << m_schedule.size() << "messages from" << ecuPhaseNs.size() << "ECUs,"
+             << "seed" << m_seed << "scheduled load" << m_scheduledBusLoad << "% of" << m_bitRate << "bit/s";
+}
+
+void CanBusSimulator::advanceModel(qint64 simulatedNs)
+{
+    while ((m_model.ticks + 1) * ModelTickNs <= simulatedNs) {
+        ++m_model.ticks;
+
+        // Speed variation (0-120 km/h)
+        m_model.speed = qBound(0, m_model.speed + randomInt(-2, 3), 120);
+
+        // RPM correlates with speed and engine state
+        const int targetRpm = 800 + (m_model.speed * 25); // Idle + speed-based RPM
+        m_model.rpm = qBound(700, targetRpm + randomInt(-100, 101), 6000);
+        m_model.engineRunning = (m_model.rpm > 500);
+
+        // Fuel consumption (very slow decrease)
+        if (m_model.speed > 0 && randomInt(0, 1000) < 1) {
+            m_model.fuelLevel = qMax(0, m_model.fuelLevel - 1);
+        }
+
+        // Engine temperature (stable around 90°C)
+        m_model.engineTemp = qBound(70, m_model.engineTemp + randomInt(-1, 2), 110);
+
+        // Random turn signals
+        if (randomInt(0, 100) < 2) {
+            m_model.leftTurnSignal = !m_model.leftTurnSignal;
+            m_model.rightTurnSignal = false;
+        }
+        if (randomInt(0, 100) < 2) {
+            m_model.rightTurnSignal = !m_model.rightTurnSignal;
+            m_model.leftTurnSignal = false;
+        }
+
+        // Headlights change every 30 simulated seconds
+        if (m_model.ticks % 300 == 0) {
+            m_model.headlights = !m_model.headlights;
+        }
+    }
+}
+
+double CanBusSimulator::modelValue(SignalEncoding &encoding)
+{
+    switch (encoding.source) {
+    case EngineSpeed: return m_model.rpm;
+    case EngineLoad: return 50;
+    case CoolantTemperature: return m_model.engineTemp;
+    case Throttle: return qMin(100, m_model.speed * 2);
+    case OilPressure: return 150;
+    case FuelLevel: return m_model.fuelLevel;
+    case VehicleSpeed: return m_model.speed;
+    case GearPosition: return m_model.speed > 0 ? 3 : 0; // Drive if moving, Park if stopped
+    case ParkStatus: return m_model.speed == 0 ? 1 : 0;
+    case BatteryVoltage: return m_model.engineRunning ? 14.0 : 12.0;
+    case LeftTurnSignal: return m_model.leftTurnSignal ? 1 : 0;
+    case RightTurnSignal: return m_model.rightTurnSignal ? 1 : 0;
+    case Headlights: return m_model.headlights ? 1 : 0;
+    case Zero: return 0;
+    case RandomWalk:
+        break;
+    }
+
+    // One raw step up, down or none per transmission
+    encoding.walkValue = qBound(encoding.minimum, encoding.walkValue + randomInt(-1, 2) * encoding.factor,
+                                encoding.maximum);
+    return encoding.walkValue;
+}
+
+void CanBusSimulator::encodeSignal(const SignalEncoding &encoding, double value, quint8 *payload)
+{
+    const quint64 mask = encoding.length >= 64 ? ~quint64(0) : ((quint64(1) << encoding.length) - 1);
+    qint64 raw = std::llround((value - encoding.offset) / encoding.factor);
+    if (encoding.length < 64) {
+        const qint64 low = encoding.isSigned ? -(qint64(1) << (encoding.length - 1)) : 0;
+        const qint64 high = encoding.isSigned ? (qint64(1) << (encoding.length - 1)) - 1 : static_cast<qint64>(mask);
+        raw = qBound(low, raw, high);
+    }
+    const quint64 bits = static_cast<quint64>(raw) & mask;
+
+    // Mirror of CanDecodeTable's bit-by-bit path
+    int bit = encoding.startBit;
+    for (int i = 0; i < encoding.length; ++i) {
+        const int source = encoding.bigEndian ? encoding.length - 1 - i : i;
+        const quint8 bitMask = static_cast<quint8>(1u << (bit % 8));
+        if ((bits >> source) & 1u) {
+            payload[bit / 8] |= bitMask;
+        } else {
+            payload[bit / 8] &= static_cast<quint8>(~bitMask);
+        }
+        if (encoding.bigEndian) {
+            bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+        } else {
+            ++bit;
+        }
+    }
+}
+
+CanBusSimulator::ValueSource CanBusSimulator::valueSourceFor(const QString &signalName)
+{
+    static const QHash<QString, ValueSource> sources = {
+        { QStringLiteral("EngineSpeed"), EngineSpeed },
+        { QStringLiteral("EngineLoad"), EngineLoad },
+        { QStringLiteral("EngineCoolantTemp"), CoolantTemperature },
+        { QStringLiteral("ThrottlePosition"), Throttle },
+        { QStringLiteral("EngineOilPressure"), OilPressure },
+        { QStringLiteral("FuelLevel"), FuelLevel },
+        { QStringLiteral("VehicleSpeed"), VehicleSpeed },
+        { QStringLiteral("WheelSpeedFL"), VehicleSpeed },
+        { QStringLiteral("WheelSpeedFR"), VehicleSpeed },
+        { QStringLiteral("WheelSpeedRL"), VehicleSpeed },
+        { QStringLiteral("GearPosition"), GearPosition },
+        { QStringLiteral("ParkStatus"), ParkStatus },
+        { QStringLiteral("BatteryVoltage"), BatteryVoltage },
+        { QStringLiteral("LeftTurnSignal"), LeftTurnSignal },
+        { QStringLiteral("RightTurnSignal"), RightTurnSignal },
+        { QStringLiteral("Headlights"), Headlights },
+        { QStringLiteral("WarningFlags"), Zero },
+        { QStringLiteral("DoorOpenMask"), Zero }
+    };
+    return sources.value(signalName, RandomWalk);
+}
+
+int CanBusSimulator::randomInt(int low, int high)
+{
+    // Plain modulo rather than std::uniform_int_distribution, whose output
+    // differs between standard libraries and would break seed reproducibility
+    return low + static_cast<int>(m_random() % static_cast<quint64>(high - low));
+}
@@ -0,0 +1,216 @@
+#include "canbusstatistics.h"
+#include <QHash>
+#include <QMutexLocker>
+#include <algorithm>
+#include <chrono>
+
+const qint64 CanBusStatistics::JitterBoundsUs[CanBusStatistics::JitterBuckets - 1] = {
+    10, 50, 100, 500, 1000, 5000, 10000
+};
+
+CanBusStatistics::Shard::Shard(const QString &name)
+    : m_name(name)
+{
+}
+
+CanBusStatistics::Shard::~Shard()
+{
+    delete[] m_ids.load(std::memory_order_acquire);
+}
+
+CanBusStatistics::CanBusStatistics()
+    : m_bitRate(500000)
+{
+}
+
+CanBusStatistics::~CanBusStatistics() = default;
+
+CanBusStatistics::Shard *CanBusStatistics::createShard(const QString &name)
+{
+    QMutexLocker locker(&m_shardMutex);
+    m_shards.push_back(std::make_unique<Shard>(name));
+    return m_shards.back().get();
+}
+
+void CanBusStatistics::setBitRate(int bitsPerSecond)
+{
+    m_bitRate.store(qMax(1, bitsPerSecond), std::memory_order_relaxed);
+}
+
+CanBusStatistics::Sample CanBusStatistics::collect()
+{
+    Sample sample;
+    sample.timestampNs = CanFrame::currentTimestampNs();
+    sample.bitRate = bitRate();
+    const qint64 steadyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    QHash<quint32, int> idIndex;
+    {
+        QMutexLocker locker(&m_shardMutex);
+        for (const std::unique_ptr<Shard> &shard : m_shards) {
+            ThreadSample thread;
+            thread.name = shard->m_name;
+            thread.frames = shard->m_frames.load(std::memory_order_relaxed);
+            thread.errorFrames = shard->m_errorFrames.load(std::memory_order_relaxed);
+            thread.drops = shard->m_drops.load(std::memory_order_relaxed);
+            thread.decodedFrames = shard->m_decodedFrames.load(std::memory_order_relaxed);
+            thread.decodeNs = shard->m_decodeNs.load(std::memory_order_relaxed);
+            thread.decodeMaxNs = shard->m_decodeMaxNs.load(std::memory_order_relaxed);
+            sample.frames += thread.frames;
+            sample.errorFrames += thread.errorFrames;
+            sample.drops += thread.drops;
+            sample.decodedFrames += thread.decodedFrames;
+            sample.decodeNs += thread.decodeNs;
+            sample.bits += shard->m_bits.load(std::memory_order_relaxed);
+            sample.threads.append(thread);
+
+            const Shard::IdCounters *table = shard->m_ids.load(std::memory_order_acquire);
+            if (!table) {
+                continue;
+            }
+            for (int slot = 0; slot < Shard::IdSlots; ++slot) {
+                const Shard::IdCounters &entry = table[slot];
+                const quint32 id = entry.id.load(std::memory_order_acquire);
+                if (id == Shard::EmptyId) {
+                    continue;
+                }
+                // The same ID seen by several sources (e.g. bus, then replay) adds up
+                int index = idIndex.value(id, -1);
+                if (index < 0) {
+                    index = sample.ids.size();
+                    idIndex.insert(id, index);
+                    sample.ids.append(IdSample());
+                    sample.ids[index].id = id;
+                }
+                IdSample &idSample = sample.ids[index];
+                idSample.frames += entry.frames.load(std::memory_order_relaxed);
+                idSample.bits += entry.bits.load(std::memory_order_relaxed);
+                idSample.jitterSumNs += entry.jitterSumNs.load(std::memory_order_relaxed);
+                for (int bucket = 0; bucket < JitterBuckets; ++bucket) {
+                    idSample.jitter[bucket] += entry.jitter[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+    std::sort(sample.ids.begin(), sample.ids.end(), [](const IdSample &a, const IdSample &b) {
+        return a.id < b.id;
+    });
+
+    // Rates over the interval since the previous sample
+    if (m_previousSteadyNs > 0) {
+        sample.intervalNs = steadyNs - m_previousSteadyNs;
+    }
+    if (sample.intervalNs > 0) {
+        const double seconds = sample.intervalNs / 1e9;
+        const double capacity = seconds * sample.bitRate / 100.0; // Bits per percent
+        sample.frameRate = (sample.frames - m_previous.frames) / seconds;
+        sample.busLoad = (sample.bits - m_previous.bits) / capacity;
+        const quint64 decoded = sample.decodedFrames - m_previous.decodedFrames;
+        sample.decodeNsPerFrame = decoded ? double(sample.decodeNs - m_previous.decodeNs) / decoded : 0.0;
+
+        // Both lists are sorted by ID
+        int previous = 0;
+        for (IdSample &idSample : sample.ids) {
+            while (previous < m_previous.ids.size() && m_previous.ids.at(previous).id < idSample.id) {
+                ++previous;
+            }
+            const bool known = previous < m_previous.ids.size() && m_previous.ids.at(previous).id == idSample.id;
+            const quint64 frames = known ? m_previous.ids.at(previous).frames : 0;
+            const quint64 bits = known ? m_previous.ids.at(previous).bits : 0;
+            idSample.frameRate = (idSample.frames - frames) / seconds;
+            idSample.busLoad = (idSample.bits - bits) / capacity;
+        }
+    }
+
+    m_previous = sample;
+    m_previousSteadyNs = steadyNs;
+    return sample;
+}
+
+QByteArray CanBusStatistics::toPrometheus(const Sample &sample)
+{
+    QByteArray out;
+    out.reserve(4096 + sample.ids.size() * 1024);
+
+    auto header = [&out](const char *name, const char *type, const char *help) {
+        out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+        out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+    };
+    auto idLabel = [](quint32 id) {
+        const bool extended = (id & CanFrame::ExtendedIdFlag) != 0;
+        return QByteArray("id=\"0x") + QByteArray::number(id & ~CanFrame::ExtendedIdFlag, 16)
+                + "\",extended=\"" + (extended ? "true" : "false") + '"';
+    };
+    auto threadLabel = [](const QString &name) {
+        return QByteArray("thread=\"") + name.toUtf8() + '"';
+    };
+    auto line = [&out](const char *name, const QByteArray &labels, const QByteArray &value) {
+        out += name;
+        if (!labels.isEmpty()) {
+            out += '{'; out += labels; out += '}';
+        }
+        out += ' '; out += value; out += '\n';
+    };
+    auto real = [](double value) { return QByteArray::number(value, 'g', 12); };
+
+    header("vehiclesys_can_bus_load_percent", "gauge", "Estimated bus load over the last interval, worst-case stuffing.");
+    line("vehiclesys_can_bus_load_percent", QByteArray(), real(sample.busLoad));
+    header("vehiclesys_can_bit_rate", "gauge", "Nominal bit rate the bus load refers to.");
+    line("vehiclesys_can_bit_rate", QByteArray(), QByteArray::number(sample.bitRate));
+
+    header("vehiclesys_can_frames_total", "counter", "Frames received per CAN ID.");
+    for (const IdSample &id : sample.ids) {
+        line("vehiclesys_can_frames_total", idLabel(id.id), QByteArray::number(id.frames));
+    }
+    header("vehiclesys_can_bits_total", "counter", "Estimated wire bits per CAN ID.");
+    for (const IdSample &id : sample.ids) {
+        line("vehiclesys_can_bits_total", idLabel(id.id), QByteArray::number(id.bits));
+    }
+    header("vehiclesys_can_frame_rate", "gauge", "Frames per second per CAN ID over the last interval.");
+    for (const IdSample &id : sample.ids) {
+        line("vehiclesys_can_frame_rate", idLabel(id.id), real(id.frameRate));
+    }
+
+    header("vehiclesys_can_jitter_seconds", "histogram",
+           "Deviation of each inter-arrival gap from the ID's mean gap.");
+    for (const IdSample &id : sample.ids) {
+        const QByteArray label = idLabel(id.id);
+        quint64 cumulative = 0;
+        for (int bucket = 0; bucket < JitterBuckets; ++bucket) {
+            cumulative += id.jitter[bucket];
+            const QByteArray bound = bucket < JitterBuckets - 1
+                    ? real(JitterBoundsUs[bucket] / 1e6) : QByteArray("+Inf");
+            line("vehiclesys_can_jitter_seconds_bucket", label + ",le=\"" + bound + '"',
+                 QByteArray::number(cumulative));
+        }
+        line("vehiclesys_can_jitter_seconds_sum", label, real(id.jitterSumNs / 1e9));
+        line("vehiclesys_can_jitter_seconds_count", label, QByteArray::number(cumulative));
+    }
+
+    header("vehiclesys_can_thread_frames_total", "counter", "Frames received per source thread.");
+    for (const ThreadSample &thread : sample.threads) {
+        line("vehiclesys_can_thread_frames_total", threadLabel(thread.name), QByteArray::number(thread.frames));
+    }
+    header("vehiclesys_can_error_frames_total", "counter", "CAN error frames per source thread.");
+    for (const ThreadSample &thread : sample.threads) {
+        line("vehiclesys_can_error_frames_total", threadLabel(thread.name), QByteArray::number(thread.errorFrames));
+    }
+    header("vehiclesys_can_ring_drops_total", "counter", "Frames dropped because the ingest ring was full.");
+    for (const ThreadSample &thread : sample.threads) {
+        line("vehiclesys_can_ring_drops_total", threadLabel(thread.name), QByteArray::number(thread.drops));
+    }
+    header("vehiclesys_can_decoded_frames_total", "counter", "Frames handed to the decoder per thread.");
+    for (const ThreadSample &thread : sample.threads) {
+        line("vehiclesys_can_decoded_frames_total", threadLabel(thread.name), QByteArray::number(thread.decodedFrames));
+    }
+    header("vehiclesys_can_decode_seconds_total", "counter", "Time spent decoding per thread.");
+    for (const ThreadSample &thread : sample.threads) {
+        line("vehiclesys_can_decode_seconds_total", threadLabel(thread.name), real(thread.decodeNs / 1e9));
+    }
+    header("vehiclesys_can_decode_batch_max_seconds", "gauge", "Longest single decoded batch per thread.");
+    for (const ThreadSample &thread : sample.threads) {
+        line("vehiclesys_can_decode_batch_max_seconds", threadLabel(thread.name), real(thread.decodeMaxNs / 1e9));
+    }
+    return out;
+}
@@ -0,0 +1,149 @@
+#include "candecodetable.h"
+#include "canframe.h"
+#include "dbcdatabase.h"
+#include <algorithm>
+
+namespace {
+constexpr int StandardIdCount = 0x800;
+}
+
+CanDecodeTable::CanDecodeTable()
+    : m_standardIndex(StandardIdCount, -1)
+{
+}
+
+void CanDecodeTable::clear()
+{
+    m_messages.clear();
+    m_signals.clear();
+    m_signalNames.clear();
+    m_standardIndex.fill(-1, StandardIdCount);
+    m_extendedIds.clear();
+    m_extendedIndex.clear();
+}
+
+void CanDecodeTable::compile(const DbcDatabase &database)
+{
+    clear();
+
+    QVector<QPair<quint32, qint16>> extended;
+    for (const DbcMessage &dbcMessage : database.messages()) {
+        Message message;
+        message.id = dbcMessage.id;
+        message.firstSignal = static_cast<quint16>(m_signals.size());
+        message.signalCount = static_cast<quint16>(dbcMessage.signalList.size());
+        message.multiplexor = -1;
+        message.length = static_cast<quint8>(qBound(0, dbcMessage.length, MaxPayload));
+        message.extended = dbcMessage.extended ? 1 : 0;
+        message.cycleTimeMs = dbcMessage.cycleTimeMs;
+
+        for (const DbcSignal &dbcSignal : dbcMessage.signalList) {
+            Signal signal;
+            signal.mask = dbcSignal.length >= 64 ? ~quint64(0) : ((quint64(1) << dbcSignal.length) - 1);
+            signal.factor = dbcSignal.factor;
+            signal.offset = dbcSignal.offset;
+            signal.multiplexValue = dbcSignal.multiplexValue;
+            signal.startBit = static_cast<quint16>(dbcSignal.startBit);
+            signal.length = static_cast<quint8>(dbcSignal.length);
+            signal.flags = 0;
+            if (dbcSignal.bigEndian) signal.flags |= BigEndian;
+            if (dbcSignal.isSigned) signal.flags |= Signed;
+            if (dbcSignal.multiplexMode == DbcSignal::Multiplexor) signal.flags |= Multiplexor;
+            if (dbcSignal.multiplexMode == DbcSignal::Multiplexed) signal.flags |= Multiplexed;
+
+            const int startByte = dbcSignal.startBit / 8;
+            if (dbcSignal.bigEndian) {
+                // Motorola start bit is the MSB; count its distance from the top of its byte
+                const int bitFromTop = 7 - (dbcSignal.startBit % 8);
+                signal.byteOffset = static_cast<quint16>(startByte);
+                signal.minLength = static_cast<quint16>(startByte + (bitFromTop + dbcSignal.length + 7) / 8);
+                if (bitFromTop + dbcSignal.length > 64) {
+                    signal.flags |= Wide;
+                    signal.shift = 0;
+                } else {
+                    signal.shift = static_cast<quint8>(64 - bitFromTop - dbcSignal.length);
+                }
+            } else {
+                const int bitInByte = dbcSignal.startBit % 8;
+                signal.byteOffset = static_cast<quint16>(startByte);
+                signal.minLength = static_cast<quint16>((dbcSignal.startBit + dbcSignal.length + 7) / 8);
+                if (bitInByte + dbcSignal.length > 64) {
+                    signal.flags |= Wide;
+                    signal.shift = 0;
+                } else {
+                    signal.shift = static_cast<quint8>(bitInByte);
+                }
+            }
+
+            if (signal.flags & Multiplexor) {
+                message.multiplexor = static_cast<qint16>(m_signals.size());
+            }
+            m_signals.append(signal);
+            m_signalNames.append(dbcSignal.name);
+        }
+
+        const qint16 index = static_cast<qint16>(m_messages.size());
+        if (message.extended) {
+            extended.append(qMakePair(message.id, index));
+        } else if (message.id < StandardIdCount) {
+            m_standardIndex[static_cast<int>(message.id)] = index;
+        }
+        m_messages.append(message);
+    }
+
+    std::sort(extended.begin(), extended.end());
+    for (const auto &entry : qAsConst(extended)) {
+        m_extendedIds.append(entry.first);
+        m_extendedIndex.append(entry.second);
+    }
+}
+
+const CanDecodeTable::Message *CanDecodeTable::find(quint32 id, bool extended) const
+{
+    if (!extended) {
+        if (id >= StandardIdCount) {
+            return nullptr;
+        }
+        const qint16 index = m_standardIndex.at(static_cast<int>(id));
+        return index >= 0 ? &m_messages.at(index) : nullptr;
+    }
+
+    const auto it = std::lower_bound(m_extendedIds.constBegin(), m_extendedIds.constEnd(), id);
+    if (it == m_extendedIds.constEnd() || *it != id) {
+        return nullptr;
+    }
+    return &m_messages.at(m_extendedIndex.at(static_cast<int>(it - m_extendedIds.constBegin())));
+}
+
+QList<quint32> CanDecodeTable::frameIds() const
+{
+    QList<quint32> ids;
+    ids.reserve(m_messages.size());
+    for (const Message &message : m_messages) {
+        ids.append(message.extended ? (message.id | CanFrame::ExtendedIdFlag) : message.id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+qint64 CanDecodeTable::wideRawValue(const Signal &signal, const quint8 *payload)
+{
+    quint64 raw = 0;
+    int bit = signal.startBit;
+    if (signal.flags & BigEndian) {
+        // Walk the Motorola sawtooth from the MSB down
+        for (int i = 0; i < signal.length; ++i) {
+            raw = (raw << 1) | ((payload[bit / 8] >> (bit % 8)) & 1u);
+            bit = (bit % 8 == 0) ? bit + 15 : bit - 1;
+        }
+    } else {
+        for (int i = 0; i < signal.length; ++i, ++bit) {
+            raw |= quint64((payload[bit / 8] >> (bit % 8)) & 1u) << i;
+        }
+    }
+
+    if ((signal.flags & Signed) && (raw & ~(signal.mask >> 1))) {
+        raw |= ~signal.mask;
+    }
+    return static_cast<qint64>(raw);
+}
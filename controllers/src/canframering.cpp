@@ -0,0 +1,45 @@
+#include "canframering.h"
+
+CanFrameRing::CanFrameRing(int capacity)
+    : m_head(0)
+    , m_cachedTail(0)
+    , m_pushed(0)
+    , m_dropped(0)
+    , m_highWatermark(0)
+    , m_tail(0)
+    , m_cachedHead(0)
+    , m_pending(false)
+    , m_frames(nullptr)
+    , m_mask(0)
+{
+    reset(capacity);
+}
+
+CanFrameRing::~CanFrameRing()
+{
+    delete[] m_frames;
+}
+
+void CanFrameRing::reset(int capacity)
+{
+    // Round up to a power of two so wrap-around is a mask, not a modulo
+    quint32 size = 2;
+    while (size < static_cast<quint32>(qMax(capacity, 2))) {
+        size <<= 1;
+    }
+
+    if (size != m_mask + 1) {
+        delete[] m_frames;
+        m_frames = new CanFrame[size];
+        m_mask = size - 1;
+    }
+
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+    m_cachedTail = 0;
+    m_cachedHead = 0;
+    m_pushed.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_highWatermark.store(0, std::memory_order_relaxed);
+    m_pending.store(false, std::memory_order_release);
+}
@@ -0,0 +1,193 @@
+#include "caningestworker.h"
+#include "canframering.h"
+#include <QDebug>
+#include <cstring>
+
+#ifdef HAVE_QT_SERIALBUS
+#include <QCanBus>
+#include <QCanBusFrame>
+#endif
+
+CanIngestWorker::CanIngestWorker(CanFrameRing *ring, QObject *parent)
+    : QObject(parent)
+    , m_ring(ring)
+    , m_statistics(nullptr)
+#ifdef HAVE_QT_SERIALBUS
+    , m_device(nullptr)
+#endif
+{
+}
+
+CanIngestWorker::~CanIngestWorker()
+{
+    closeDevice();
+}
+
+bool CanIngestWorker::openDevice(const QString &plugin, const QString &interface)
+{
+#ifdef HAVE_QT_SERIALBUS
+    closeDevice();
+
+    // Created here so the device's socket notifier lives on the ingest thread
+    m_device = QCanBus::instance()->createDevice(plugin, interface);
+
+    if (!m_device) {
+        qDebug() << "Failed to create CAN device for interface:" << interface;
+        // Check available devices
+        QString errorString;
+        auto availableDevices = QCanBus::instance()->availableDevices(plugin, &errorString);
+        qDebug() << "Available devices:" << availableDevices.size();
+        for (const auto &device : availableDevices) {
+            qDebug() << "  -" << device.name() << device.description();
+        }
+        return false;
+    }
+
+    connect(m_device, &QCanBusDevice::framesReceived, this, &CanIngestWorker::readFrames);
+    connect(m_device, &QCanBusDevice::errorOccurred, this, &CanIngestWorker::handleDeviceError);
+    connect(m_device, &QCanBusDevice::stateChanged, this, &CanIngestWorker::stateChanged);
+    m_device->setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    // Error frames are only delivered on request, as with CAN_RAW_ERR_FILTER
+    // in SocketCanReader; readFrames() counts them
+    m_device->setConfigurationParameter(QCanBusDevice::ErrorFilterKey,
+                                        QVariant::fromValue(QCanBusFrame::FrameErrors(QCanBusFrame::AnyError)));
+    applyFrameIdFilter();
+
+    if (!m_device->connectDevice()) {
+        delete m_device;
+        m_device = nullptr;
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(plugin)
+    Q_UNUSED(interface)
+    return false;
+#endif
+}
+
+void CanIngestWorker::closeDevice()
+{
+#ifdef HAVE_QT_SERIALBUS
+    if (m_device) {
+        m_device->disconnect(this);
+        m_device->disconnectDevice();
+        delete m_device;
+        m_device = nullptr;
+    }
+#endif
+}
+
+void CanIngestWorker::writeFrame(quint32 frameId, const QByteArray &data)
+{
+#ifdef HAVE_QT_SERIALBUS
+    if (!m_device) {
+        return;
+    }
+
+    // Sets the extended format itself for IDs over 0x7FF
+    QCanBusFrame frame(frameId & ~CanFrame::ExtendedIdFlag, data);
+    if (frameId & CanFrame::ExtendedIdFlag) {
+        frame.setExtendedFrameFormat(true);
+    }
+    if (data.size() > 8) {
+        frame.setFlexibleDataRateFormat(true);
+        frame.setBitrateSwitch(true);
+    }
+    m_device->writeFrame(frame);
+#else
+    Q_UNUSED(frameId)
+    Q_UNUSED(data)
+#endif
+}
+
+void CanIngestWorker::setFrameIdFilter(const QList<quint32> &frameIds)
+{
+    m_frameIdFilter = frameIds;
+#ifdef HAVE_QT_SERIALBUS
+    if (m_device) {
+        applyFrameIdFilter();
+    }
+#endif
+}
+
+#ifdef HAVE_QT_SERIALBUS
+void CanIngestWorker::applyFrameIdFilter()
+{
+    // The socketcan plugin turns these into a CAN_RAW_FILTER list
+    QList<QCanBusDevice::Filter> filters;
+    filters.reserve(m_frameIdFilter.size());
+    for (quint32 frameId : qAsConst(m_frameIdFilter)) {
+        QCanBusDevice::Filter filter;
+        filter.frameId = frameId & ~CanFrame::ExtendedIdFlag;
+        filter.type = QCanBusFrame::DataFrame;
+        if (frameId & CanFrame::ExtendedIdFlag) {
+            filter.frameIdMask = 0x1FFFFFFFu;
+            filter.format = QCanBusDevice::Filter::MatchExtendedFormat;
+        } else {
+            filter.frameIdMask = 0x7FFu;
+            filter.format = QCanBusDevice::Filter::MatchBaseFormat;
+        }
+        filters.append(filter);
+    }
+
+    // An empty list restores the plugin's accept-all default
+    m_device->setConfigurationParameter(QCanBusDevice::RawFilterKey, QVariant::fromValue(filters));
+}
+
+void CanIngestWorker::readFrames()
+{
+    if (!m_device) {
+        return;
+    }
+
+    bool pushed = false;
+    while (m_device->framesAvailable()) {
+        const QCanBusFrame busFrame = m_device->readFrame();
+        if (!busFrame.isValid()) {
+            continue;
+        }
+        if (busFrame.frameType() == QCanBusFrame::ErrorFrame) {
+            if (m_statistics) {
+                m_statistics->recordErrorFrame();
+            }
+            continue;
+        }
+
+        const QByteArray payload = busFrame.payload();
+        // Zeroed: the payload past length goes into recordings as is
+        CanFrame frame;
+        std::memset(&frame, 0, sizeof(frame));
+        frame.id = busFrame.frameId();
+        frame.length = static_cast<quint8>(qMin(payload.size(), static_cast<int>(CanFrame::MaxPayload)));
+        if (busFrame.hasExtendedFrameFormat()) frame.flags |= CanFrame::ExtendedId;
+        if (busFrame.hasFlexibleDataRateFormat()) frame.flags |= CanFrame::FlexibleData;
+        if (busFrame.hasBitrateSwitch()) frame.flags |= CanFrame::BitRateSwitch;
+        if (busFrame.hasErrorStateIndicator()) frame.flags |= CanFrame::ErrorState;
+        if (busFrame.frameType() == QCanBusFrame::RemoteRequestFrame) frame.flags |= CanFrame::RemoteRequest;
+        std::memcpy(frame.data, payload.constData(), frame.length);
+        const QCanBusFrame::TimeStamp stamp = busFrame.timeStamp();
+        frame.timestampNs = stamp.seconds() * 1000000000LL + stamp.microSeconds() * 1000LL;
+        if (m_statistics) {
+            m_statistics->recordFrame(frame);
+        }
+        if (m_ring->push(frame)) {
+            pushed = true;
+        } else if (m_statistics) {
+            m_statistics->recordDrop();
+        }
+    }
+
+    if (pushed && m_ring->markPending()) {
+        emit framesPending();
+    }
+}
+
+void CanIngestWorker::handleDeviceError(QCanBusDevice::CanBusError error)
+{
+    Q_UNUSED(error)
+    if (m_device) {
+        emit errorOccurred(m_device->errorString());
+    }
+}
+#endif
@@ -0,0 +1,242 @@
+#include "canlogreader.h"
+#include <QFile>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CanLogReader::CanLogReader()
+    : m_map(nullptr)
+    , m_mapSize(0)
+    , m_fd(-1)
+    , m_recordCount(0)
+{
+}
+
+CanLogReader::~CanLogReader()
+{
+    close();
+}
+
+bool CanLogReader::open(const QString &path)
+{
+    close();
+
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        m_errorString = QStringLiteral("Cannot open %1: %2").arg(path, QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(m_fd, &info) < 0 || info.st_size < CanLog::HeaderSize) {
+        m_errorString = QStringLiteral("%1 is not a CAN log").arg(path);
+        close();
+        return false;
+    }
+
+    m_mapSize = info.st_size;
+    void *map = ::mmap(nullptr, static_cast<size_t>(m_mapSize), PROT_READ, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        m_errorString = QStringLiteral("Cannot map %1: %2").arg(path, QString::fromLocal8Bit(std::strerror(errno)));
+        m_mapSize = 0;
+        close();
+        return false;
+    }
+    m_map = static_cast<const uchar *>(map);
+
+    const CanLog::FileHeader &fileHeader = header();
+    if (std::memcmp(fileHeader.magic, CanLog::Magic, sizeof(CanLog::Magic)) != 0
+            || fileHeader.version != CanLog::Version
+            || fileHeader.recordSize != CanLog::RecordSize
+            || fileHeader.groupSlots != CanLog::GroupSlots) {
+        m_errorString = QStringLiteral("%1: unsupported CAN log format").arg(path);
+        close();
+        return false;
+    }
+
+    // Never trust the count beyond what the file actually holds
+    const qint64 dataBytes = m_mapSize - CanLog::HeaderSize;
+    const quint64 fullGroups = static_cast<quint64>(dataBytes / CanLog::GroupBytes);
+    const quint64 trailingSlots = static_cast<quint64>((dataBytes % CanLog::GroupBytes) / CanLog::RecordSize);
+    const quint64 capacity = fullGroups * CanLog::RecordsPerGroup + (trailingSlots > 0 ? trailingSlots - 1 : 0);
+    m_recordCount = qMin(fileHeader.recordCount, capacity);
+
+    m_path = path;
+    m_errorString.clear();
+    return true;
+}
+
+void CanLogReader::close()
+{
+    if (m_map) {
+        ::munmap(const_cast<uchar *>(m_map), static_cast<size_t>(m_mapSize));
+        m_map = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_mapSize = 0;
+    m_recordCount = 0;
+}
+
+qint64 CanLogReader::startTimestampNs() const
+{
+    return m_recordCount > 0 ? record(0).timestampNs : 0;
+}
+
+qint64 CanLogReader::endTimestampNs() const
+{
+    return m_recordCount > 0 ? record(m_recordCount - 1).timestampNs : 0;
+}
+
+bool CanLogReader::closedCleanly() const
+{
+    return m_map && (header().flags & CanLog::CleanClose);
+}
+
+void CanLogReader::prefetch(quint64 first, quint64 count) const
+{
+    adviseRecords(first, count, MADV_WILLNEED);
+}
+
+void CanLogReader::release(quint64 first, quint64 count) const
+{
+    // Read-only shared mapping: this only unmaps our pages, the page cache keeps the data
+    adviseRecords(first, count, MADV_DONTNEED);
+}
+
+void CanLogReader::adviseRecords(quint64 first, quint64 count, int advice) const
+{
+    if (!m_map || first >= m_recordCount || count == 0) {
+        return;
+    }
+
+    const quint64 last = qMin(m_recordCount, first + count) - 1;
+    static const qint64 pageSize = ::sysconf(_SC_PAGESIZE);
+    const qint64 begin = CanLog::recordOffset(first) / pageSize * pageSize;
+    qint64 end = qMin(m_mapSize, CanLog::recordOffset(last) + CanLog::RecordSize);
+    if (advice == MADV_DONTNEED) {
+        // Keep the page shared with the records that follow
+        end = end / pageSize * pageSize;
+    }
+    if (end <= begin) {
+        return;
+    }
+    ::madvise(const_cast<uchar *>(m_map) + begin, static_cast<size_t>(end - begin), advice);
+}
+
+quint64 CanLogReader::lowerBound(qint64 timestampNs) const
+{
+    if (m_recordCount == 0) {
+        return 0;
+    }
+
+    // Locate the group through its index block; a group left without one
+    // by a crash falls back to its last record
+    const quint64 groupCount = (m_recordCount + CanLog::RecordsPerGroup - 1) / CanLog::RecordsPerGroup;
+    auto groupEnd = [this](quint64 group) {
+        return qMin(m_recordCount, (group + 1) * CanLog::RecordsPerGroup);
+    };
+    auto groupLastTimestamp = [this, &groupEnd](quint64 group) {
+        const auto *index = reinterpret_cast<const CanLog::IndexBlock *>(m_map + CanLog::indexOffset(group));
+        if (index->magic == CanLog::IndexMagic && index->recordCount > 0) {
+            return index->lastTimestampNs;
+        }
+        return record(groupEnd(group) - 1).timestampNs;
+    };
+
+    quint64 low = 0;
+    quint64 high = groupCount;
+    while (low < high) {
+        const quint64 middle = (low + high) / 2;
+        if (groupLastTimestamp(middle) < timestampNs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == groupCount) {
+        return m_recordCount;
+    }
+
+    quint64 first = low * CanLog::RecordsPerGroup;
+    quint64 last = groupEnd(low);
+    while (first < last) {
+        const quint64 middle = (first + last) / 2;
+        if (record(middle).timestampNs < timestampNs) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+bool CanLogReader::exportCandump(const QString &outputPath, const QString &interfaceName)
+{
+    if (!m_map) {
+        m_errorString = QStringLiteral("No log open");
+        return false;
+    }
+
+    QFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = QStringLiteral("Cannot write %1: %2").arg(outputPath, output.errorString());
+        return false;
+    }
+
+    ::madvise(const_cast<uchar *>(m_map), static_cast<size_t>(m_mapSize), MADV_SEQUENTIAL);
+
+    static const char hexDigits[] = "0123456789ABCDEF";
+    const QByteArray interface = interfaceName.toLatin1();
+    QByteArray buffer;
+    buffer.reserve(1 << 20);
+    char line[256];
+
+    for (quint64 i = 0; i < m_recordCount; ++i) {
+        const CanLog::Record &entry = record(i);
+        const qint64 micros = entry.timestampNs / 1000;
+        int length = std::snprintf(line, sizeof(line), (entry.flags & CanFrame::ExtendedId) ? "(%lld.%06lld) %s %08X#"
+                                                                                           : "(%lld.%06lld) %s %03X#",
+                                   static_cast<long long>(micros / 1000000), static_cast<long long>(micros % 1000000),
+                                   interface.constData(), entry.id);
+
+        if (entry.flags & CanFrame::FlexibleData) {
+            // "##" then one hex digit of FD flags: 1 = BRS, 2 = ESI
+            int fdFlags = 0;
+            if (entry.flags & CanFrame::BitRateSwitch) fdFlags |= 0x1;
+            if (entry.flags & CanFrame::ErrorState) fdFlags |= 0x2;
+            line[length++] = '#';
+            line[length++] = hexDigits[fdFlags];
+        } else if (entry.flags & CanFrame::RemoteRequest) {
+            line[length++] = 'R';
+        }
+
+        if (!(entry.flags & CanFrame::RemoteRequest)) {
+            const int payloadLength = qMin<int>(entry.length, CanFrame::MaxPayload);
+            for (int byte = 0; byte < payloadLength; ++byte) {
+                line[length++] = hexDigits[entry.data[byte] >> 4];
+                line[length++] = hexDigits[entry.data[byte] & 0x0F];
+            }
+        }
+        line[length++] = '\n';
+        buffer.append(line, length);
+
+        if (buffer.size() > (1 << 20) - 256) {
+            output.write(buffer);
+            buffer.clear();
+        }
+    }
+
+    output.write(buffer);
+    if (!output.flush()) {
+        m_errorString = QStringLiteral("Cannot write %1: %2").arg(outputPath, output.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,156 @@
+#include "canlogreplayer.h"
+#include "canframering.h"
+#include "canframe.h"
+#include <QDebug>
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <chrono>
+
+namespace {
+// Frames pushed before the consumer is poked
+constexpr int MaxBatch = 256;
+// Records prefetched ahead of the replay position (about 8 MiB)
+constexpr quint64 ReadaheadRecords = (quint64(8) << 20) / CanLog::RecordSize;
+// How long to wait for the consumer to make room in a full ring
+constexpr qint64 BackpressureWaitNs = 500000;
+}
+
+CanLogReplayer::CanLogReplayer(CanFrameRing *ring, QObject *parent)
+    : QThread(parent)
+    , m_ring(ring)
+    , m_statistics(nullptr)
+    , m_speed(1.0)
+    , m_stopRequested(false)
+    , m_framesReplayed(0)
+{
+    setObjectName(QStringLiteral("CanReplay"));
+}
+
+CanLogReplayer::~CanLogReplayer()
+{
+    stop();
+}
+
+bool CanLogReplayer::open(const QString &path)
+{
+    stop();
+    if (!m_reader.open(path)) {
+        m_errorString = m_reader.errorString();
+        return false;
+    }
+
+    qDebug() << "CanLogReplayer:" << m_reader.recordCount() << "frames,"
+             << (m_reader.endTimestampNs() - m_reader.startTimestampNs()) / 1000000 << "ms from" << path
+             << (m_reader.closedCleanly() ? "" : "(not closed cleanly)");
+    m_errorString.clear();
+    return true;
+}
+
+void CanLogReplayer::setSpeed(double speed)
+{
+    m_speed = qMax(0.0, speed);
+}
+
+QString CanLogReplayer::errorString() const
+{
+    return m_errorString;
+}
+
+void CanLogReplayer::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopRequested.store(true);
+        m_wakeCondition.wakeAll();
+    }
+    wait();
+}
+
+void CanLogReplayer::run()
+{
+    m_framesReplayed.store(0, std::memory_order_relaxed);
+
+    const quint64 total = m_reader.recordCount();
+    const double speed = m_speed;
+    const qint64 logStartNs = m_reader.startTimestampNs();
+    const auto wallStart = std::chrono::steady_clock::now();
+    const qint64 realtimeStart = CanFrame::currentTimestampNs();
+
+    quint64 index = 0;
+    quint64 prefetchedUntil = 0;
+
+    while (index < total && !m_stopRequested.load(std::memory_order_relaxed)) {
+        // Keep one window in flight ahead of us and drop the one before last
+        if (index + ReadaheadRecords / 2 >= prefetchedUntil) {
+            m_reader.prefetch(prefetchedUntil, ReadaheadRecords);
+            if (prefetchedUntil >= 2 * ReadaheadRecords) {
+                m_reader.release(prefetchedUntil - 2 * ReadaheadRecords, ReadaheadRecords);
+            }
+            prefetchedUntil += ReadaheadRecords;
+        }
+
+        const qint64 nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - wallStart).count();
+        const int room = qMin(m_ring->freeSpace(), MaxBatch);
+        const qint64 batchTimestamp = speed > 0.0 ? 0 : CanFrame::currentTimestampNs();
+
+        int batch = 0;
+        qint64 nextDueNs = -1;
+        while (batch < room && index < total) {
+            CanFrame frame;
+            m_reader.readFrame(index, &frame);
+            if (speed > 0.0) {
+                const qint64 dueNs = static_cast<qint64>((frame.timestampNs - logStartNs) / speed);
+                if (dueNs > nowNs) {
+                    nextDueNs = dueNs;
+                    break;
+                }
+                frame.timestampNs = realtimeStart + dueNs;
+            } else {
+                frame.timestampNs = batchTimestamp;
+            }
+
+            // Room was checked above, so nothing is dropped
+            if (m_statistics) {
+                m_statistics->recordFrame(frame);
+            }
+            m_ring->push(frame);
+            ++index;
+            ++batch;
+        }
+        m_framesReplayed.store(index, std::memory_order_relaxed);
+
+        if (batch > 0 && m_ring->markPending()) {
+            emit framesPending();
+        }
+        if (batch == MaxBatch || index >= total) {
+            continue;
+        }
+
+        // Either the ring is full or the next frame is not due yet
+        QMutexLocker locker(&m_wakeMutex);
+        if (m_stopRequested.load()) {
+            break;
+        }
+        qint64 remainingNs = BackpressureWaitNs;
+        if (nextDueNs >= 0) {
+            remainingNs = nextDueNs - std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - wallStart).count();
+        }
+        if (remainingNs > 0) {
+            QDeadlineTimer deadline(Qt::PreciseTimer);
+            deadline.setPreciseRemainingTime(0, remainingNs, Qt::PreciseTimer);
+            m_wakeCondition.wait(&m_wakeMutex, deadline);
+        }
+    }
+
+    const qint64 elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - wallStart).count();
+    qDebug() << "CanLogReplayer:" << index << "of" << total << "frames in" << elapsedNs / 1000000 << "ms"
+             << "(" << (elapsedNs > 0 ? index * 1e9 / elapsedNs : 0.0) << "frames/s )";
+    m_stopRequested.store(false);
+}
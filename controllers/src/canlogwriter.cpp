@@ -0,0 +1,231 @@
+#include "canlogwriter.h"
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+void prefaultGroup(uchar *map, qint64 mapSize, quint64 group)
+{
+    const qint64 offset = CanLog::indexOffset(group);
+    if (offset >= mapSize) {
+        return;
+    }
+
+    // Groups are page aligned (HeaderSize and GroupBytes are multiples of 4 KiB)
+    void *start = map + offset;
+#ifdef MADV_POPULATE_WRITE
+    if (::madvise(start, CanLog::GroupBytes, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    ::madvise(start, CanLog::GroupBytes, MADV_WILLNEED);
+}
+
+} // namespace
+
+/**
+ * Populating a group takes a few milliseconds of page faults, too long for
+ * the thread that appends frames, so this thread does it ahead of time.
+ */
+class CanLogWriter::Prefaulter : public QThread
+{
+public:
+    Prefaulter(uchar *map, qint64 mapSize, quint64 doneGroup)
+        : m_map(map)
+        , m_mapSize(mapSize)
+        , m_doneGroup(doneGroup)
+        , m_targetGroup(doneGroup)
+        , m_stopRequested(false)
+    {
+        setObjectName(QStringLiteral("CanLogPrefaulter"));
+    }
+
+    ~Prefaulter() override
+    {
+        stop();
+    }
+
+    // Faults in every group up to @p group that is not already
+    void request(quint64 group)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (group > m_targetGroup) {
+            m_targetGroup = group;
+            m_wake.wakeOne();
+        }
+    }
+
+    // The mapping must stay valid until this returns
+    void stop()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopRequested = true;
+            m_wake.wakeOne();
+        }
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&m_mutex);
+        for (;;) {
+            while (!m_stopRequested && m_doneGroup >= m_targetGroup) {
+                m_wake.wait(&m_mutex);
+            }
+            if (m_stopRequested) {
+                return;
+            }
+            const quint64 group = ++m_doneGroup;
+            locker.unlock();
+            prefaultGroup(m_map, m_mapSize, group);
+            locker.relock();
+        }
+    }
+
+private:
+    uchar *const m_map;
+    const qint64 m_mapSize;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    quint64 m_doneGroup;
+    quint64 m_targetGroup;
+    bool m_stopRequested;
+};
+
+CanLogWriter::CanLogWriter()
+    : m_prefaulter(nullptr)
+    , m_map(nullptr)
+    , m_mapSize(0)
+    , m_fd(-1)
+    , m_header(nullptr)
+    , m_nextSlot(nullptr)
+    , m_capacity(0)
+    , m_recordCount(0)
+    , m_droppedCount(0)
+    , m_group(0)
+{
+    std::memset(&m_groupIndex, 0, sizeof(m_groupIndex));
+}
+
+CanLogWriter::~CanLogWriter()
+{
+    close();
+}
+
+bool CanLogWriter::open(const QString &path, qint64 maxBytes)
+{
+    close();
+
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        m_errorString = QStringLiteral("Cannot create %1: %2").arg(path, QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+
+    const qint64 groups = qMax<qint64>(1, (maxBytes - CanLog::HeaderSize) / CanLog::GroupBytes);
+    m_mapSize = CanLog::HeaderSize + groups * CanLog::GroupBytes;
+
+    // Reserve the blocks now: running out of disk under a mapping is SIGBUS, not an error code
+    const int allocateError = ::posix_fallocate(m_fd, 0, m_mapSize);
+    if (allocateError != 0) {
+        m_errorString = QStringLiteral("Cannot reserve %1 bytes for %2: %3")
+                .arg(m_mapSize).arg(path, QString::fromLocal8Bit(std::strerror(allocateError)));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    void *map = ::mmap(nullptr, static_cast<size_t>(m_mapSize), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        m_errorString = QStringLiteral("Cannot map %1: %2").arg(path, QString::fromLocal8Bit(std::strerror(errno)));
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_map = static_cast<uchar *>(map);
+    m_header = reinterpret_cast<CanLog::FileHeader *>(m_map);
+    std::memset(m_header, 0, sizeof(CanLog::FileHeader));
+    std::memcpy(m_header->magic, CanLog::Magic, sizeof(CanLog::Magic));
+    m_header->version = CanLog::Version;
+    m_header->recordSize = CanLog::RecordSize;
+    m_header->groupSlots = CanLog::GroupSlots;
+
+    m_capacity = static_cast<quint64>(groups) * CanLog::RecordsPerGroup;
+    m_recordCount = 0;
+    m_droppedCount = 0;
+    m_group = 0;
+    std::memset(&m_groupIndex, 0, sizeof(m_groupIndex));
+    m_nextSlot = m_map + CanLog::recordOffset(0);
+    m_path = path;
+    m_errorString.clear();
+
+    // The first group is needed right away; the rest are faulted in behind it
+    prefaultGroup(m_map, m_mapSize, 0);
+    m_prefaulter = new Prefaulter(m_map, m_mapSize, 0);
+    m_prefaulter->start(QThread::LowPriority);
+    m_prefaulter->request(PrefaultAhead);
+    return true;
+}
+
+void CanLogWriter::close()
+{
+    if (!m_map) {
+        return;
+    }
+
+    if (m_groupIndex.recordCount > 0) {
+        writeIndexBlock();
+    }
+    m_header->flags |= CanLog::CleanClose;
+
+    delete m_prefaulter;
+    m_prefaulter = nullptr;
+
+    // Drop the unused reservation so the file is only as long as its records
+    const qint64 usedSize = m_recordCount == 0
+            ? CanLog::HeaderSize
+            : CanLog::recordOffset(m_recordCount - 1) + CanLog::RecordSize;
+    ::msync(m_map, static_cast<size_t>(m_mapSize), MS_ASYNC);
+    ::munmap(m_map, static_cast<size_t>(m_mapSize));
+    if (::ftruncate(m_fd, usedSize) < 0) {
+        qWarning() << "CanLogWriter: cannot trim" << m_path << std::strerror(errno);
+    }
+    ::close(m_fd);
+
+    qDebug() << "CanLogWriter:" << m_recordCount << "frames written to" << m_path
+             << "(" << m_droppedCount << "dropped)";
+
+    m_map = nullptr;
+    m_header = nullptr;
+    m_nextSlot = nullptr;
+    m_mapSize = 0;
+    m_fd = -1;
+}
+
+void CanLogWriter::finishGroup()
+{
+    writeIndexBlock();
+
+    ++m_group;
+    std::memset(&m_groupIndex, 0, sizeof(m_groupIndex));
+    m_nextSlot = m_map + CanLog::indexOffset(m_group) + CanLog::RecordSize;
+    m_prefaulter->request(m_group + PrefaultAhead);
+}
+
+void CanLogWriter::writeIndexBlock()
+{
+    m_groupIndex.magic = CanLog::IndexMagic;
+    m_groupIndex.group = static_cast<quint32>(m_group);
+    std::memcpy(m_map + CanLog::indexOffset(m_group), &m_groupIndex, CanLog::RecordSize);
+}
@@ -0,0 +1,130 @@
+#include "canstatisticsmodel.h"
+
+CanStatisticsModel::CanStatisticsModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int CanStatisticsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_sample.ids.size();
+}
+
+QVariant CanStatisticsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_sample.ids.size()) {
+        return QVariant();
+    }
+
+    const CanBusStatistics::IdSample &id = m_sample.ids.at(index.row());
+    quint64 jitterCount = 0;
+    for (int bucket = 0; bucket < CanBusStatistics::JitterBuckets; ++bucket) {
+        jitterCount += id.jitter[bucket];
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case FrameIdRole: return id.id & ~CanFrame::ExtendedIdFlag;
+    case ExtendedRole: return (id.id & CanFrame::ExtendedIdFlag) != 0;
+    case FramesRole: return id.frames;
+    case FrameRateRole: return id.frameRate;
+    case BusLoadRole: return id.busLoad;
+    case JitterMeanRole: return jitterCount ? id.jitterSumNs / 1000.0 / jitterCount : 0.0;
+    case JitterHistogramRole: {
+        QVariantList histogram;
+        for (int bucket = 0; bucket < CanBusStatistics::JitterBuckets; ++bucket) {
+            histogram.append(id.jitter[bucket]);
+        }
+        return histogram;
+    }
+    case Jitter99Role: {
+        // Nearest bucket bound; the histogram has no finer resolution
+        if (jitterCount == 0) {
+            return 0;
+        }
+        const quint64 rank = jitterCount - jitterCount / 100;
+        quint64 cumulative = 0;
+        for (int bucket = 0; bucket < CanBusStatistics::JitterBuckets - 1; ++bucket) {
+            cumulative += id.jitter[bucket];
+            if (cumulative >= rank) {
+                return CanBusStatistics::JitterBoundsUs[bucket];
+            }
+        }
+        return -1;
+    }
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> CanStatisticsModel::roleNames() const
+{
+    return {
+        { FrameIdRole, "frameId" },
+        { ExtendedRole, "extended" },
+        { FramesRole, "frames" },
+        { FrameRateRole, "frameRate" },
+        { BusLoadRole, "busLoad" },
+        { JitterMeanRole, "jitterMean" },
+        { JitterHistogramRole, "jitterHistogram" },
+        { Jitter99Role, "jitter99" }
+    };
+}
+
+QVariantList CanStatisticsModel::threads() const
+{
+    QVariantList result;
+    for (const CanBusStatistics::ThreadSample &thread : m_sample.threads) {
+        QVariantMap entry;
+        entry.insert(QStringLiteral("name"), thread.name);
+        entry.insert(QStringLiteral("frames"), thread.frames);
+        entry.insert(QStringLiteral("errorFrames"), thread.errorFrames);
+        entry.insert(QStringLiteral("drops"), thread.drops);
+        entry.insert(QStringLiteral("decodedFrames"), thread.decodedFrames);
+        entry.insert(QStringLiteral("decodeTimeNs"), thread.decodeNs);
+        entry.insert(QStringLiteral("decodeBatchMaxNs"), thread.decodeMaxNs);
+        result.append(entry);
+    }
+    return result;
+}
+
+QVariantList CanStatisticsModel::jitterBounds() const
+{
+    QVariantList bounds;
+    for (int bucket = 0; bucket < CanBusStatistics::JitterBuckets - 1; ++bucket) {
+        bounds.append(CanBusStatistics::JitterBoundsUs[bucket]);
+    }
+    return bounds;
+}
+
+QVariantMap CanStatisticsModel::get(int row) const
+{
+    QVariantMap result;
+    if (row < 0 || row >= m_sample.ids.size()) {
+        return result;
+    }
+
+    const QModelIndex modelIndex = index(row);
+    const QHash<int, QByteArray> roles = roleNames();
+    for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+        result.insert(QString::fromLatin1(it.value()), data(modelIndex, it.key()));
+    }
+    return result;
+}
+
+void CanStatisticsModel::update(const CanBusStatistics::Sample &sample)
+{
+    // IDs only ever get added, so equal sizes mean the same rows
+    const bool sameRows = sample.ids.size() == m_sample.ids.size();
+    if (sameRows) {
+        m_sample = sample;
+        if (!m_sample.ids.isEmpty()) {
+            emit dataChanged(index(0), index(m_sample.ids.size() - 1));
+        }
+    } else {
+        beginResetModel();
+        m_sample = sample;
+        endResetModel();
+        emit countChanged();
+    }
+    emit updated();
+}
@@ -0,0 +1,215 @@
+#include "dbcdatabase.h"
+#include <QFile>
+#include <QRegularExpression>
+
+namespace {
+// Bit 31 of a DBC message ID marks a 29-bit extended frame
+constexpr quint32 DbcExtendedFlag = 0x80000000u;
+constexpr quint32 ExtendedIdMask = 0x1FFFFFFFu;
+}
+
+bool DbcDatabase::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = QStringLiteral("Cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return parse(file.readAll());
+}
+
+bool DbcDatabase::parse(const QByteArray &text)
+{
+    m_messages.clear();
+    m_defaultCycleTimeMs = 0;
+    m_lineNumber = 0;
+    m_errorString.clear();
+    m_checksum = checksum(text);
+
+    const QList<QByteArray> lines = text.split('\n');
+    for (const QByteArray &rawLine : lines) {
+        ++m_lineNumber;
+        const QByteArray line = rawLine.trimmed();
+
+        if (line.startsWith("BO_ ")) {
+            if (!parseMessage(line)) {
+                return false;
+            }
+        } else if (line.startsWith("SG_ ")) {
+            if (!parseSignal(line)) {
+                return false;
+            }
+        } else if (line.startsWith("BA_ ") || line.startsWith("BA_DEF_DEF_ ")) {
+            parseAttribute(line);
+        } else if (line.startsWith("VAL_ ")) {
+            parseValueTable(line);
+        }
+    }
+
+    // Messages without their own GenMsgCycleTime inherit the default
+    for (DbcMessage &message : m_messages) {
+        if (message.cycleTimeMs < 0) {
+            message.cycleTimeMs = m_defaultCycleTimeMs;
+        }
+    }
+    return true;
+}
+
+quint32 DbcDatabase::checksum(const QByteArray &text)
+{
+    quint32 hash = 2166136261u;
+    for (const char byte : text) {
+        hash ^= static_cast<quint8>(byte);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const DbcMessage *DbcDatabase::message(quint32 id, bool extended) const
+{
+    for (const DbcMessage &message : m_messages) {
+        if (message.id == id && message.extended == extended) {
+            return &message;
+        }
+    }
+    return nullptr;
+}
+
+bool DbcDatabase::parseMessage(const QByteArray &line)
+{
+    // BO_ 256 Engine_Data: 8 ECM
+    static const QRegularExpression pattern(QStringLiteral("^BO_\\s+(\\d+)\\s+(\\w+)\\s*:\\s*(\\d+)\\s*(\\S*)"));
+    const QRegularExpressionMatch match = pattern.match(QString::fromLatin1(line));
+    if (!match.hasMatch()) {
+        m_errorString = QStringLiteral("Line %1: malformed BO_ definition").arg(m_lineNumber);
+        return false;
+    }
+
+    const quint32 rawId = match.captured(1).toUInt();
+    DbcMessage message;
+    message.extended = (rawId & DbcExtendedFlag) != 0;
+    message.id = message.extended ? (rawId & ExtendedIdMask) : rawId;
+    message.name = match.captured(2);
+    message.length = match.captured(3).toInt();
+    message.transmitter = match.captured(4);
+    message.cycleTimeMs = -1;
+    m_messages.append(message);
+    return true;
+}
+
+bool DbcDatabase::parseSignal(const QByteArray &line)
+{
+    //  SG_ EngineSpeed : 0|16@1+ (0.25,0) [0|16383.75] "rpm" IPC
+    //  SG_ Mode M : ...   /   SG_ Value m3 : ...
+    static const QRegularExpression pattern(QStringLiteral(
+        "^SG_\\s+(\\w+)\\s*(M|m\\d+M?)?\\s*:\\s*(\\d+)\\|(\\d+)@([01])([+-])\\s*"
+        "\\(\\s*([^,\\s]+)\\s*,\\s*([^)\\s]+)\\s*\\)\\s*"
+        "\\[\\s*([^|\\s]+)\\s*\\|\\s*([^\\]\\s]+)\\s*\\]\\s*\"([^\"]*)\""));
+
+    if (m_messages.isEmpty()) {
+        m_errorString = QStringLiteral("Line %1: SG_ outside of a BO_ block").arg(m_lineNumber);
+        return false;
+    }
+
+    const QRegularExpressionMatch match = pattern.match(QString::fromLatin1(line));
+    if (!match.hasMatch()) {
+        m_errorString = QStringLiteral("Line %1: malformed SG_ definition").arg(m_lineNumber);
+        return false;
+    }
+
+    DbcSignal dbcSignal;
+    dbcSignal.name = match.captured(1);
+    const QString multiplex = match.captured(2);
+    if (multiplex == QLatin1String("M")) {
+        dbcSignal.multiplexMode = DbcSignal::Multiplexor;
+    } else if (multiplex.startsWith(QLatin1Char('m'))) {
+        dbcSignal.multiplexMode = DbcSignal::Multiplexed;
+        QString value = multiplex.mid(1);
+        if (value.endsWith(QLatin1Char('M'))) {
+            value.chop(1);
+        }
+        dbcSignal.multiplexValue = value.toInt();
+    }
+    dbcSignal.startBit = match.captured(3).toInt();
+    dbcSignal.length = match.captured(4).toInt();
+    dbcSignal.bigEndian = match.captured(5) == QLatin1String("0");
+    dbcSignal.isSigned = match.captured(6) == QLatin1String("-");
+    dbcSignal.factor = match.captured(7).toDouble();
+    dbcSignal.offset = match.captured(8).toDouble();
+    dbcSignal.minimum = match.captured(9).toDouble();
+    dbcSignal.maximum = match.captured(10).toDouble();
+    dbcSignal.unit = match.captured(11);
+
+    if (dbcSignal.length < 1 || dbcSignal.length > 64 || dbcSignal.startBit > 511) {
+        m_errorString = QStringLiteral("Line %1: signal %2 has an invalid layout").arg(m_lineNumber).arg(dbcSignal.name);
+        return false;
+    }
+
+    m_messages.last().signalList.append(dbcSignal);
+    return true;
+}
+
+void DbcDatabase::parseAttribute(const QByteArray &line)
+{
+    // BA_DEF_DEF_ "GenMsgCycleTime" 100;
+    // BA_ "GenMsgCycleTime" BO_ 256 100;
+    static const QRegularExpression defaultPattern(QStringLiteral("^BA_DEF_DEF_\\s+\"GenMsgCycleTime\"\\s+(\\d+)"));
+    static const QRegularExpression valuePattern(QStringLiteral("^BA_\\s+\"GenMsgCycleTime\"\\s+BO_\\s+(\\d+)\\s+(\\d+)"));
+
+    const QString text = QString::fromLatin1(line);
+    QRegularExpressionMatch match = defaultPattern.match(text);
+    if (match.hasMatch()) {
+        m_defaultCycleTimeMs = match.captured(1).toInt();
+        return;
+    }
+
+    match = valuePattern.match(text);
+    if (match.hasMatch()) {
+        if (DbcMessage *message = findMessage(match.captured(1).toUInt())) {
+            message->cycleTimeMs = match.captured(2).toInt();
+        }
+    }
+}
+
+void DbcDatabase::parseValueTable(const QByteArray &line)
+{
+    // VAL_ 1024 GearPosition 0 "P" 1 "R" ... ;
+    static const QRegularExpression headerPattern(QStringLiteral("^VAL_\\s+(\\d+)\\s+(\\w+)"));
+    static const QRegularExpression entryPattern(QStringLiteral("(-?\\d+)\\s+\"([^\"]*)\""));
+
+    const QString text = QString::fromLatin1(line);
+    const QRegularExpressionMatch header = headerPattern.match(text);
+    if (!header.hasMatch()) {
+        return;
+    }
+
+    DbcMessage *message = findMessage(header.captured(1).toUInt());
+    if (!message) {
+        return;
+    }
+
+    const QString signalName = header.captured(2);
+    for (DbcSignal &dbcSignal : message->signalList) {
+        if (dbcSignal.name != signalName) {
+            continue;
+        }
+        QRegularExpressionMatchIterator entries = entryPattern.globalMatch(text, header.capturedEnd());
+        while (entries.hasNext()) {
+            const QRegularExpressionMatch entry = entries.next();
+            dbcSignal.valueNames.insert(entry.captured(1).toLongLong(), entry.captured(2));
+        }
+        return;
+    }
+}
+
+DbcMessage *DbcDatabase::findMessage(quint32 rawId)
+{
+    const bool extended = (rawId & DbcExtendedFlag) != 0;
+    const quint32 id = extended ? (rawId & ExtendedIdMask) : rawId;
+    for (DbcMessage &message : m_messages) {
+        if (message.id == id && message.extended == extended) {
+            return &message;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,311 @@
+#include "latencytracer.h"
+#include "canframe.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+#include <QtAlgorithms>
+#include <cstring>
+
+void LatencyHistogram::record(qint64 ns)
+{
+    ns = qBound<qint64>(0, ns, (qint64(1) << MaxBits) - 1);
+    ++m_buckets[bucketOf(ns)];
+    ++m_count;
+    m_sum += ns;
+    m_max = qMax(m_max, ns);
+}
+
+void LatencyHistogram::clear()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+qint64 LatencyHistogram::percentile(double q) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    const quint64 rank = qMax<quint64>(1, static_cast<quint64>(q * m_count + 0.5));
+    quint64 cumulative = 0;
+    for (int bucket = 0; bucket < Buckets; ++bucket) {
+        cumulative += m_buckets[bucket];
+        if (cumulative >= rank) {
+            return qMin(bucketUpperBound(bucket), m_max);
+        }
+    }
+    return m_max;
+}
+
+int LatencyHistogram::bucketOf(qint64 ns)
+{
+    // Values below SubBuckets are exact; above, the top SubBucketBits + 1
+    // bits select the bucket within its power of two
+    if (ns < SubBuckets) {
+        return static_cast<int>(ns);
+    }
+    const int msb = 63 - qCountLeadingZeroBits(static_cast<quint64>(ns));
+    const int shift = msb - SubBucketBits;
+    return (shift + 1) * SubBuckets + static_cast<int>((ns >> shift) & (SubBuckets - 1));
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket)
+{
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+    const int shift = bucket / SubBuckets - 1;
+    const qint64 mantissa = SubBuckets + bucket % SubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyTracer::LatencyTracer(QObject *parent)
+    : QObject(parent)
+    , m_reportPath(qEnvironmentVariable("VEHICLESYS_LATENCY_REPORT"))
+    , m_recorded(false)
+    , m_updateTimer(new QTimer(this))
+{
+    connect(m_updateTimer, &QTimer::timeout, this, &LatencyTracer::emitUpdated);
+    m_updateTimer->start(1000);
+}
+
+LatencyTracer::~LatencyTracer()
+{
+    if (!m_reportPath.isEmpty()) {
+        writeReport(m_reportPath);
+    }
+}
+
+void LatencyTracer::setSource(QObject *source)
+{
+    m_source = source;
+
+    // A new source stamps nothing yet; tell it what is being traced
+    QStringList names;
+    {
+        QMutexLocker locker(&m_mutex);
+        names = m_traceIndex.keys();
+    }
+    if (m_source) {
+        for (const QString &name : qAsConst(names)) {
+            QMetaObject::invokeMethod(m_source, "traceLatency", Q_ARG(QString, name));
+        }
+    }
+}
+
+void LatencyTracer::attachWindow(QQuickWindow *window)
+{
+    // Both are emitted on the render thread; with the threaded render loop
+    // the GUI thread is blocked during the sync, but not during the swap
+    connect(window, &QQuickWindow::afterSynchronizing,
+            this, &LatencyTracer::handleAfterSynchronizing, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped,
+            this, &LatencyTracer::handleFrameSwapped, Qt::DirectConnection);
+}
+
+void LatencyTracer::markChanged(const QString &signalName)
+{
+    Stamps stamps;
+    stamps.notifiedNs = CanFrame::currentTimestampNs();
+    if (m_source) {
+        QMetaObject::invokeMethod(m_source, "receivedAtNs", Q_RETURN_ARG(qint64, stamps.receivedNs),
+                                  Q_ARG(QString, signalName));
+        QMetaObject::invokeMethod(m_source, "decodedAtNs", Q_RETURN_ARG(qint64, stamps.decodedNs),
+                                  Q_ARG(QString, signalName));
+    }
+
+    bool added = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        int index = m_traceIndex.value(signalName, -1);
+        if (index < 0) {
+            index = m_traces.size();
+            m_traceIndex.insert(signalName, index);
+            m_traces.append(Trace());
+            m_traces.last().name = signalName;
+            added = true;
+        }
+
+        Trace &trace = m_traces[index];
+        if (trace.pending.notifiedNs) {
+            ++trace.superseded;  // The previous value never made it to a frame
+        } else {
+            m_pendingTraces.append(index);
+        }
+        trace.pending = stamps;
+    }
+
+    // Decodes are stamped from now on; this first change has no decode time
+    if (added && m_source) {
+        QMetaObject::invokeMethod(m_source, "traceLatency", Q_ARG(QString, signalName));
+    }
+}
+
+void LatencyTracer::handleAfterSynchronizing()
+{
+    const qint64 synchronizedNs = CanFrame::currentTimestampNs();
+    QMutexLocker locker(&m_mutex);
+    for (int index : qAsConst(m_pendingTraces)) {
+        Trace &trace = m_traces[index];
+        trace.pending.synchronizedNs = synchronizedNs;
+        m_inFlight.append(qMakePair(index, trace.pending));
+        trace.pending = Stamps();
+    }
+    m_pendingTraces.clear();
+}
+
+void LatencyTracer::handleFrameSwapped()
+{
+    const qint64 swappedNs = CanFrame::currentTimestampNs();
+    QMutexLocker locker(&m_mutex);
+    if (m_inFlight.isEmpty()) {
+        return;
+    }
+    for (const QPair<int, Stamps> &entry : qAsConst(m_inFlight)) {
+        recordLocked(m_traces[entry.first], entry.second, swappedNs);
+    }
+    m_inFlight.clear();
+    m_recorded = true;
+}
+
+void LatencyTracer::recordLocked(Trace &trace, const Stamps &stamps, qint64 swappedNs)
+{
+    // A missing stamp (e.g. no receive time) or a clock step drops only
+    // the stages it bounds
+    auto record = [&trace](Stage stage, qint64 fromNs, qint64 toNs) {
+        if (fromNs > 0 && toNs >= fromNs) {
+            trace.stages[stage].record(toNs - fromNs);
+        }
+    };
+    record(ReceiveToDecode, stamps.receivedNs, stamps.decodedNs);
+    record(DecodeToNotify, stamps.decodedNs, stamps.notifiedNs);
+    record(NotifyToSync, stamps.notifiedNs, stamps.synchronizedNs);
+    record(SyncToSwap, stamps.synchronizedNs, swappedNs);
+    record(ReceiveToSwap, stamps.receivedNs, swappedNs);
+}
+
+void LatencyTracer::emitUpdated()
+{
+    bool recorded;
+    {
+        QMutexLocker locker(&m_mutex);
+        recorded = m_recorded;
+        m_recorded = false;
+    }
+    if (recorded) {
+        emit updated();
+    }
+}
+
+QVariantList LatencyTracer::statistics() const
+{
+    auto micros = [](qint64 ns) { return ns / 1000.0; };
+
+    QVariantList result;
+    QMutexLocker locker(&m_mutex);
+    for (const Trace &trace : m_traces) {
+        QVariantMap entry;
+        entry.insert(QStringLiteral("name"), trace.name);
+        entry.insert(QStringLiteral("samples"), trace.stages[NotifyToSync].count());
+        entry.insert(QStringLiteral("superseded"), trace.superseded);
+
+        QVariantList stages;
+        for (int stage = 0; stage < StageCount; ++stage) {
+            const LatencyHistogram &histogram = trace.stages[stage];
+            QVariantMap stageEntry;
+            stageEntry.insert(QStringLiteral("stage"), stageName(static_cast<Stage>(stage)));
+            stageEntry.insert(QStringLiteral("count"), histogram.count());
+            stageEntry.insert(QStringLiteral("p50"), micros(histogram.percentile(0.50)));
+            stageEntry.insert(QStringLiteral("p99"), micros(histogram.percentile(0.99)));
+            stageEntry.insert(QStringLiteral("max"), micros(histogram.max()));
+            stageEntry.insert(QStringLiteral("mean"), histogram.mean() / 1000.0);
+            stages.append(stageEntry);
+        }
+        entry.insert(QStringLiteral("stages"), stages);
+        result.append(entry);
+    }
+    return result;
+}
+
+void LatencyTracer::reset()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        for (Trace &trace : m_traces) {
+            for (LatencyHistogram &histogram : trace.stages) {
+                histogram.clear();
+            }
+            trace.superseded = 0;
+        }
+    }
+    emit updated();
+}
+
+QString LatencyTracer::stageName(Stage stage)
+{
+    switch (stage) {
+    case ReceiveToDecode: return QStringLiteral("receive_to_decode");
+    case DecodeToNotify: return QStringLiteral("decode_to_notify");
+    case NotifyToSync: return QStringLiteral("notify_to_sync");
+    case SyncToSwap: return QStringLiteral("sync_to_swap");
+    case ReceiveToSwap: return QStringLiteral("receive_to_swap");
+    default: return QString();
+    }
+}
+
+QByteArray LatencyTracer::toPrometheus() const
+{
+    QByteArray out;
+    auto seconds = [](qint64 ns) { return QByteArray::number(ns / 1e9, 'g', 12); };
+
+    QMutexLocker locker(&m_mutex);
+    out += "# HELP vehiclesys_latency_seconds Time from CAN receive to the first rendered frame, by stage.\n";
+    out += "# TYPE vehiclesys_latency_seconds summary\n";
+    for (const Trace &trace : m_traces) {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            const LatencyHistogram &histogram = trace.stages[stage];
+            const QByteArray labels = "signal=\"" + trace.name.toUtf8() + "\",stage=\""
+                    + stageName(static_cast<Stage>(stage)).toUtf8() + '"';
+            out += "vehiclesys_latency_seconds{" + labels + ",quantile=\"0.5\"} "
+                    + seconds(histogram.percentile(0.50)) + '\n';
+            out += "vehiclesys_latency_seconds{" + labels + ",quantile=\"0.99\"} "
+                    + seconds(histogram.percentile(0.99)) + '\n';
+            out += "vehiclesys_latency_seconds_sum{" + labels + "} " + seconds(histogram.sum()) + '\n';
+            out += "vehiclesys_latency_seconds_count{" + labels + "} " + QByteArray::number(histogram.count()) + '\n';
+        }
+    }
+
+    out += "# HELP vehiclesys_latency_max_seconds Longest latency seen, by stage.\n";
+    out += "# TYPE vehiclesys_latency_max_seconds gauge\n";
+    for (const Trace &trace : m_traces) {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            out += "vehiclesys_latency_max_seconds{signal=\"" + trace.name.toUtf8() + "\",stage=\""
+                    + stageName(static_cast<Stage>(stage)).toUtf8() + "\"} "
+                    + seconds(trace.stages[stage].max()) + '\n';
+        }
+    }
+
+    out += "# HELP vehiclesys_latency_superseded_total Changes replaced before any frame showed them.\n";
+    out += "# TYPE vehiclesys_latency_superseded_total counter\n";
+    for (const Trace &trace : m_traces) {
+        out += "vehiclesys_latency_superseded_total{signal=\"" + trace.name.toUtf8() + "\"} "
+                + QByteArray::number(trace.superseded) + '\n';
+    }
+    return out;
+}
+
+bool LatencyTracer::writeReport(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(toPrometheus()) < 0 || !file.commit()) {
+        qWarning() << "LatencyTracer: cannot write report:" << file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -1,15 +1,36 @@
 #include "mediacontroller.h"
-#include <QFileInfo>
+#include "binarylogger.h"
+#include "tracing.h"
 #include <QStandardPaths>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QFileInfo>
+#include <QHash>
 #include <QRandomGenerator>
+#include <QSet>
 
 #ifdef HAVE_QT_MULTIMEDIA
 #include <QMediaMetaData>
 #include <QAudio>
 #endif
 
+namespace {
+
+// Tags as the playlist shows them, with the file name standing in for a
+// missing title or artist, so a search finds what is on screen
+MediaTags displayedTags(const QString &path, MediaTags tags)
+{
+    if (tags.title.isEmpty()) {
+        tags.title = PlaylistModel::titleFromFileName(path);
+    }
+    if (tags.artist.isEmpty()) {
+        tags.artist = PlaylistModel::artistFromFileName(path);
+    }
+    return tags;
+}
+
+} // namespace
+
 MediaController::MediaController(QObject *parent)
     : QObject(parent)
 #ifdef HAVE_QT_MULTIMEDIA
@@ -18,6 +39,9 @@ MediaController::MediaController(QObject *parent)
 #endif
     , m_positionTimer(new QTimer(this))
     , m_simulationTimer(new QTimer(this))
+    , m_scanner(new MusicScanner(this))
+    , m_watcher(new MusicWatcher(this))
+    , m_scanning(false)
     , m_currentTitle("No Track")
     , m_currentArtist("Unknown Artist")
     , m_currentTime(0)
@@ -26,6 +50,9 @@ MediaController::MediaController(QObject *parent)
     , m_shuffle(false)
     , m_repeat(false)
     , m_isPlaying(false)
+    , m_playlistModel(new PlaylistModel(this))
+    , m_search(new MusicSearch(this))
+    , m_searchModel(new SearchResultsModel(m_search, this))
     , m_currentIndex(-1)
 {
     // Supported audio formats
@@ -73,12 +100,26 @@ MediaController::MediaController(QObject *parent)
     connect(m_simulationTimer, &QTimer::timeout, this, &MediaController::simulatePlayback);
     m_simulationTimer->setInterval(1000); // Update every second
 
-    // Auto-load music directory
+    // Queued: batches arrive from the scanner thread
+    connect(m_scanner, &MusicScanner::filesFound, this, &MediaController::handleFilesFound);
+    connect(m_scanner, &MusicScanner::scanFinished, this, &MediaController::handleScanFinished);
+    connect(m_scanner, &MusicScanner::filesChanged, this, &MediaController::handleFilesChanged);
+    connect(m_scanner, &MusicScanner::filesRemoved, this, &MediaController::handleFilesRemoved);
+
+    // Live updates: the scanner watches what it walks and applies the changes
+    if (m_watcher->isValid()) {
+        m_scanner->setWatcher(m_watcher);
+        connect(m_watcher, &MusicWatcher::changed, m_scanner, &MusicScanner::update);
+        connect(m_watcher, &MusicWatcher::overflowed, this, [this] { loadMusicDirectory(m_scanPath); });
+    }
+
+    // Auto-load music directory; returns before the scan is done
     loadMusicDirectory();
 }
 
 MediaController::~MediaController()
 {
+    m_scanner->stop();
 #ifdef HAVE_QT_MULTIMEDIA
     if (m_player) {
         m_player->stop();
@@ -121,11 +162,6 @@ int MediaController::volume() const
     return m_volume;
 }
 
-QStringList MediaController::playlist() const
-{
-    return m_playlistFiles;
-}
-
 int MediaController::currentIndex() const
 {
 #ifdef HAVE_QT_MULTIMEDIA
@@ -145,29 +181,31 @@ bool MediaController::repeat() const
     return m_repeat;
 }
 
+bool MediaController::scanning() const
+{
+    return m_scanning;
+}
+
 // Media control slots
 void MediaController::play()
 {
 #ifdef HAVE_QT_MULTIMEDIA
     if (m_playlist->mediaCount() > 0) {
-        qDebug() << "MediaController::play() - Starting playback";
-        qDebug() << "MediaController: Current track index:" << m_playlist->currentIndex();
-        qDebug() << "MediaController: Volume level:" << m_player->volume();
-        qDebug() << "MediaController: Media count in playlist:" << m_playlist->mediaCount();
+        VEHICLESYS_LOG_DEBUG(logMedia, "play: track %1 of %2, volume %3",
+                             m_playlist->currentIndex(), m_playlist->mediaCount(), m_player->volume());
         m_player->play();
         m_positionTimer->start();
-        qDebug() << "MediaController: Play command sent to QMediaPlayer";
     } else {
-        qWarning() << "MediaController::play() - No media in playlist";
+        VEHICLESYS_LOG_WARNING(logMedia, "play: no media in playlist");
     }
 #else
-    if (m_playlistFiles.count() > 0) {
+    if (m_playlistModel->rowCount() > 0) {
         m_isPlaying = true;
         m_simulationTimer->start();
         emit isPlayingChanged(m_isPlaying);
-        qDebug() << "Playing (simulation):" << m_currentTitle;
+        VEHICLESYS_LOG_DEBUG(logMedia, "play (simulation): %1", m_currentTitle);
     } else {
-        qWarning() << "MediaController::play() - No tracks in simulation playlist";
+        VEHICLESYS_LOG_WARNING(logMedia, "play: no tracks in simulation playlist");
     }
 #endif
 }
@@ -181,7 +219,7 @@ void MediaController::pause()
     m_isPlaying = false;
     m_simulationTimer->stop();
     emit isPlayingChanged(m_isPlaying);
-    qDebug() << "Paused (simulation):" << m_currentTitle;
+    VEHICLESYS_LOG_DEBUG(logMedia, "pause (simulation): %1", m_currentTitle);
 #endif
 }
 
@@ -196,7 +234,7 @@ void MediaController::stop()
     m_currentTime = 0;
     emit isPlayingChanged(m_isPlaying);
     emit currentTimeChanged(m_currentTime);
-    qDebug() << "Stopped (simulation):" << m_currentTitle;
+    VEHICLESYS_LOG_DEBUG(logMedia, "stop (simulation): %1", m_currentTitle);
 #endif
 }
 
@@ -220,11 +258,11 @@ void MediaController::next()
         m_playlist->next();
     }
 #else
-    if (m_playlistFiles.count() > 0) {
+    if (m_playlistModel->rowCount() > 0) {
         if (m_shuffle) {
-            m_currentIndex = QRandomGenerator::global()->bounded(m_playlistFiles.count());
+            m_currentIndex = QRandomGenerator::global()->bounded(m_playlistModel->rowCount());
         } else {
-            m_currentIndex = (m_currentIndex + 1) % m_playlistFiles.count();
+            m_currentIndex = (m_currentIndex + 1) % m_playlistModel->rowCount();
         }
         loadCurrentTrack();
         if (m_isPlaying) {
@@ -239,8 +277,8 @@ void MediaController::previous()
 #ifdef HAVE_QT_MULTIMEDIA
     m_playlist->previous();
 #else
-    if (m_playlistFiles.count() > 0) {
-        m_currentIndex = m_currentIndex > 0 ? m_currentIndex - 1 : m_playlistFiles.count() - 1;
+    if (m_playlistModel->rowCount() > 0) {
+        m_currentIndex = m_currentIndex > 0 ? m_currentIndex - 1 : m_playlistModel->rowCount() - 1;
         loadCurrentTrack();
         if (m_isPlaying) {
             play();
@@ -252,6 +290,7 @@ void MediaController::previous()
 // Playlist management
 void MediaController::loadMusicDirectory(const QString &path)
 {
+    VEHICLESYS_TRACE_ZONE("MediaController::loadMusicDirectory");
     QString musicPath = path.isEmpty() ? "music" : path;
     
     // Try relative path first
@@ -277,58 +316,151 @@ void MediaController::loadMusicDirectory(const QString &path)
         return;
     }
 
+    // Batches of a previous scan still queued carry its id and are dropped
+    m_scanner->stop();
     clearPlaylist();
-    
-    QStringList audioFiles = getSupportedAudioFiles(musicDir);
-    
-    qDebug() << "Found" << audioFiles.size() << "audio files in" << musicPath;
-    
-    for (const QString &filePath : audioFiles) {
-        addFile(filePath);
+    m_scanPath = musicPath;
+    m_watcher->reset(musicPath, m_supportedFormats);
+    m_scanner->scan(musicPath, m_supportedFormats);
+    if (!m_scanning) {
+        m_scanning = true;
+        emit scanningChanged(m_scanning);
     }
-    
-#ifdef HAVE_QT_MULTIMEDIA
-    if (m_playlist->mediaCount() > 0) {
-        m_playlist->setCurrentIndex(0);
-        qDebug() << "Loaded" << m_playlist->mediaCount() << "tracks";
+}
+
+void MediaController::cancelScan()
+{
+    // The queued scanFinished() clears the scanning flag
+    m_scanner->stop();
+}
+
+void MediaController::handleFilesFound(int scanId, const QStringList &paths, const QVector<MediaTags> &tags)
+{
+    if (scanId != m_scanner->scanId()) {
+        return;
     }
-#else
-    if (m_playlistFiles.count() > 0) {
-        m_currentIndex = 0;
-        loadCurrentTrack();
-        qDebug() << "Loaded" << m_playlistFiles.count() << "tracks (simulation mode)";
+    appendTracks(paths, tags);
+}
+
+void MediaController::handleScanFinished(int scanId, int fileCount, bool cancelled)
+{
+    if (scanId != m_scanner->scanId()) {
+        return;
+    }
+
+    qDebug() << (cancelled ? "Scan cancelled after" : "Found") << fileCount << "audio files in" << m_scanPath;
+    m_scanning = false;
+    emit scanningChanged(m_scanning);
+}
+
+void MediaController::handleFilesChanged(int scanId, const QStringList &paths, const QVector<MediaTags> &tags)
+{
+    if (scanId != m_scanner->scanId()) {
+        return;
+    }
+
+    // Files already listed were rewritten; only their tags change
+    QHash<QString, int> incoming;
+    incoming.reserve(paths.size());
+    for (int i = 0; i < paths.size(); ++i) {
+        incoming.insert(paths.at(i), i);
+    }
+    for (int row = 0; row < m_playlistModel->rowCount() && !incoming.isEmpty(); ++row) {
+        const auto it = incoming.find(m_playlistModel->path(row));
+        if (it != incoming.end()) {
+            const MediaTags &trackTags = tags.at(it.value());
+            m_playlistModel->setMetadata(row, trackTags.title, trackTags.artist, trackTags.album);
+            m_playlistModel->setDuration(row, trackTags.durationMs);
+            m_search->add(QStringList(it.key()), { displayedTags(it.key(), trackTags) });
+            incoming.erase(it);
+        }
+    }
+
+    QStringList newPaths;
+    QVector<MediaTags> newTags;
+    for (int i = 0; i < paths.size(); ++i) {
+        if (incoming.contains(paths.at(i))) {
+            newPaths.append(paths.at(i));
+            newTags.append(tags.at(i));
+        }
+    }
+    appendTracks(newPaths, newTags);
+}
+
+void MediaController::handleFilesRemoved(int scanId, const QStringList &files, const QStringList &directories)
+{
+    if (scanId != m_scanner->scanId()) {
+        return;
+    }
+
+    const QSet<QString> removedFiles(files.constBegin(), files.constEnd());
+    QStringList prefixes;
+    for (const QString &directory : directories) {
+        prefixes.append(directory + QLatin1Char('/'));
+    }
+    auto isRemoved = [&](int row) {
+        const QString path = m_playlistModel->path(row);
+        if (removedFiles.contains(path)) {
+            return true;
+        }
+        for (const QString &prefix : prefixes) {
+            if (path.startsWith(prefix)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // From the end, so the rows still to look at keep their index; each run
+    // of adjacent rows goes in one removal
+    for (int row = m_playlistModel->rowCount() - 1; row >= 0; --row) {
+        if (!isRemoved(row)) {
+            continue;
+        }
+        int first = row;
+        while (first > 0 && isRemoved(first - 1)) {
+            --first;
+        }
+        removeTracks(first, row - first + 1);
+        row = first;
     }
-#endif
 }
 
 void MediaController::addFile(const QString &filePath)
 {
-#ifdef HAVE_QT_MULTIMEDIA
-    QUrl url = QUrl::fromLocalFile(filePath);
-    m_playlist->addMedia(QMediaContent(url));
-#endif
-    
-    QFileInfo fileInfo(filePath);
-    m_playlistFiles.append(fileInfo.baseName());
-    
-    emit playlistChanged();
+    // Even one file can sit on a slow disk; the scanner reads its tags and
+    // sends it back through handleFilesChanged(), which appends it
+    MusicChanges changes;
+    changes.files.append(QFileInfo(filePath).absoluteFilePath());
+    m_scanner->update(changes);
 }
 
 void MediaController::removeFile(int index)
+{
+    if (index >= 0 && index < m_playlistModel->rowCount()) {
+        removeTracks(index, 1);
+    }
+}
+
+void MediaController::moveTrack(int from, int to)
 {
 #ifdef HAVE_QT_MULTIMEDIA
-    if (index >= 0 && index < m_playlist->mediaCount()) {
-        m_playlist->removeMedia(index);
-        m_playlistFiles.removeAt(index);
-        emit playlistChanged();
+    // QMediaPlaylist keeps its current index on the moved track itself
+    if (m_playlistModel->move(from, to)) {
+        m_playlist->moveMedia(from, to);
     }
 #else
-    if (index >= 0 && index < m_playlistFiles.count()) {
-        m_playlistFiles.removeAt(index);
-        if (m_currentIndex >= index && m_currentIndex > 0) {
-            m_currentIndex--;
+    if (m_playlistModel->move(from, to)) {
+        if (m_currentIndex == from) {
+            m_currentIndex = to;
+        } else if (from < m_currentIndex && m_currentIndex <= to) {
+            --m_currentIndex;
+        } else if (to <= m_currentIndex && m_currentIndex < from) {
+            ++m_currentIndex;
+        } else {
+            return;
         }
-        emit playlistChanged();
+        emit currentIndexChanged(m_currentIndex);
     }
 #endif
 }
@@ -338,9 +470,9 @@ void MediaController::clearPlaylist()
 #ifdef HAVE_QT_MULTIMEDIA
     m_playlist->clear();
 #endif
-    m_playlistFiles.clear();
+    m_playlistModel->clear();
+    m_search->clear();
     m_currentIndex = -1;
-    emit playlistChanged();
 }
 
 void MediaController::playTrack(int index)
@@ -351,7 +483,7 @@ void MediaController::playTrack(int index)
         play();
     }
 #else
-    if (index >= 0 && index < m_playlistFiles.count()) {
+    if (index >= 0 && index < m_playlistModel->rowCount()) {
         m_currentIndex = index;
         loadCurrentTrack();
         play();
@@ -359,19 +491,27 @@ void MediaController::playTrack(int index)
 #endif
 }
 
+void MediaController::playFile(const QString &filePath)
+{
+    for (int row = 0; row < m_playlistModel->rowCount(); ++row) {
+        if (m_playlistModel->path(row) == filePath) {
+            playTrack(row);
+            return;
+        }
+    }
+}
+
 // Settings
 void MediaController::setVolume(int volume)
 {
     int clampedVolume = qBound(0, volume, 100);
-    qDebug() << "MediaController::setVolume() - Requested:" << volume << "Clamped:" << clampedVolume;
     if (m_volume != clampedVolume) {
         m_volume = clampedVolume;
 #ifdef HAVE_QT_MULTIMEDIA
         m_player->setVolume(m_volume);
-        qDebug() << "MediaController: Volume set on QMediaPlayer to:" << m_volume;
-        qDebug() << "MediaController: Actual player volume now:" << m_player->volume();
+        VEHICLESYS_LOG_DEBUG(logMedia, "setVolume: requested %1, player now at %2", volume, m_player->volume());
 #else
-        qDebug() << "MediaController: Volume set in simulation mode to:" << m_volume;
+        VEHICLESYS_LOG_DEBUG(logMedia, "setVolume (simulation): requested %1, set to %2", volume, m_volume);
 #endif
         emit volumeChanged(m_volume);
     }
@@ -446,6 +586,7 @@ void MediaController::handleDurationChanged(qint64 duration)
         m_totalTime = duration;
         emit totalTimeChanged(m_totalTime);
     }
+    m_playlistModel->setDuration(m_playlist->currentIndex(), duration);
 }
 
 void MediaController::handleCurrentMediaChanged(const QMediaContent &content)
@@ -454,8 +595,7 @@ void MediaController::handleCurrentMediaChanged(const QMediaContent &content)
         m_currentTitle = "No Track";
         m_currentArtist = "Unknown Artist";
     } else {
-        QString filePath = content.canonicalUrl().toLocalFile();
-        extractMetadata(filePath);
+        extractMetadata(m_playlist->currentIndex());
     }
     
     emit currentTitleChanged(m_currentTitle);
@@ -500,9 +640,8 @@ void MediaController::handleError(QMediaPlayer::Error error)
         break;
     }
     
-    qWarning() << "Media player error:" << errorString;
-    qWarning() << "Volume level:" << m_volume << "Audio role: Music";
-    qWarning() << "Available audio devices should be checked in system settings";
+    VEHICLESYS_LOG_WARNING(logMedia, "player error: %1 (volume %2; check the system's audio devices)",
+                           errorString, m_volume);
     emit mediaError(errorString);
 }
 #endif
@@ -528,7 +667,7 @@ void MediaController::simulatePlayback()
         emit currentTimeChanged(m_currentTime);
     } else if (m_currentTime >= m_totalTime && m_isPlaying) {
         // End of track
-        if (m_repeat || (m_currentIndex < m_playlistFiles.count() - 1) || m_shuffle) {
+        if (m_repeat || (m_currentIndex < m_playlistModel->rowCount() - 1) || m_shuffle) {
             next();
         } else {
             stop();
@@ -538,14 +677,16 @@ void MediaController::simulatePlayback()
 
 void MediaController::loadCurrentTrack()
 {
-    if (m_currentIndex >= 0 && m_currentIndex < m_playlistFiles.count()) {
-        QString fileName = m_playlistFiles[m_currentIndex];
-        m_currentTitle = getFileTitle(fileName);
-        m_currentArtist = getFileArtist(fileName);
+    if (m_currentIndex >= 0 && m_currentIndex < m_playlistModel->rowCount()) {
+        extractMetadata(m_currentIndex);
         
-        // Set a realistic duration for simulation
-        m_totalTime = (180 + QRandomGenerator::global()->bounded(120)) * 1000; // 3-5 minutes in ms
+        // The tagged duration, else a realistic one for simulation
+        m_totalTime = m_playlistModel->duration(m_currentIndex);
+        if (m_totalTime <= 0) {
+            m_totalTime = (180 + QRandomGenerator::global()->bounded(120)) * 1000; // 3-5 minutes in ms
+        }
         m_currentTime = 0;
+        m_playlistModel->setDuration(m_currentIndex, m_totalTime);
         
         emit currentTitleChanged(m_currentTitle);
         emit currentArtistChanged(m_currentArtist);
@@ -556,64 +697,91 @@ void MediaController::loadCurrentTrack()
 }
 
 // Private helper methods
-void MediaController::extractMetadata(const QString &filePath)
+void MediaController::appendTracks(const QStringList &paths, const QVector<MediaTags> &tags)
 {
-    m_currentTitle = getFileTitle(filePath);
-    m_currentArtist = getFileArtist(filePath);
-    
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    const bool wasEmpty = m_playlistModel->rowCount() == 0;
 #ifdef HAVE_QT_MULTIMEDIA
-    // Try to get metadata from QMediaPlayer if available
-    if (m_player->isMetaDataAvailable()) {
-        QString title = m_player->metaData(QMediaMetaData::Title).toString();
-        QString artist = m_player->metaData(QMediaMetaData::Author).toString();
-        
-        if (!title.isEmpty()) m_currentTitle = title;
-        if (!artist.isEmpty()) m_currentArtist = artist;
+    QList<QMediaContent> media;
+    media.reserve(paths.size());
+    for (const QString &filePath : paths) {
+        media.append(QMediaContent(QUrl::fromLocalFile(filePath)));
     }
+    m_playlist->addMedia(media);
 #endif
-}
+    m_playlistModel->append(paths, tags);
 
-QString MediaController::getFileTitle(const QString &filePath)
-{
-    QFileInfo fileInfo(filePath);
-    QString baseName = fileInfo.baseName();
-    
-    // Simple parsing for common filename patterns
-    if (baseName.contains(" - ")) {
-        QStringList parts = baseName.split(" - ");
-        if (parts.size() >= 2) {
-            return parts[1].trimmed(); // Assume "Artist - Title" format
-        }
+    QVector<MediaTags> searchTags;
+    searchTags.reserve(tags.size());
+    for (int i = 0; i < paths.size(); ++i) {
+        searchTags.append(displayedTags(paths.at(i), tags.at(i)));
+    }
+    m_search->add(paths, searchTags);
+
+    // The first tracks can be played while the rest are still being found
+    if (wasEmpty) {
+#ifdef HAVE_QT_MULTIMEDIA
+        m_playlist->setCurrentIndex(0);
+#else
+        m_currentIndex = 0;
+        loadCurrentTrack();
+#endif
     }
-    
-    return baseName;
 }
 
-QString MediaController::getFileArtist(const QString &filePath)
+void MediaController::removeTracks(int first, int count)
 {
-    QFileInfo fileInfo(filePath);
-    QString baseName = fileInfo.baseName();
-    
-    // Simple parsing for common filename patterns
-    if (baseName.contains(" - ")) {
-        QStringList parts = baseName.split(" - ");
-        if (parts.size() >= 2) {
-            return parts[0].trimmed(); // Assume "Artist - Title" format
+    QStringList paths;
+    for (int row = first; row < first + count; ++row) {
+        paths.append(m_playlistModel->path(row));
+    }
+    m_search->remove(paths);
+
+#ifdef HAVE_QT_MULTIMEDIA
+    // QMediaPlaylist moves its current index itself, and reports a new
+    // current track at once; the model must not list the removed rows then
+    m_playlistModel->remove(first, count);
+    m_playlist->removeMedia(first, first + count - 1);
+#else
+    m_playlistModel->remove(first, count);
+    if (m_currentIndex >= first + count) {
+        m_currentIndex -= count;
+        emit currentIndexChanged(m_currentIndex);
+    } else if (m_currentIndex >= first) {
+        // The current track went, as with QMediaPlaylist: load another in its place
+        m_currentIndex = m_playlistModel->rowCount() > 0 ? qMax(first - 1, 0) : -1;
+        if (m_currentIndex >= 0) {
+            loadCurrentTrack();
+        } else {
+            stop();
+            m_currentTitle = "No Track";
+            m_currentArtist = "Unknown Artist";
+            m_totalTime = 0;
+            emit currentTitleChanged(m_currentTitle);
+            emit currentArtistChanged(m_currentArtist);
+            emit currentIndexChanged(m_currentIndex);
+            emit totalTimeChanged(m_totalTime);
         }
     }
-    
-    return "Unknown Artist";
+#endif
 }
 
-QStringList MediaController::getSupportedAudioFiles(const QDir &dir)
+void MediaController::extractMetadata(int index)
 {
-    QStringList files;
-    
-    QFileInfoList fileList = dir.entryInfoList(m_supportedFormats, QDir::Files | QDir::Readable, QDir::Name);
+    m_currentTitle = m_playlistModel->title(index);
+    m_currentArtist = m_playlistModel->artist(index);
     
-    for (const QFileInfo &fileInfo : fileList) {
-        files.append(fileInfo.absoluteFilePath());
+#ifdef HAVE_QT_MULTIMEDIA
+    // Try to get metadata from QMediaPlayer if available
+    if (m_player->isMetaDataAvailable()) {
+        QString title = m_player->metaData(QMediaMetaData::Title).toString();
+        QString artist = m_player->metaData(QMediaMetaData::Author).toString();
+        
+        if (!title.isEmpty()) m_currentTitle = title;
+        if (!artist.isEmpty()) m_currentArtist = artist;
     }
-    
-    return files;
-}
\ No newline at end of file
+#endif
+}
@@ -0,0 +1,150 @@
+#include "mediaindex.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+const quint32 Magic = 0x56534D49;   // "VSMI"
+const quint32 Version = 1;
+
+} // namespace
+
+MediaIndex::MediaIndex()
+    : m_scan(0)
+    , m_dirty(false)
+{
+}
+
+QString MediaIndex::defaultPath()
+{
+    const QString path = qEnvironmentVariable("VEHICLESYS_MEDIA_INDEX");
+    if (!path.isEmpty()) {
+        return path;
+    }
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (cacheDir.isEmpty() || !QDir().mkpath(cacheDir)) {
+        return QString();
+    }
+    return cacheDir + QStringLiteral("/media-index");
+}
+
+bool MediaIndex::load(const QString &path)
+{
+    m_entries.clear();
+    m_dirty = false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != Magic || version != Version || in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    m_entries.reserve(static_cast<int>(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString entryPath;
+        Entry entry;
+        in >> entryPath >> entry.size >> entry.modifiedMs
+           >> entry.tags.title >> entry.tags.artist >> entry.tags.album >> entry.tags.durationMs;
+        m_entries.insert(entryPath, entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "MediaIndex: ignoring truncated index" << path;
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool MediaIndex::save(const QString &path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "MediaIndex: cannot write index:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << Magic << Version << quint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const Entry &entry = it.value();
+        out << it.key() << entry.size << entry.modifiedMs
+            << entry.tags.title << entry.tags.artist << entry.tags.album << entry.tags.durationMs;
+    }
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "MediaIndex: cannot write index:" << file.errorString();
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+void MediaIndex::beginScan()
+{
+    ++m_scan;
+}
+
+bool MediaIndex::lookup(const QString &path, qint64 size, qint64 modifiedMs, MediaTags *tags)
+{
+    auto it = m_entries.find(path);
+    if (it == m_entries.end() || it->size != size || it->modifiedMs != modifiedMs) {
+        return false;
+    }
+    it->seenInScan = m_scan;
+    *tags = it->tags;
+    return true;
+}
+
+void MediaIndex::insert(const QString &path, qint64 size, qint64 modifiedMs, const MediaTags &tags)
+{
+    Entry &entry = m_entries[path];
+    entry.size = size;
+    entry.modifiedMs = modifiedMs;
+    entry.tags = tags;
+    entry.seenInScan = m_scan;
+    m_dirty = true;
+}
+
+void MediaIndex::prune(const QString &root)
+{
+    removeIf(root, [this](const Entry &entry) { return entry.seenInScan != m_scan; });
+}
+
+void MediaIndex::remove(const QString &path)
+{
+    if (m_entries.remove(path) > 0) {
+        m_dirty = true;
+    }
+}
+
+void MediaIndex::removeUnder(const QString &directory)
+{
+    removeIf(directory, [](const Entry &) { return true; });
+}
+
+template<typename Predicate>
+void MediaIndex::removeIf(const QString &directory, Predicate predicate)
+{
+    const QString prefix = QDir(directory).absolutePath() + QLatin1Char('/');
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it.key().startsWith(prefix) && predicate(it.value())) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,306 @@
+#include "musicscanner.h"
+#include "tracing.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QVector>
+
+// Collects files with their tags and sends them a batch at a time
+class MusicScanner::Batch
+{
+public:
+    Batch(MusicScanner *scanner, int scanId, bool changes)
+        : m_scanner(scanner)
+        , m_scanId(scanId)
+        , m_changes(changes)
+        , m_fileCount(0)
+        , m_sentAny(false)
+    {
+        m_sinceFlush.start();
+    }
+
+    int fileCount() const { return m_fileCount; }
+    bool sentAny() const { return m_sentAny; }
+
+    void add(const QFileInfo &file)
+    {
+        const QString path = file.absoluteFilePath();
+        const qint64 size = file.size();
+        const qint64 modifiedMs = file.lastModified().toMSecsSinceEpoch();
+        MediaTags tags;
+        if (!m_scanner->m_index.lookup(path, size, modifiedMs, &tags)) {
+            m_misses.append(m_paths.size());
+        }
+        m_paths.append(path);
+        m_tags.append(tags);
+        m_sizes.append(size);
+        m_modifiedTimes.append(modifiedMs);
+        ++m_fileCount;
+        if (m_paths.size() >= BatchSize || m_sinceFlush.elapsed() >= BatchIntervalMs) {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        m_sinceFlush.restart();
+        if (m_paths.isEmpty()) {
+            return;
+        }
+        if (!m_misses.isEmpty()) {
+            m_scanner->readTags(m_paths, m_misses, &m_tags);
+            if (m_scanner->m_stopRequested.load(std::memory_order_relaxed)) {
+                return;     // Some tags were left unread; index none of them
+            }
+            for (int row : m_misses) {
+                m_scanner->m_index.insert(m_paths.at(row), m_sizes.at(row), m_modifiedTimes.at(row), m_tags.at(row));
+            }
+        }
+        if (m_changes) {
+            emit m_scanner->filesChanged(m_scanId, m_paths, m_tags);
+        } else {
+            emit m_scanner->filesFound(m_scanId, m_paths, m_tags);
+        }
+        m_paths.clear();
+        m_tags.clear();
+        m_sizes.clear();
+        m_modifiedTimes.clear();
+        m_misses.clear();
+        m_sentAny = true;
+    }
+
+private:
+    MusicScanner *m_scanner;
+    const int m_scanId;
+    const bool m_changes;
+    int m_fileCount;
+    bool m_sentAny;
+    QElapsedTimer m_sinceFlush;
+
+    // Per file; misses are the rows not found in the index
+    QStringList m_paths;
+    QVector<MediaTags> m_tags;
+    QVector<qint64> m_sizes;
+    QVector<qint64> m_modifiedTimes;
+    QVector<int> m_misses;
+};
+
+MusicScanner::MusicScanner(QObject *parent)
+    : QThread(parent)
+    , m_indexLoaded(false)
+    , m_scanId(0)
+    , m_walkRequested(false)
+    , m_stopRequested(false)
+    , m_watcher(nullptr)
+    , m_idle(true)
+{
+    setObjectName(QStringLiteral("MusicScanner"));
+    qRegisterMetaType<QVector<MediaTags>>();
+}
+
+MusicScanner::~MusicScanner()
+{
+    stop();
+}
+
+int MusicScanner::scan(const QString &root, const QStringList &nameFilters)
+{
+    stop();
+    {
+        // The walk sees the tree as it is now
+        QMutexLocker locker(&m_mutex);
+        m_pendingChanges.clear();
+        m_idle = false;
+    }
+    m_root = root;
+    m_nameFilters = nameFilters;
+    m_walkRequested = true;
+    m_stopRequested.store(false);
+    ++m_scanId;
+    start(QThread::LowPriority);
+    return m_scanId;
+}
+
+void MusicScanner::update(const MusicChanges &changes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pendingChanges.append(changes);
+    if (!m_idle) {
+        return;     // The running thread takes them before it returns
+    }
+    m_idle = false;
+    locker.unlock();
+
+    // A thread that just went idle may not have returned yet
+    wait();
+    m_walkRequested = false;
+    m_stopRequested.store(false);
+    start(QThread::LowPriority);
+}
+
+void MusicScanner::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    m_stopRequested.store(true);
+    wait();
+}
+
+void MusicScanner::run()
+{
+    VEHICLESYS_TRACE_ZONE("MusicScanner::run");
+    // Read once: scan() only changes it while the thread is stopped
+    const int scanId = m_scanId;
+
+    if (!m_indexLoaded) {
+        VEHICLESYS_TRACE_ZONE("MediaIndex::load");
+        m_indexPath = MediaIndex::defaultPath();
+        m_indexLoaded = true;
+        if (!m_indexPath.isEmpty() && m_index.load(m_indexPath)) {
+            qDebug() << "MusicScanner: restored" << m_index.count() << "indexed files";
+        }
+    }
+
+    if (m_walkRequested) {
+        m_index.beginScan();
+        Batch batch(this, scanId, false);
+        walk(QDir(m_root).absolutePath(), &batch);
+
+        const bool cancelled = m_stopRequested.load(std::memory_order_relaxed);
+        if (!cancelled) {
+            batch.flush();
+            // Only a complete walk knows which files are gone
+            m_index.prune(m_root);
+        }
+        emit scanFinished(scanId, batch.fileCount(), cancelled);
+    }
+
+    for (;;) {
+        if (m_index.isDirty() && !m_indexPath.isEmpty()) {
+            VEHICLESYS_TRACE_ZONE("MediaIndex::save");
+            m_index.save(m_indexPath);
+        }
+
+        QVector<MusicChanges> changes;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_pendingChanges.isEmpty() || m_stopRequested.load(std::memory_order_relaxed)) {
+                m_idle = true;
+                return;
+            }
+            changes.swap(m_pendingChanges);
+        }
+        for (const MusicChanges &change : changes) {
+            applyChanges(scanId, change);
+        }
+    }
+}
+
+void MusicScanner::walk(const QString &root, Batch *batch)
+{
+    auto stopRequested = [this] { return m_stopRequested.load(std::memory_order_relaxed); };
+
+    QVector<QString> pending{ root };
+    while (!pending.isEmpty() && !stopRequested()) {
+        const QString path = pending.takeLast();
+        // Before listing, so nothing created in between goes unnoticed
+        if (m_watcher) {
+            m_watcher->watchDirectory(path);
+        }
+
+        // One pass for files and subdirectories, keeping only paths; sorting
+        // those is cheap next to the stat of every entry it used to take
+        QStringList files;
+        QStringList subdirs;
+        QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
+        while (it.hasNext() && !stopRequested()) {
+            const QString filePath = it.next();
+            const QFileInfo info = it.fileInfo();
+            if (info.isDir()) {
+                if (!info.isSymLink()) {
+                    subdirs.append(filePath);
+                }
+            } else if (QDir::match(m_nameFilters, it.fileName())) {
+                files.append(filePath);
+            }
+        }
+
+        files.sort();
+        for (const QString &file : qAsConst(files)) {
+            if (stopRequested()) {
+                return;
+            }
+            batch->add(QFileInfo(file));
+        }
+        if (!batch->sentAny()) {
+            batch->flush();
+        }
+
+        // Reversed, so the stack pops them in name order
+        subdirs.sort();
+        for (auto subdir = subdirs.crbegin(); subdir != subdirs.crend(); ++subdir) {
+            pending.append(*subdir);
+        }
+    }
+}
+
+void MusicScanner::applyChanges(int scanId, const MusicChanges &changes)
+{
+    VEHICLESYS_TRACE_ZONE("MusicScanner::applyChanges");
+    // Removals first: a rename is a removal and an addition
+    if (!changes.removedFiles.isEmpty() || !changes.removedDirectories.isEmpty()) {
+        for (const QString &path : changes.removedFiles) {
+            m_index.remove(path);
+        }
+        for (const QString &path : changes.removedDirectories) {
+            m_index.removeUnder(path);
+        }
+        emit filesRemoved(scanId, changes.removedFiles, changes.removedDirectories);
+    }
+
+    Batch batch(this, scanId, true);
+    for (const QString &path : changes.files) {
+        // Gone again, or under a directory that went since
+        const QFileInfo file(path);
+        if (file.isFile() && file.isReadable()) {
+            batch.add(file);
+        }
+    }
+    for (const QString &path : changes.directories) {
+        if (QFileInfo(path).isDir()) {
+            walk(path, &batch);
+        }
+    }
+    if (!m_stopRequested.load(std::memory_order_relaxed)) {
+        batch.flush();
+    }
+}
+
+void MusicScanner::readTags(const QStringList &paths, const QVector<int> &rows, QVector<MediaTags> *tags)
+{
+    VEHICLESYS_TRACE_ZONE("MusicScanner::readTags");
+    // Rows are handed out one at a time, so a slow file holds up one reader only
+    MediaTags *out = tags->data();
+    std::atomic<int> next(0);
+    auto work = [&] {
+        for (int i = next.fetch_add(1); i < rows.size(); i = next.fetch_add(1)) {
+            if (m_stopRequested.load(std::memory_order_relaxed)) {
+                return;
+            }
+            TagReader::read(paths.at(rows.at(i)), &out[rows.at(i)]);
+        }
+    };
+
+    // This thread reads too
+    const int helpers = qMin(m_tagReaders.maxThreadCount(), rows.size()) - 1;
+    for (int i = 0; i < helpers; ++i) {
+        m_tagReaders.start(work);
+    }
+    work();
+    m_tagReaders.waitForDone();
+}
@@ -0,0 +1,153 @@
+#include "musicsearch.h"
+#include "tracing.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+MusicSearch::MusicSearch(QObject *parent)
+    : QThread(parent)
+    , m_queryLimit(DefaultLimit)
+    , m_queryId(0)
+    , m_queryPending(false)
+    , m_stopRequested(false)
+    , m_cancelQuery(false)
+{
+    setObjectName(QStringLiteral("MusicSearch"));
+    qRegisterMetaType<QVector<SearchResult>>();
+    start();
+}
+
+MusicSearch::~MusicSearch()
+{
+    stop();
+}
+
+void MusicSearch::add(const QStringList &paths, const QVector<MediaTags> &tags)
+{
+    if (!paths.isEmpty() && tags.size() == paths.size()) {
+        enqueue(Change{ Change::Add, paths, tags });
+    }
+}
+
+void MusicSearch::remove(const QStringList &paths)
+{
+    if (!paths.isEmpty()) {
+        enqueue(Change{ Change::Remove, paths, QVector<MediaTags>() });
+    }
+}
+
+void MusicSearch::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    // Nothing queued before matters any more
+    m_changes.clear();
+    m_changes.append(Change{ Change::Clear, QStringList(), QVector<MediaTags>() });
+    m_wake.wakeOne();
+}
+
+int MusicSearch::query(const QString &text, int limit)
+{
+    QMutexLocker locker(&m_mutex);
+    m_query = text;
+    m_queryLimit = limit;
+    m_queryPending = true;
+    m_cancelQuery.store(true);
+    m_wake.wakeOne();
+    return ++m_queryId;
+}
+
+void MusicSearch::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopRequested = true;
+        m_cancelQuery.store(true);
+        m_wake.wakeOne();
+    }
+    wait();
+}
+
+void MusicSearch::enqueue(const Change &change)
+{
+    QMutexLocker locker(&m_mutex);
+    m_changes.append(change);
+    m_wake.wakeOne();
+}
+
+void MusicSearch::run()
+{
+    QString query;
+    int limit = DefaultLimit;
+    int queryId = 0;
+    // The standing query runs again for library changes at most this often
+    QElapsedTimer sinceResults;
+    bool refreshDue = false;
+
+    for (;;) {
+        QVector<Change> changes;
+        bool newQuery;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopRequested && m_changes.isEmpty() && !m_queryPending) {
+                if (!refreshDue) {
+                    m_wake.wait(&m_mutex);
+                    continue;
+                }
+                const qint64 remainingMs = RefreshIntervalMs - sinceResults.elapsed();
+                if (remainingMs <= 0) {
+                    break;
+                }
+                m_wake.wait(&m_mutex, static_cast<unsigned long>(remainingMs));
+            }
+            if (m_stopRequested) {
+                return;
+            }
+            changes.swap(m_changes);
+            newQuery = m_queryPending;
+            if (newQuery) {
+                query = m_query;
+                limit = m_queryLimit;
+                queryId = m_queryId;
+                m_queryPending = false;
+            }
+            m_cancelQuery.store(false);
+        }
+
+        if (!changes.isEmpty()) {
+            VEHICLESYS_TRACE_ZONE("MusicSearch::update");
+            for (const Change &change : changes) {
+                switch (change.kind) {
+                case Change::Add:
+                    for (int i = 0; i < change.paths.size(); ++i) {
+                        m_index.add(change.paths.at(i), change.tags.at(i));
+                    }
+                    break;
+                case Change::Remove:
+                    for (const QString &path : change.paths) {
+                        m_index.remove(path);
+                    }
+                    break;
+                case Change::Clear:
+                    m_index.clear();
+                    break;
+                }
+            }
+        }
+
+        // A scan changes the library many times a second; its results follow
+        // at RefreshIntervalMs. An ended query still sends its empty result, once
+        if (!changes.isEmpty() && !query.isEmpty()) {
+            refreshDue = true;
+        }
+        const bool refreshNow = refreshDue && (!sinceResults.isValid() || sinceResults.elapsed() >= RefreshIntervalMs);
+        if (newQuery || refreshNow) {
+            VEHICLESYS_TRACE_ZONE("MusicSearch::query");
+            const QVector<SearchResult> results = m_index.search(query, limit, &m_cancelQuery);
+            if (!m_cancelQuery.load(std::memory_order_relaxed)) {
+                emit resultsReady(queryId, results);
+            }
+            // Cancelled only by a newer query, which runs next
+            sinceResults.start();
+            refreshDue = false;
+        }
+    }
+}
@@ -0,0 +1,288 @@
+#include "musicsearchindex.h"
+#include <QPair>
+#include <algorithm>
+
+namespace {
+
+// Ranking by field; a whole-word match doubles it
+const float FieldWeight[] = { 3.0f, 2.0f, 1.0f };
+// Words past this in a query are ignored; keeps the per-track counters small
+const int MaxQueryWords = 16;
+// Removed tracks left in place before the index is rebuilt without them
+const int MinDeadForRebuild = 1024;
+
+} // namespace
+
+MusicSearchIndex::MusicSearchIndex()
+    : m_dead(0)
+{
+    clear();
+}
+
+QString MusicSearchIndex::fold(const QString &text)
+{
+    // Compatibility decomposition splits "é" into "e" and a combining accent,
+    // and ligatures such as "ﬁ" into their letters
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString folded;
+    folded.reserve(decomposed.size());
+    bool separator = false;
+    for (const QChar c : decomposed) {
+        if (c.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        if (c.isLetterOrNumber()) {
+            if (separator && !folded.isEmpty()) {
+                folded += QLatin1Char(' ');
+            }
+            folded += c.toCaseFolded();
+            separator = false;
+        } else {
+            separator = true;
+        }
+    }
+    return folded;
+}
+
+void MusicSearchIndex::add(const QString &path, const MediaTags &tags)
+{
+    remove(path);
+
+    const int doc = m_docs.size();
+    Doc entry;
+    entry.path = path;
+    entry.tags = tags;
+    m_docs.append(entry);
+    m_docByPath.insert(path, doc);
+
+    indexField(doc, TitleField, tags.title);
+    indexField(doc, ArtistField, tags.artist);
+    indexField(doc, AlbumField, tags.album);
+}
+
+void MusicSearchIndex::remove(const QString &path)
+{
+    const auto it = m_docByPath.find(path);
+    if (it == m_docByPath.end()) {
+        return;
+    }
+    m_docs[it.value()].alive = false;
+    m_docByPath.erase(it);
+    ++m_dead;
+
+    if (m_dead >= MinDeadForRebuild && m_dead * 2 > m_docs.size()) {
+        rebuild();
+    }
+}
+
+void MusicSearchIndex::clear()
+{
+    m_docs.clear();
+    m_docByPath.clear();
+    m_dead = 0;
+    m_nodes.clear();
+    m_nodes.append(TrieNode());
+    m_postings.clear();
+    m_trigrams.clear();
+}
+
+QVector<SearchResult> MusicSearchIndex::search(const QString &query, int limit, const std::atomic<bool> *cancelled) const
+{
+    const QStringList words = fold(query).split(QLatin1Char(' '), Qt::SkipEmptyParts).mid(0, MaxQueryWords);
+    if (words.isEmpty() || limit <= 0) {
+        return QVector<SearchResult>();
+    }
+    auto isCancelled = [cancelled] { return cancelled && cancelled->load(std::memory_order_relaxed); };
+
+    // Per track: how many query words matched so far, their summed weight,
+    // and the best weight for the current word
+    QVector<quint8> matched(m_docs.size(), 0);
+    QVector<float> score(m_docs.size(), 0.0f);
+    QVector<float> best(m_docs.size(), 0.0f);
+    QVector<int> touched;
+    QVector<int> stack;
+
+    for (int w = 0; w < words.size(); ++w) {
+        touched.clear();
+        const int prefixNode = findNode(words.at(w));
+        if (prefixNode >= 0) {
+            stack = { prefixNode };
+        }
+        // Every word in the subtree has the query word as a prefix
+        while (!stack.isEmpty()) {
+            const int n = stack.takeLast();
+            const TrieNode &node = m_nodes.at(n);
+            if (node.word >= 0) {
+                const float exact = n == prefixNode ? 2.0f : 1.0f;
+                for (const Posting &posting : m_postings.at(node.word)) {
+                    // Only tracks that matched every earlier word can still match
+                    if (matched.at(posting.doc) != w || !m_docs.at(posting.doc).alive) {
+                        continue;
+                    }
+                    float &docBest = best[posting.doc];
+                    if (docBest == 0.0f) {
+                        touched.append(posting.doc);
+                    }
+                    docBest = qMax(docBest, FieldWeight[posting.field] * exact);
+                }
+                if (isCancelled()) {
+                    return QVector<SearchResult>();
+                }
+            }
+            for (int child = node.firstChild; child >= 0; child = m_nodes.at(child).nextSibling) {
+                stack.append(child);
+            }
+        }
+
+        for (int doc : touched) {
+            score[doc] += best.at(doc);
+            best[doc] = 0.0f;
+            matched[doc] = static_cast<quint8>(w + 1);
+        }
+        if (touched.isEmpty()) {
+            break;
+        }
+    }
+
+    // Tracks matching every word as a prefix score at least 1 per word
+    QVector<QPair<float, int>> ranked;
+    ranked.reserve(touched.size());
+    for (int doc : touched) {
+        ranked.append(qMakePair(score.at(doc), doc));
+    }
+
+    // Too few: fill with tracks sharing at least half the query's trigrams,
+    // which score below 1
+    if (ranked.size() < limit) {
+        QVector<quint64> queryTrigrams;
+        for (const QString &word : words) {
+            const QString padded = QLatin1Char(' ') + word + QLatin1Char(' ');
+            for (int i = 0; i + 3 <= padded.size(); ++i) {
+                queryTrigrams.append(trigram(padded.constData() + i));
+            }
+        }
+        std::sort(queryTrigrams.begin(), queryTrigrams.end());
+        queryTrigrams.erase(std::unique(queryTrigrams.begin(), queryTrigrams.end()), queryTrigrams.end());
+
+        QVector<quint16> shared(m_docs.size(), 0);
+        QVector<int> candidates;
+        for (quint64 key : queryTrigrams) {
+            const auto it = m_trigrams.constFind(key);
+            if (it == m_trigrams.constEnd()) {
+                continue;
+            }
+            for (int doc : it.value()) {
+                if (shared[doc]++ == 0) {
+                    candidates.append(doc);
+                }
+            }
+            if (isCancelled()) {
+                return QVector<SearchResult>();
+            }
+        }
+
+        const int needed = (queryTrigrams.size() + 1) / 2;
+        for (int doc : candidates) {
+            if (shared.at(doc) >= needed && matched.at(doc) != words.size() && m_docs.at(doc).alive) {
+                ranked.append(qMakePair(float(shared.at(doc)) / queryTrigrams.size(), doc));
+            }
+        }
+    }
+
+    // Ties go to the track found first
+    const int count = qMin(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const QPair<float, int> &a, const QPair<float, int> &b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    QVector<SearchResult> results;
+    results.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Doc &doc = m_docs.at(ranked.at(i).second);
+        SearchResult result;
+        result.path = doc.path;
+        result.tags = doc.tags;
+        result.score = ranked.at(i).first;
+        results.append(result);
+    }
+    return results;
+}
+
+quint64 MusicSearchIndex::trigram(const QChar *p)
+{
+    return quint64(p[0].unicode()) << 32 | quint64(p[1].unicode()) << 16 | p[2].unicode();
+}
+
+void MusicSearchIndex::indexField(int doc, Field field, const QString &text)
+{
+    const QStringList words = fold(text).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    for (const QString &word : words) {
+        QVector<Posting> &postings = m_postings[wordId(word)];
+        if (postings.isEmpty() || postings.constLast().doc != doc) {
+            postings.append(Posting{ doc, field });
+        }
+
+        // Padded, so word starts and ends weigh in fuzzy matching too
+        const QString padded = QLatin1Char(' ') + word + QLatin1Char(' ');
+        for (int i = 0; i + 3 <= padded.size(); ++i) {
+            QVector<int> &docs = m_trigrams[trigram(padded.constData() + i)];
+            if (docs.isEmpty() || docs.constLast() != doc) {
+                docs.append(doc);
+            }
+        }
+    }
+}
+
+int MusicSearchIndex::wordId(const QString &word)
+{
+    int n = 0;
+    for (const QChar c : word) {
+        int child = m_nodes.at(n).firstChild;
+        while (child >= 0 && m_nodes.at(child).ch != c) {
+            child = m_nodes.at(child).nextSibling;
+        }
+        if (child < 0) {
+            TrieNode node;
+            node.ch = c;
+            node.nextSibling = m_nodes.at(n).firstChild;
+            child = m_nodes.size();
+            m_nodes.append(node);
+            m_nodes[n].firstChild = child;
+        }
+        n = child;
+    }
+
+    if (m_nodes.at(n).word < 0) {
+        m_nodes[n].word = m_postings.size();
+        m_postings.append(QVector<Posting>());
+    }
+    return m_nodes.at(n).word;
+}
+
+int MusicSearchIndex::findNode(const QString &prefix) const
+{
+    int n = 0;
+    for (const QChar c : prefix) {
+        int child = m_nodes.at(n).firstChild;
+        while (child >= 0 && m_nodes.at(child).ch != c) {
+            child = m_nodes.at(child).nextSibling;
+        }
+        if (child < 0) {
+            return -1;
+        }
+        n = child;
+    }
+    return n;
+}
+
+void MusicSearchIndex::rebuild()
+{
+    const QVector<Doc> docs = m_docs;
+    clear();
+    for (const Doc &doc : docs) {
+        if (doc.alive) {
+            add(doc.path, doc.tags);
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#include "musicwatcher.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t WatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+        | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+} // namespace
+
+MusicWatcher::MusicWatcher(QObject *parent)
+    : QObject(parent)
+    , m_fd(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , m_notifier(nullptr)
+    , m_warnedLimit(false)
+{
+    if (m_fd < 0) {
+        qWarning() << "MusicWatcher: inotify unavailable, library changes need a rescan:" << qt_error_string(errno);
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &MusicWatcher::readEvents);
+
+    m_coalesceTimer.setSingleShot(true);
+    connect(&m_coalesceTimer, &QTimer::timeout, this, &MusicWatcher::flush);
+}
+
+MusicWatcher::~MusicWatcher()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+void MusicWatcher::reset(const QString &root, const QStringList &nameFilters)
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_directories.constBegin(); it != m_directories.constEnd(); ++it) {
+        ::inotify_rm_watch(m_fd, it.key());
+    }
+    m_directories.clear();
+    m_root = QDir(root).absolutePath();
+    m_nameFilters = nameFilters;
+    m_files.clear();
+    m_pendingDirectories.clear();
+    m_coalesceTimer.stop();
+    m_pendingSince.invalidate();
+}
+
+void MusicWatcher::watchDirectory(const QString &path)
+{
+    if (m_fd < 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const int wd = ::inotify_add_watch(m_fd, QFile::encodeName(path).constData(), WatchMask);
+    if (wd >= 0) {
+        m_directories.insert(wd, path);
+    } else if (errno == ENOSPC && !m_warnedLimit) {
+        m_warnedLimit = true;
+        qWarning() << "MusicWatcher: out of inotify watches at" << path
+                   << "- raise fs.inotify.max_user_watches to follow the whole library";
+    }
+}
+
+void MusicWatcher::readEvents()
+{
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    bool overflow = false;
+    QMutexLocker locker(&m_mutex);
+
+    ssize_t length;
+    while ((length = ::read(m_fd, buffer, sizeof(buffer))) > 0) {
+        for (const char *p = buffer; p < buffer + length;) {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            const auto directory = m_directories.constFind(event->wd);
+            if (directory == m_directories.constEnd()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_directories.erase(m_directories.find(event->wd));
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // The parent reports all but the root itself
+                if (*directory == m_root) {
+                    m_pendingDirectories.insert(m_root, false);
+                }
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+
+            const QString name = QFile::decodeName(event->name);
+            const QString path = *directory + QLatin1Char('/') + name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    m_pendingDirectories.insert(path, true);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    // A directory moved out keeps its watches otherwise
+                    unwatchTree(path);
+                    m_pendingDirectories.insert(path, false);
+                }
+            } else if (QDir::match(m_nameFilters, name)) {
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    m_files.insert(path, true);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    m_files.insert(path, false);
+                }
+            }
+        }
+    }
+    locker.unlock();
+
+    if (overflow) {
+        qWarning() << "MusicWatcher: event queue overflowed, rescanning" << m_root;
+        m_files.clear();
+        m_pendingDirectories.clear();
+        m_coalesceTimer.stop();
+        m_pendingSince.invalidate();
+        emit overflowed();
+    } else if (!m_files.isEmpty() || !m_pendingDirectories.isEmpty()) {
+        // Each event restarts the quiet period, up to the latency cap
+        if (!m_pendingSince.isValid()) {
+            m_pendingSince.start();
+        }
+        const qint64 remainingMs = MaxLatencyMs - m_pendingSince.elapsed();
+        m_coalesceTimer.start(static_cast<int>(qBound<qint64>(0, remainingMs, QuietMs)));
+    }
+}
+
+void MusicWatcher::flush()
+{
+    MusicChanges changes;
+    for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        (it.value() ? changes.files : changes.removedFiles).append(it.key());
+    }
+    for (auto it = m_pendingDirectories.constBegin(); it != m_pendingDirectories.constEnd(); ++it) {
+        (it.value() ? changes.directories : changes.removedDirectories).append(it.key());
+    }
+    m_files.clear();
+    m_pendingDirectories.clear();
+    m_pendingSince.invalidate();
+
+    // Hash order otherwise; new tracks are appended in name order
+    changes.files.sort();
+    changes.directories.sort();
+    if (!changes.isEmpty()) {
+        emit changed(changes);
+    }
+}
+
+void MusicWatcher::unwatchTree(const QString &path)
+{
+    const QString prefix = path + QLatin1Char('/');
+    for (auto it = m_directories.begin(); it != m_directories.end();) {
+        if (it.value() == path || it.value().startsWith(prefix)) {
+            ::inotify_rm_watch(m_fd, it.key());
+            it = m_directories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
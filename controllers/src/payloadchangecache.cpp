@@ -0,0 +1,56 @@
+#include "payloadchangecache.h"
+
+void PayloadChangeCache::rebuild(const CanDecodeTable &table)
+{
+    const QVector<CanDecodeTable::Message> &messages = table.messages();
+    m_entries.resize(messages.size());
+    for (int m = 0; m < messages.size(); ++m) {
+        const CanDecodeTable::Message &message = messages.at(m);
+        Entry &entry = m_entries[m];
+        std::memset(entry.byteSignals, 0, sizeof(entry.byteSignals));
+        entry.stats = Stats();
+        entry.frameId = message.id;
+        entry.length = -1;
+        entry.signalMask = message.signalCount < CanDecodeTable::SelectableSignals
+                ? (quint64(1) << message.signalCount) - 1 : CanDecodeTable::AllSignals;
+
+        quint64 multiplexed = 0;
+        for (int ordinal = 0; ordinal < message.signalCount; ++ordinal) {
+            const CanDecodeTable::Signal &signal = table.signalAt(message.firstSignal + ordinal);
+            // Signals past the selectable ones are decoded whenever anything changes
+            const quint64 bit = ordinal < CanDecodeTable::SelectableSignals
+                    ? quint64(1) << ordinal : CanDecodeTable::AllSignals;
+            if (signal.flags & CanDecodeTable::Multiplexed) {
+                multiplexed |= bit;
+            }
+            // Little- and big-endian signals both span [byteOffset, minLength)
+            const int last = qMin(static_cast<int>(signal.minLength), static_cast<int>(CanFrame::MaxPayload));
+            for (int byte = signal.byteOffset; byte < last; ++byte) {
+                entry.byteSignals[byte] |= bit;
+            }
+        }
+
+        // A new multiplexor value selects other signals, whatever their bytes did
+        if (message.multiplexor >= 0) {
+            const CanDecodeTable::Signal &selector = table.signalAt(message.multiplexor);
+            const int last = qMin(static_cast<int>(selector.minLength), static_cast<int>(CanFrame::MaxPayload));
+            for (int byte = selector.byteOffset; byte < last; ++byte) {
+                entry.byteSignals[byte] |= multiplexed;
+            }
+        }
+    }
+}
+
+void PayloadChangeCache::invalidate()
+{
+    for (Entry &entry : m_entries) {
+        entry.length = -1;
+    }
+}
+
+void PayloadChangeCache::resetStats()
+{
+    for (Entry &entry : m_entries) {
+        entry.stats = Stats();
+    }
+}
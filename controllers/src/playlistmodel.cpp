@@ -0,0 +1,205 @@
+#include "playlistmodel.h"
+#include <QFileInfo>
+
+PlaylistModel::PlaylistModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int PlaylistModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_tracks.size();
+}
+
+QVariant PlaylistModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_tracks.size()) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+    switch (role) {
+    case Qt::DisplayRole:
+    case TitleRole: return named(row).title;
+    case ArtistRole: return named(row).artist;
+    case AlbumRole: return m_tracks.at(row).album;
+    case DurationRole: return m_tracks.at(row).durationMs;
+    case PathRole: return m_tracks.at(row).path;
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> PlaylistModel::roleNames() const
+{
+    return {
+        { TitleRole, "title" },
+        { ArtistRole, "artist" },
+        { AlbumRole, "album" },
+        { DurationRole, "duration" },
+        { PathRole, "path" }
+    };
+}
+
+QVariantMap PlaylistModel::get(int row) const
+{
+    QVariantMap result;
+    if (row < 0 || row >= m_tracks.size()) {
+        return result;
+    }
+
+    const QModelIndex modelIndex = index(row);
+    const QHash<int, QByteArray> roles = roleNames();
+    for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+        result.insert(QString::fromLatin1(it.value()), data(modelIndex, it.key()));
+    }
+    return result;
+}
+
+QString PlaylistModel::path(int row) const
+{
+    return row >= 0 && row < m_tracks.size() ? m_tracks.at(row).path : QString();
+}
+
+QString PlaylistModel::title(int row) const
+{
+    return row >= 0 && row < m_tracks.size() ? named(row).title : QString();
+}
+
+QString PlaylistModel::artist(int row) const
+{
+    return row >= 0 && row < m_tracks.size() ? named(row).artist : QString();
+}
+
+qint64 PlaylistModel::duration(int row) const
+{
+    return row >= 0 && row < m_tracks.size() ? m_tracks.at(row).durationMs : 0;
+}
+
+void PlaylistModel::append(const QStringList &paths)
+{
+    append(paths, QVector<MediaTags>(paths.size()));
+}
+
+void PlaylistModel::append(const QStringList &paths, const QVector<MediaTags> &tags)
+{
+    if (paths.isEmpty() || tags.size() != paths.size()) {
+        return;
+    }
+
+    const int first = m_tracks.size();
+    beginInsertRows(QModelIndex(), first, first + paths.size() - 1);
+    m_tracks.reserve(first + paths.size());
+    for (int i = 0; i < paths.size(); ++i) {
+        const MediaTags &trackTags = tags.at(i);
+        Track track;
+        track.path = paths.at(i);
+        track.title = trackTags.title;
+        track.artist = trackTags.artist;
+        track.album = trackTags.album;
+        track.durationMs = trackTags.durationMs;
+        m_tracks.append(track);
+    }
+    endInsertRows();
+    emit countChanged();
+}
+
+void PlaylistModel::remove(int row, int count)
+{
+    if (row < 0 || count <= 0 || row + count > m_tracks.size()) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    m_tracks.remove(row, count);
+    endRemoveRows();
+    emit countChanged();
+}
+
+bool PlaylistModel::move(int from, int to)
+{
+    if (from < 0 || from >= m_tracks.size() || to < 0 || to >= m_tracks.size() || from == to) {
+        return false;
+    }
+
+    // beginMoveRows() takes the row to insert before, counted before the move
+    if (!beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to)) {
+        return false;
+    }
+    m_tracks.move(from, to);
+    endMoveRows();
+    return true;
+}
+
+void PlaylistModel::clear()
+{
+    if (m_tracks.isEmpty()) {
+        return;
+    }
+
+    beginResetModel();
+    m_tracks.clear();
+    m_tracks.squeeze();
+    endResetModel();
+    emit countChanged();
+}
+
+void PlaylistModel::setMetadata(int row, const QString &title, const QString &artist, const QString &album)
+{
+    if (row < 0 || row >= m_tracks.size()) {
+        return;
+    }
+
+    Track &track = m_tracks[row];
+    named(row);
+    if (!title.isEmpty()) {
+        track.title = title;
+    }
+    if (!artist.isEmpty()) {
+        track.artist = artist;
+    }
+    if (!album.isEmpty()) {
+        track.album = album;
+    }
+    const QModelIndex modelIndex = index(row);
+    emit dataChanged(modelIndex, modelIndex, { Qt::DisplayRole, TitleRole, ArtistRole, AlbumRole });
+}
+
+void PlaylistModel::setDuration(int row, qint64 durationMs)
+{
+    if (row < 0 || row >= m_tracks.size() || m_tracks.at(row).durationMs == durationMs) {
+        return;
+    }
+
+    m_tracks[row].durationMs = durationMs;
+    const QModelIndex modelIndex = index(row);
+    emit dataChanged(modelIndex, modelIndex, { DurationRole });
+}
+
+QString PlaylistModel::titleFromFileName(const QString &path)
+{
+    const QString baseName = QFileInfo(path).baseName();
+    return baseName.contains(QLatin1String(" - "))
+            ? baseName.section(QLatin1String(" - "), 1, 1).trimmed() : baseName;
+}
+
+QString PlaylistModel::artistFromFileName(const QString &path)
+{
+    const QString baseName = QFileInfo(path).baseName();
+    return baseName.contains(QLatin1String(" - "))
+            ? baseName.section(QLatin1String(" - "), 0, 0).trimmed() : QStringLiteral("Unknown Artist");
+}
+
+const PlaylistModel::Track &PlaylistModel::named(int row) const
+{
+    const Track &track = m_tracks.at(row);
+    if (!track.named) {
+        if (track.title.isEmpty()) {
+            track.title = titleFromFileName(track.path);
+        }
+        if (track.artist.isEmpty()) {
+            track.artist = artistFromFileName(track.path);
+        }
+        track.named = true;
+    }
+    return track;
+}
@@ -0,0 +1,138 @@
+#include "searchresultsmodel.h"
+#include "musicsearch.h"
+#include <QSet>
+
+SearchResultsModel::SearchResultsModel(MusicSearch *search, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_search(search)
+    , m_queryId(0)
+    , m_resultsQueryId(0)
+{
+    // Queued: results arrive from the search thread
+    connect(m_search, &MusicSearch::resultsReady, this, &SearchResultsModel::handleResults);
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_results.size();
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_results.size()) {
+        return QVariant();
+    }
+
+    const SearchResult &result = m_results.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case TitleRole: return result.tags.title;
+    case ArtistRole: return result.tags.artist;
+    case AlbumRole: return result.tags.album;
+    case DurationRole: return result.tags.durationMs;
+    case PathRole: return result.path;
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> SearchResultsModel::roleNames() const
+{
+    return {
+        { TitleRole, "title" },
+        { ArtistRole, "artist" },
+        { AlbumRole, "album" },
+        { DurationRole, "duration" },
+        { PathRole, "path" }
+    };
+}
+
+QVariantMap SearchResultsModel::get(int row) const
+{
+    QVariantMap result;
+    if (row < 0 || row >= m_results.size()) {
+        return result;
+    }
+
+    const QModelIndex modelIndex = index(row);
+    const QHash<int, QByteArray> roles = roleNames();
+    for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+        result.insert(QString::fromLatin1(it.value()), data(modelIndex, it.key()));
+    }
+    return result;
+}
+
+void SearchResultsModel::setQuery(const QString &query)
+{
+    if (query == m_query) {
+        return;
+    }
+    m_query = query;
+    m_queryId = m_search->query(query);
+    emit queryChanged(m_query);
+}
+
+void SearchResultsModel::handleResults(int queryId, const QVector<SearchResult> &results)
+{
+    if (queryId != m_queryId) {
+        return;
+    }
+
+    const int oldCount = m_results.size();
+    if (queryId != m_resultsQueryId) {
+        // A new query shares little with the last one's rows
+        beginResetModel();
+        m_results = results;
+        m_resultsQueryId = queryId;
+        endResetModel();
+    } else {
+        // The same query after a library change: keep the rows that stayed,
+        // so views hold their place
+        updateResults(results);
+    }
+    if (m_results.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+void SearchResultsModel::updateResults(const QVector<SearchResult> &results)
+{
+    QSet<QString> kept;
+    for (const SearchResult &result : results) {
+        kept.insert(result.path);
+    }
+    for (int row = m_results.size() - 1; row >= 0; --row) {
+        if (!kept.contains(m_results.at(row).path)) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_results.remove(row);
+            endRemoveRows();
+        }
+    }
+
+    // At most a screenful of rows, so a linear search for each is fine
+    for (int row = 0; row < results.size(); ++row) {
+        const SearchResult &result = results.at(row);
+        int from = row;
+        while (from < m_results.size() && m_results.at(from).path != result.path) {
+            ++from;
+        }
+        if (from == m_results.size()) {
+            beginInsertRows(QModelIndex(), row, row);
+            m_results.insert(row, result);
+            endInsertRows();
+            continue;
+        }
+        if (from != row) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            m_results.move(from, row);
+            endMoveRows();
+        }
+
+        const MediaTags &tags = m_results.at(row).tags;
+        const bool changed = tags.title != result.tags.title || tags.artist != result.tags.artist
+                || tags.album != result.tags.album || tags.durationMs != result.tags.durationMs;
+        m_results[row] = result;
+        if (changed) {
+            emit dataChanged(index(row), index(row));
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#include "signalregistry.h"
+#include "dbcdatabase.h"
+
+void SignalRegistry::rebuild(const DbcDatabase &database)
+{
+    m_info.clear();
+    m_indexByName.clear();
+
+    // Same flattening as CanDecodeTable::compile, so IDs match table indices
+    for (const DbcMessage &message : database.messages()) {
+        for (const DbcSignal &dbcSignal : message.signalList) {
+            SignalInfo info;
+            info.name = dbcSignal.name;
+            info.message = message.name;
+            info.unit = dbcSignal.unit;
+            info.minimum = dbcSignal.minimum;
+            info.maximum = dbcSignal.maximum;
+            info.factor = dbcSignal.factor;
+            info.offset = dbcSignal.offset;
+            info.frameId = message.id;
+            info.extendedFrame = message.extended;
+
+            // Names are only unique per message; the first one wins a plain lookup
+            if (!m_indexByName.contains(info.name)) {
+                m_indexByName.insert(info.name, m_info.size());
+            }
+            m_indexByName.insert(message.name + QLatin1Char('.') + info.name, m_info.size());
+            m_info.append(info);
+        }
+    }
+
+    const int signalCount = m_info.size();
+    m_values.fill(0.0, signalCount);
+    m_timestamps.fill(0, signalCount);
+    m_generations.fill(0, signalCount);
+    m_stale.fill(false, signalCount);
+    m_changed.fill(0, (signalCount + 63) / 64);
+    m_changeCount = 0;
+}
@@ -0,0 +1,97 @@
+#include "signalsubscription.h"
+
+SignalSubscription::SignalSubscription(QObject *parent)
+    : QObject(parent)
+    , m_active(true)
+    , m_stale(false)
+{
+}
+
+SignalSubscription::~SignalSubscription()
+{
+    release();
+}
+
+void SignalSubscription::setSource(QObject *source)
+{
+    if (m_source == source) {
+        return;
+    }
+    release();
+    if (m_source) {
+        disconnect(m_source.data(), nullptr, this, nullptr);
+    }
+    m_source = source;
+    // Sources without staleness tracking are simply never stale
+    if (m_source && m_source->metaObject()->indexOfSignal("stalenessChanged()") >= 0) {
+        connect(m_source, SIGNAL(stalenessChanged()), this, SLOT(updateStale()));
+    }
+    acquire();
+    updateStale();
+    emit sourceChanged();
+}
+
+void SignalSubscription::setSignalNames(const QStringList &signalNames)
+{
+    if (m_signalNames == signalNames) {
+        return;
+    }
+    release();
+    m_signalNames = signalNames;
+    acquire();
+    updateStale();
+    emit signalNamesChanged();
+}
+
+void SignalSubscription::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+    release();
+    m_active = active;
+    acquire();
+    emit activeChanged();
+}
+
+void SignalSubscription::acquire()
+{
+    if (!m_active || !m_source) {
+        return;
+    }
+    for (const QString &name : qAsConst(m_signalNames)) {
+        QMetaObject::invokeMethod(m_source, "subscribe", Q_ARG(QString, name));
+    }
+    m_held = m_signalNames;
+}
+
+void SignalSubscription::release()
+{
+    // The source may already be gone at shutdown; nothing to release then
+    if (m_source) {
+        for (const QString &name : qAsConst(m_held)) {
+            QMetaObject::invokeMethod(m_source, "unsubscribe", Q_ARG(QString, name));
+        }
+    }
+    m_held.clear();
+}
+
+void SignalSubscription::updateStale()
+{
+    bool stale = false;
+    if (m_source && m_source->metaObject()->indexOfMethod("isStale(QString)") >= 0) {
+        for (const QString &name : qAsConst(m_signalNames)) {
+            bool signalStale = false;
+            QMetaObject::invokeMethod(m_source, "isStale", Q_RETURN_ARG(bool, signalStale), Q_ARG(QString, name));
+            if (signalStale) {
+                stale = true;
+                break;
+            }
+        }
+    }
+
+    if (m_stale != stale) {
+        m_stale = stale;
+        emit staleChanged();
+    }
+}
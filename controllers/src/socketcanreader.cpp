@@ -0,0 +1,308 @@
+#include "socketcanreader.h"
+#include "canframering.h"
+#include "canframe.h"
+#include <QDebug>
+#include <QVector>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Preallocated recvmmsg() scatter buffers, reused for every batch
+struct SocketCanReader::Buffers
+{
+    mmsghdr messages[BatchSize];
+    iovec vectors[BatchSize];
+    canfd_frame frames[BatchSize]; // Classic frames arrive as the CAN_MTU-sized prefix
+    char control[BatchSize][CMSG_SPACE(sizeof(scm_timestamping))];
+};
+
+SocketCanReader::SocketCanReader(CanFrameRing *ring, QObject *parent)
+    : QThread(parent)
+    , m_ring(ring)
+    , m_statistics(nullptr)
+    , m_buffers(new Buffers)
+    , m_socket(-1)
+    , m_wakeFd(-1)
+    , m_stopRequested(false)
+{
+    setObjectName(QStringLiteral("CanIngestNative"));
+
+    std::memset(m_buffers, 0, sizeof(Buffers));
+    for (int i = 0; i < BatchSize; ++i) {
+        m_buffers->vectors[i].iov_base = &m_buffers->frames[i];
+        m_buffers->vectors[i].iov_len = sizeof(canfd_frame);
+        m_buffers->messages[i].msg_hdr.msg_iov = &m_buffers->vectors[i];
+        m_buffers->messages[i].msg_hdr.msg_iovlen = 1;
+        m_buffers->messages[i].msg_hdr.msg_control = m_buffers->control[i];
+    }
+}
+
+SocketCanReader::~SocketCanReader()
+{
+    close();
+    delete m_buffers;
+}
+
+bool SocketCanReader::open(const QString &interface)
+{
+    close();
+
+    m_socket = ::socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (m_socket < 0) {
+        m_errorString = QStringLiteral("socket(): %1").arg(QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+
+    const unsigned int ifIndex = if_nametoindex(interface.toLocal8Bit().constData());
+    if (ifIndex == 0) {
+        m_errorString = QStringLiteral("Unknown CAN interface: %1").arg(interface);
+        close();
+        return false;
+    }
+
+    // Kernel receive timestamps, CLOCK_REALTIME like every other frame source.
+    // Raw hardware stamps count on the controller's own clock and are not asked for
+    int timestamping = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (::setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPING, &timestamping, sizeof(timestamping)) < 0) {
+        qWarning() << "SocketCanReader: SO_TIMESTAMPING unavailable:" << std::strerror(errno);
+    }
+
+    // Receive FD frames too; classic-only controllers simply never deliver any
+    int enableFd = 1;
+    if (::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enableFd, sizeof(enableFd)) < 0) {
+        qWarning() << "SocketCanReader: CAN FD frames unavailable:" << std::strerror(errno);
+    }
+
+    // Error frames are only delivered on request; they are counted, not decoded
+    can_err_mask_t errorMask = CAN_ERR_MASK;
+    if (::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errorMask, sizeof(errorMask)) < 0) {
+        qWarning() << "SocketCanReader: CAN_RAW_ERR_FILTER failed:" << std::strerror(errno);
+    }
+
+    // Drop undecoded IDs in the kernel before they ever wake this process
+    applyFrameIdFilter();
+
+    // Room for bursts while the reader thread is descheduled
+    int receiveBuffer = 1 << 20;
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+
+    sockaddr_can address;
+    std::memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = static_cast<int>(ifIndex);
+    if (::bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        m_errorString = QStringLiteral("bind(%1): %2").arg(interface, QString::fromLocal8Bit(std::strerror(errno)));
+        close();
+        return false;
+    }
+
+    m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    m_stopRequested.store(false);
+    m_errorString.clear();
+    return true;
+}
+
+void SocketCanReader::close()
+{
+    if (isRunning()) {
+        m_stopRequested.store(true);
+        const quint64 one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) < 0) {
+            qWarning() << "SocketCanReader: failed to wake reader thread";
+        }
+        wait();
+    }
+
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+}
+
+bool SocketCanReader::isOpen() const
+{
+    return m_socket >= 0;
+}
+
+bool SocketCanReader::writeFrame(quint32 frameId, const QByteArray &data)
+{
+    if (m_socket < 0) {
+        return false;
+    }
+
+    // Payloads over 8 bytes go out as FD frames, padded to a valid FD length
+    canfd_frame frame;
+    std::memset(&frame, 0, sizeof(frame));
+    const bool extended = (frameId & CanFrame::ExtendedIdFlag) || frameId > CAN_SFF_MASK;
+    frame.can_id = extended ? (frameId & CAN_EFF_MASK) | CAN_EFF_FLAG : frameId;
+    const int length = qMin(data.size(), CANFD_MAX_DLEN);
+    std::memcpy(frame.data, data.constData(), length);
+
+    size_t size = CAN_MTU;
+    if (length > CAN_MAX_DLEN) {
+        frame.len = static_cast<__u8>(CanFrame::dlcToLength(CanFrame::lengthToDlc(length)));
+        frame.flags = CANFD_BRS;
+        size = CANFD_MTU;
+    } else {
+        frame.len = static_cast<__u8>(length);
+    }
+    return ::write(m_socket, &frame, size) == static_cast<ssize_t>(size);
+}
+
+void SocketCanReader::setFrameIdFilter(const QList<quint32> &frameIds)
+{
+    m_frameIdFilter = frameIds;
+    if (m_socket >= 0) {
+        applyFrameIdFilter();
+    }
+}
+
+void SocketCanReader::applyFrameIdFilter()
+{
+    QVector<can_filter> filters;
+    if (m_frameIdFilter.isEmpty()) {
+        // Match-all, the kernel default for a fresh CAN_RAW socket
+        filters.append(can_filter{0, 0});
+    } else {
+        filters.reserve(m_frameIdFilter.size());
+        for (quint32 frameId : qAsConst(m_frameIdFilter)) {
+            can_filter filter;
+            // The format comes from the mark, not the ID: extended IDs can be small
+            if (frameId & CanFrame::ExtendedIdFlag) {
+                filter.can_id = (frameId & CAN_EFF_MASK) | CAN_EFF_FLAG;
+                filter.can_mask = CAN_EFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+            } else {
+                filter.can_id = frameId;
+                filter.can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+            }
+            filters.append(filter);
+        }
+    }
+
+    if (::setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.constData(),
+                     static_cast<socklen_t>(filters.size() * sizeof(can_filter))) < 0) {
+        qWarning() << "SocketCanReader: CAN_RAW_FILTER failed:" << std::strerror(errno);
+    }
+}
+
+QString SocketCanReader::errorString() const
+{
+    return m_errorString;
+}
+
+void SocketCanReader::run()
+{
+    pollfd fds[2];
+    fds[0].fd = m_socket;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    while (!m_stopRequested.load(std::memory_order_relaxed)) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const QString error = QStringLiteral("poll() failed: ") + QString::fromLocal8Bit(std::strerror(errno));
+            qWarning() << "SocketCanReader:" << error;
+            emit readFailed(error);
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        bool pushed = false;
+        int received = BatchSize;
+        // Keep draining the socket while full batches come back
+        while (received == BatchSize) {
+            for (int i = 0; i < BatchSize; ++i) {
+                m_buffers->messages[i].msg_hdr.msg_controllen = sizeof(m_buffers->control[i]);
+                m_buffers->messages[i].msg_hdr.msg_flags = 0;
+            }
+
+            received = ::recvmmsg(m_socket, m_buffers->messages, BatchSize, MSG_DONTWAIT, nullptr);
+            if (received <= 0) {
+                break;
+            }
+
+            for (int i = 0; i < received; ++i) {
+                const canfd_frame &raw = m_buffers->frames[i];
+                const unsigned int size = m_buffers->messages[i].msg_len;
+                if (size != CAN_MTU && size != CANFD_MTU) {
+                    continue;
+                }
+                if (raw.can_id & CAN_ERR_FLAG) {
+                    if (m_statistics) {
+                        m_statistics->recordErrorFrame();
+                    }
+                    continue;
+                }
+
+                // Zeroed: the payload past length goes into recordings as is
+                CanFrame frame;
+                std::memset(&frame, 0, sizeof(frame));
+                if (raw.can_id & CAN_EFF_FLAG) {
+                    frame.id = raw.can_id & CAN_EFF_MASK;
+                    frame.flags |= CanFrame::ExtendedId;
+                } else {
+                    frame.id = raw.can_id & CAN_SFF_MASK;
+                }
+                if (size == CANFD_MTU) {
+                    frame.flags |= CanFrame::FlexibleData;
+                    if (raw.flags & CANFD_BRS) frame.flags |= CanFrame::BitRateSwitch;
+                    if (raw.flags & CANFD_ESI) frame.flags |= CanFrame::ErrorState;
+                    frame.length = qMin<quint8>(raw.len, CANFD_MAX_DLEN);
+                } else {
+                    if (raw.can_id & CAN_RTR_FLAG) frame.flags |= CanFrame::RemoteRequest;
+                    frame.length = qMin<quint8>(raw.len, CAN_MAX_DLEN);
+                }
+                std::memcpy(frame.data, raw.data, frame.length);
+
+                msghdr &header = m_buffers->messages[i].msg_hdr;
+                for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+                    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMPING) {
+                        continue;
+                    }
+                    scm_timestamping stamps;
+                    std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+                    const timespec &ts = stamps.ts[0];
+                    frame.timestampNs = static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+                }
+
+                if (m_statistics) {
+                    m_statistics->recordFrame(frame);
+                }
+                if (m_ring->push(frame)) {
+                    pushed = true;
+                } else if (m_statistics) {
+                    m_statistics->recordDrop();
+                }
+            }
+        }
+
+        if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            const QString error = QStringLiteral("recvmmsg() failed: ") + QString::fromLocal8Bit(std::strerror(errno));
+            qWarning() << "SocketCanReader:" << error;
+            emit readFailed(error);
+            break;
+        }
+
+        if (pushed && m_ring->markPending()) {
+            emit framesPending();
+        }
+    }
+}
@@ -0,0 +1,623 @@
+#include "tagreader.h"
+#include <QByteArray>
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Read at the start of every file; holds all but the largest ID3v2 tags
+const qint64 HeadBytes = 64 * 1024;
+// Upper bound on one read, so a corrupt length cannot exhaust memory
+const qint64 MaxReadBytes = 16 * 1024 * 1024;
+
+// Bounds-checked view of bytes read from a file; offsets past the end read as nothing
+struct Bytes
+{
+    const uchar *data = nullptr;
+    qint64 size = 0;
+
+    bool has(qint64 offset, qint64 length) const
+    {
+        return offset >= 0 && length >= 0 && offset <= size && length <= size - offset;
+    }
+    Bytes sub(qint64 offset, qint64 length) const
+    {
+        return has(offset, length) ? Bytes{ data + offset, length } : Bytes();
+    }
+    bool startsWith(qint64 offset, const char *magic, int length) const
+    {
+        return has(offset, length) && std::memcmp(data + offset, magic, static_cast<size_t>(length)) == 0;
+    }
+    // Callers check has() first
+    quint32 be16(qint64 offset) const { return qFromBigEndian<quint16>(data + offset); }
+    quint32 be24(qint64 offset) const { return quint32(data[offset]) << 16 | be16(offset + 1); }
+    quint32 be32(qint64 offset) const { return qFromBigEndian<quint32>(data + offset); }
+    quint64 be64(qint64 offset) const { return qFromBigEndian<quint64>(data + offset); }
+    quint32 le32(qint64 offset) const { return qFromLittleEndian<quint32>(data + offset); }
+    quint64 le64(qint64 offset) const { return qFromLittleEndian<quint64>(data + offset); }
+
+    qint64 find(const char *magic, int length) const
+    {
+        if (!data) {
+            return -1;
+        }
+        const uchar *end = data + size;
+        const uchar *at = std::search(data, end, magic, magic + length,
+                                      [](uchar a, char b) { return a == static_cast<uchar>(b); });
+        return at == end ? -1 : at - data;
+    }
+};
+
+// Read with pread(), not mapped: a file truncated while it is parsed (a
+// copy still in progress, a share going away) then reads short instead of
+// raising SIGBUS in whichever thread touches the missing page
+class File
+{
+public:
+    explicit File(const QString &path)
+        : m_fd(::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC))
+        , m_size(0)
+    {
+        struct stat info;
+        if (m_fd >= 0 && ::fstat(m_fd, &info) == 0) {
+            m_size = info.st_size;
+        }
+    }
+
+    ~File()
+    {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool isReadable() const { return m_fd >= 0 && m_size > 0; }
+    qint64 size() const { return m_size; }
+
+    // Up to @p length bytes at @p offset; fewer past the end or on error
+    QByteArray read(qint64 offset, qint64 length) const
+    {
+        length = qBound<qint64>(0, qMin(length, m_size - offset), MaxReadBytes);
+        if (offset < 0 || length == 0) {
+            return QByteArray();
+        }
+        QByteArray buffer(static_cast<int>(length), Qt::Uninitialized);
+        qint64 done = 0;
+        while (done < length) {
+            const ssize_t n = ::pread(m_fd, buffer.data() + done, static_cast<size_t>(length - done), offset + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            done += n;
+        }
+        buffer.truncate(static_cast<int>(done));
+        return buffer;
+    }
+
+private:
+    Q_DISABLE_COPY(File)
+
+    const int m_fd;
+    qint64 m_size;
+};
+
+Bytes view(const QByteArray &bytes)
+{
+    return Bytes{ reinterpret_cast<const uchar *>(bytes.constData()), bytes.size() };
+}
+
+// --- ID3v2 ---
+
+qint64 synchsafe(const uchar *p)
+{
+    return qint64(p[0] & 0x7F) << 21 | qint64(p[1] & 0x7F) << 14 | qint64(p[2] & 0x7F) << 7 | (p[3] & 0x7F);
+}
+
+// Undoes the 0xFF 0x00 escaping of unsynchronised tags and frames
+QByteArray resynchronise(const Bytes &in)
+{
+    QByteArray out;
+    out.reserve(static_cast<int>(in.size));
+    for (qint64 i = 0; i < in.size; ++i) {
+        out += static_cast<char>(in.data[i]);
+        if (in.data[i] == 0xFF && i + 1 < in.size && in.data[i + 1] == 0x00) {
+            ++i;
+        }
+    }
+    return out;
+}
+
+// Text frame: an encoding byte, then one or more NUL-separated values
+QString decodeText(const Bytes &frame)
+{
+    if (frame.size < 2) {
+        return QString();
+    }
+
+    const char *text = reinterpret_cast<const char *>(frame.data + 1);
+    int length = static_cast<int>(frame.size - 1);
+    QString value;
+    switch (frame.data[0]) {
+    case 0:
+        value = QString::fromLatin1(text, length);
+        break;
+    case 3:
+        value = QString::fromUtf8(text, length);
+        break;
+    case 1:
+    case 2: {
+        // 1 starts with a byte order mark; 2 is big endian without one
+        bool littleEndian = false;
+        const uchar *p = frame.data + 1;
+        if (length >= 2 && ((p[0] == 0xFF && p[1] == 0xFE) || (p[0] == 0xFE && p[1] == 0xFF))) {
+            littleEndian = p[0] == 0xFF;
+            p += 2;
+            length -= 2;
+        }
+        value.resize(length / 2);
+        QChar *out = value.data();
+        for (int i = 0; i < length / 2; ++i, p += 2) {
+            out[i] = QChar(littleEndian ? ushort(p[0] | p[1] << 8) : ushort(p[0] << 8 | p[1]));
+        }
+        break;
+    }
+    default:
+        return QString();
+    }
+
+    const int nul = value.indexOf(QChar(0));
+    if (nul >= 0) {
+        value.truncate(nul);
+    }
+    return value.trimmed();
+}
+
+// Returns where the audio starts: the end of the tag, or 0 without one
+qint64 parseId3v2(const Bytes &file, MediaTags *tags)
+{
+    if (!file.startsWith(0, "ID3", 3) || !file.has(0, 10)) {
+        return 0;
+    }
+
+    const int major = file.data[3];
+    const uchar flags = file.data[5];
+    const qint64 tagSize = synchsafe(file.data + 6);
+    const qint64 end = 10 + tagSize + (major == 4 && (flags & 0x10) ? 10 : 0);
+    if (major < 2 || major > 4) {
+        return end;
+    }
+
+    Bytes tag = file.sub(10, qMin(tagSize, file.size - 10));
+    QByteArray resynchronised;
+    if ((flags & 0x80) && major < 4) {
+        resynchronised = resynchronise(tag);
+        tag = view(resynchronised);
+    }
+
+    qint64 pos = 0;
+    if ((flags & 0x40) && major >= 3 && tag.has(0, 4)) {
+        pos = major == 3 ? 4 + qint64(tag.be32(0)) : synchsafe(tag.data);
+    }
+
+    const int idLength = major == 2 ? 3 : 4;
+    const int headerLength = major == 2 ? 6 : 10;
+    while (tag.has(pos, headerLength) && tag.data[pos] != 0) {
+        const uchar *header = tag.data + pos;
+        const qint64 size = major == 2 ? tag.be24(pos + 3)
+                : major == 3 ? qint64(tag.be32(pos + 4)) : synchsafe(header + 4);
+        const quint32 frameFlags = major == 2 ? 0 : tag.be16(pos + 8);
+        Bytes frame = tag.sub(pos + headerLength, size);
+        pos += headerLength + size;
+        if (!frame.data) {
+            break;
+        }
+
+        QByteArray frameResynchronised;
+        if (major == 3 && (frameFlags & 0x00C0)) {
+            continue;   // Compressed or encrypted
+        }
+        if (major == 4) {
+            if (frameFlags & 0x000C) {
+                continue;
+            }
+            if (frameFlags & 0x0001) {
+                frame = frame.sub(4, frame.size - 4);   // Data length indicator
+            }
+            if ((frameFlags & 0x0002) || (flags & 0x80)) {
+                frameResynchronised = resynchronise(frame);
+                frame = view(frameResynchronised);
+            }
+        }
+
+        auto is = [header, idLength](const char *id) {
+            return std::memcmp(header, id, static_cast<size_t>(idLength)) == 0;
+        };
+        if (is(major == 2 ? "TT2" : "TIT2")) {
+            tags->title = decodeText(frame);
+        } else if (is(major == 2 ? "TP1" : "TPE1")) {
+            tags->artist = decodeText(frame);
+        } else if (is(major == 2 ? "TAL" : "TALB")) {
+            tags->album = decodeText(frame);
+        } else if (is(major == 2 ? "TLE" : "TLEN")) {
+            tags->durationMs = decodeText(frame).toLongLong();
+        }
+    }
+    return end;
+}
+
+// --- MPEG audio ---
+
+const qint64 MpegScanBytes = 64 * 1024;
+
+// From the Xing/Info or VBRI frame count, else the first frame's bitrate.
+// @p audio holds the first MpegScanBytes (and a frame header more) of the
+// @p audioSize bytes following the tag
+qint64 mpegDurationMs(const Bytes &audio, qint64 audioSize)
+{
+    static const int bitrates[5][14] = {
+        { 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },  // MPEG-1 layer I
+        { 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },     // MPEG-1 layer II
+        { 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },      // MPEG-1 layer III
+        { 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },     // MPEG-2/2.5 layer I
+        { 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }           // MPEG-2/2.5 layer II, III
+    };
+    static const int sampleRates[3] = { 44100, 48000, 32000 };
+
+    const qint64 limit = qMin(audio.size - 4, MpegScanBytes);
+    for (qint64 pos = 0; pos < limit; ++pos) {
+        const uchar *p = audio.data + pos;
+        if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) {
+            continue;
+        }
+        const int version = (p[1] >> 3) & 3;    // 0: 2.5, 2: 2, 3: 1
+        const int layer = (p[1] >> 1) & 3;      // 1: III, 2: II, 3: I
+        const int bitrateIndex = p[2] >> 4;
+        const int rateIndex = (p[2] >> 2) & 3;
+        if (version == 1 || layer == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+            continue;
+        }
+
+        const bool mpeg1 = version == 3;
+        const int sampleRate = sampleRates[rateIndex] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+        const int samplesPerFrame = layer == 3 ? 384 : (layer == 1 && !mpeg1) ? 576 : 1152;
+        const int row = mpeg1 ? 3 - layer : (layer == 3 ? 3 : 4);
+        const int kbps = bitrates[row][bitrateIndex - 1];
+
+        const bool mono = (p[3] >> 6) == 3;
+        const qint64 xing = pos + 4 + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+        quint32 frames = 0;
+        if ((audio.startsWith(xing, "Xing", 4) || audio.startsWith(xing, "Info", 4)) && audio.has(xing, 12)
+                && (audio.be32(xing + 4) & 0x1)) {
+            frames = audio.be32(xing + 8);
+        } else if (audio.startsWith(pos + 36, "VBRI", 4) && audio.has(pos + 36, 18)) {
+            frames = audio.be32(pos + 36 + 14);
+        }
+        if (frames > 0) {
+            return qint64(frames) * samplesPerFrame * 1000 / sampleRate;
+        }
+        // Constant bitrate; kilobits per second are bits per millisecond
+        return (audioSize - pos) * 8 / kbps;
+    }
+    return 0;
+}
+
+// --- Vorbis comments (FLAC, Ogg Vorbis, Opus) ---
+
+void parseVorbisComments(const Bytes &block, MediaTags *tags)
+{
+    qint64 pos = 0;
+    if (!block.has(pos, 4)) {
+        return;
+    }
+    pos += 4 + qint64(block.le32(pos));    // Vendor string
+    if (!block.has(pos, 4)) {
+        return;
+    }
+    const quint32 count = block.le32(pos);
+    pos += 4;
+
+    for (quint32 i = 0; i < count && block.has(pos, 4); ++i) {
+        const qint64 length = block.le32(pos);
+        pos += 4;
+        if (!block.has(pos, length)) {
+            return;
+        }
+        const char *comment = reinterpret_cast<const char *>(block.data + pos);
+        pos += length;
+
+        const char *equals = static_cast<const char *>(std::memchr(comment, '=', static_cast<size_t>(length)));
+        if (!equals || equals == comment) {
+            continue;
+        }
+        const QByteArray key = QByteArray(comment, static_cast<int>(equals - comment)).toUpper();
+        QString *field = key == "TITLE" ? &tags->title
+                : key == "ARTIST" ? &tags->artist
+                : key == "ALBUM" ? &tags->album : nullptr;
+        if (field && field->isEmpty()) {
+            *field = QString::fromUtf8(equals + 1, static_cast<int>(comment + length - equals - 1)).trimmed();
+        }
+    }
+}
+
+bool parseFlac(const File &file, qint64 offset, MediaTags *tags)
+{
+    if (file.read(offset, 4) != "fLaC") {
+        return false;
+    }
+
+    qint64 pos = offset + 4;
+    bool last = false;
+    while (!last) {
+        const QByteArray headerBytes = file.read(pos, 4);
+        const Bytes header = view(headerBytes);
+        if (!header.has(0, 4)) {
+            break;
+        }
+        last = header.data[0] & 0x80;
+        const int type = header.data[0] & 0x7F;
+        const qint64 length = header.be24(1);
+        pos += 4 + length;
+        // Pictures and padding are skipped unread
+        if (type != 0 && type != 4) {
+            continue;
+        }
+        const QByteArray blockBytes = file.read(pos - length, length);
+        if (blockBytes.size() < length) {
+            break;
+        }
+        const Bytes block = view(blockBytes);
+
+        if (type == 0 && block.has(10, 8)) {
+            // STREAMINFO: 20-bit sample rate ... 36-bit total samples
+            const uchar *p = block.data + 10;
+            const quint32 sampleRate = quint32(p[0]) << 12 | quint32(p[1]) << 4 | p[2] >> 4;
+            const quint64 totalSamples = quint64(p[3] & 0x0F) << 32 | block.be32(14);
+            if (sampleRate > 0 && tags->durationMs == 0) {
+                tags->durationMs = static_cast<qint64>(totalSamples * 1000 / sampleRate);
+            }
+        } else if (type == 4) {
+            parseVorbisComments(block, tags);
+        }
+    }
+    return true;
+}
+
+bool parseOgg(const File &file, const Bytes &start, MediaTags *tags)
+{
+    if (!start.startsWith(0, "OggS", 4)) {
+        return false;
+    }
+
+    // The identification and comment headers open the stream
+    const Bytes head = start.sub(0, qMin(start.size, HeadBytes));
+    quint32 sampleRate = 0;
+    qint64 at = head.find("\x01vorbis", 7);
+    if (at >= 0 && head.has(at + 12, 4)) {
+        sampleRate = head.le32(at + 12);
+    } else if (head.find("OpusHead", 8) >= 0) {
+        sampleRate = 48000;     // Opus granules always count at 48 kHz
+    }
+    if ((at = head.find("\x03vorbis", 7)) >= 0) {
+        parseVorbisComments(head.sub(at + 7, head.size - at - 7), tags);
+    } else if ((at = head.find("OpusTags", 8)) >= 0) {
+        parseVorbisComments(head.sub(at + 8, head.size - at - 8), tags);
+    }
+
+    // The last page's granule position is the length in samples
+    if (sampleRate > 0) {
+        const QByteArray tailBytes = file.read(qMax<qint64>(0, file.size() - 64 * 1024), 64 * 1024);
+        const Bytes tail = view(tailBytes);
+        for (qint64 pos = tail.size - 27; pos >= 0; --pos) {
+            if (tail.startsWith(pos, "OggS", 4)) {
+                const qint64 granule = static_cast<qint64>(tail.le64(pos + 6));
+                if (granule > 0) {
+                    tags->durationMs = granule * 1000 / sampleRate;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// --- MP4 ---
+
+// Calls visit(type, payload) for each atom in @p bytes while it returns true
+template<typename Visit>
+void forEachAtom(const Bytes &bytes, Visit visit)
+{
+    qint64 pos = 0;
+    while (bytes.has(pos, 8)) {
+        qint64 size = bytes.be32(pos);
+        qint64 header = 8;
+        if (size == 1) {
+            if (!bytes.has(pos, 16)) {
+                return;
+            }
+            size = static_cast<qint64>(bytes.be64(pos + 8));
+            header = 16;
+        } else if (size == 0) {
+            size = bytes.size - pos;    // Extends to the end
+        }
+        if (size < header || !bytes.has(pos, size)) {
+            return;
+        }
+        if (!visit(bytes.data + pos + 4, bytes.sub(pos + header, size - header))) {
+            return;
+        }
+        pos += size;
+    }
+}
+
+bool isAtom(const uchar *type, const char *name)
+{
+    return std::memcmp(type, name, 4) == 0;
+}
+
+void parseIlst(const Bytes &ilst, MediaTags *tags)
+{
+    forEachAtom(ilst, [tags](const uchar *type, const Bytes &item) {
+        QString *field = isAtom(type, "\xA9nam") ? &tags->title
+                : isAtom(type, "\xA9" "ART") ? &tags->artist
+                : isAtom(type, "\xA9" "alb") ? &tags->album : nullptr;
+        if (field) {
+            forEachAtom(item, [field](const uchar *dataType, const Bytes &data) {
+                // Type indicator and locale, then the value; type 1 is UTF-8
+                if (isAtom(dataType, "data") && data.has(0, 8) && data.be32(0) == 1) {
+                    *field = QString::fromUtf8(reinterpret_cast<const char *>(data.data + 8),
+                                               static_cast<int>(data.size - 8)).trimmed();
+                    return false;
+                }
+                return true;
+            });
+        }
+        return true;
+    });
+}
+
+void parseMoov(const Bytes &moov, MediaTags *tags)
+{
+    forEachAtom(moov, [tags](const uchar *childType, const Bytes &child) {
+        if (isAtom(childType, "mvhd") && child.has(0, 1)) {
+            // Version 1 has 64-bit times and duration
+            const bool wide = child.data[0] == 1;
+            const qint64 at = wide ? 20 : 12;
+            if (child.has(at, wide ? 12 : 8)) {
+                const quint32 timescale = child.be32(at);
+                const quint64 duration = wide ? child.be64(at + 4) : child.be32(at + 4);
+                if (timescale > 0) {
+                    tags->durationMs = static_cast<qint64>(duration * 1000 / timescale);
+                }
+            }
+        } else if (isAtom(childType, "udta")) {
+            forEachAtom(child, [tags](const uchar *metaType, const Bytes &meta) {
+                if (isAtom(metaType, "meta")) {
+                    // A full box in MP4, a plain one in QuickTime files
+                    const bool full = !meta.startsWith(4, "hdlr", 4);
+                    forEachAtom(full ? meta.sub(4, meta.size - 4) : meta,
+                                [tags](const uchar *listType, const Bytes &list) {
+                        if (isAtom(listType, "ilst")) {
+                            parseIlst(list, tags);
+                        }
+                        return true;
+                    });
+                }
+                return true;
+            });
+        }
+        return true;
+    });
+}
+
+bool parseMp4(const File &file, const Bytes &start, MediaTags *tags)
+{
+    if (!start.startsWith(4, "ftyp", 4)) {
+        return false;
+    }
+
+    // Top-level atoms are stepped over by their headers; only moov is read,
+    // and it often follows the whole mdat at the end of the file
+    qint64 pos = 0;
+    for (;;) {
+        const QByteArray headerBytes = file.read(pos, 16);
+        const Bytes header = view(headerBytes);
+        if (!header.has(0, 8)) {
+            break;
+        }
+        qint64 size = header.be32(0);
+        qint64 headerLength = 8;
+        if (size == 1) {
+            if (!header.has(0, 16)) {
+                break;
+            }
+            size = static_cast<qint64>(header.be64(8));
+            headerLength = 16;
+        } else if (size == 0) {
+            size = file.size() - pos;    // Extends to the end
+        }
+        if (size < headerLength || size > file.size() - pos) {
+            break;
+        }
+        if (isAtom(header.data + 4, "moov")) {
+            const QByteArray moov = file.read(pos + headerLength, size - headerLength);
+            parseMoov(view(moov), tags);
+            break;
+        }
+        pos += size;
+    }
+    return true;
+}
+
+// --- WAV ---
+
+bool parseWav(const File &file, const Bytes &start, MediaTags *tags)
+{
+    if (!start.startsWith(0, "RIFF", 4) || !start.startsWith(8, "WAVE", 4)) {
+        return false;
+    }
+
+    quint32 byteRate = 0;
+    qint64 pos = 12;
+    for (;;) {
+        // Chunk header, and the fmt fields up to the byte rate
+        const QByteArray chunkBytes = file.read(pos, 20);
+        const Bytes chunk = view(chunkBytes);
+        if (!chunk.has(0, 8)) {
+            break;
+        }
+        const qint64 size = chunk.le32(4);
+        if (chunk.startsWith(0, "fmt ", 4) && chunk.has(8, 12)) {
+            byteRate = chunk.le32(16);
+        } else if (chunk.startsWith(0, "data", 4)) {
+            if (byteRate > 0) {
+                tags->durationMs = qMin(size, file.size() - pos - 8) * 1000 / byteRate;
+            }
+            break;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return true;
+}
+
+} // namespace
+
+bool TagReader::read(const QString &path, MediaTags *tags)
+{
+    *tags = MediaTags();
+    const File file(path);
+    if (!file.isReadable()) {
+        return false;
+    }
+
+    QByteArray headBytes = file.read(0, HeadBytes);
+    // A tag larger than that (cover art, usually) is read whole
+    if (headBytes.startsWith("ID3") && headBytes.size() >= 10) {
+        const qint64 tagEnd = 10 + synchsafe(reinterpret_cast<const uchar *>(headBytes.constData()) + 6);
+        if (tagEnd > headBytes.size()) {
+            headBytes = file.read(0, tagEnd);
+        }
+    }
+    const Bytes head = view(headBytes);
+
+    const qint64 audioStart = parseId3v2(head, tags);
+    if (parseFlac(file, audioStart, tags) || parseOgg(file, head, tags) || parseMp4(file, head, tags)
+            || parseWav(file, head, tags)) {
+        return true;
+    }
+    // Frame sync bytes are common in other formats' data; only look in MP3s
+    if (tags->durationMs == 0 && (audioStart > 0 || path.endsWith(QLatin1String(".mp3"), Qt::CaseInsensitive))) {
+        const QByteArray audio = file.read(audioStart, MpegScanBytes + 64);
+        tags->durationMs = mpegDurationMs(view(audio), file.size() - audioStart);
+    }
+    return audioStart > 0 || tags->durationMs > 0;
+}
@@ -0,0 +1,133 @@
+#include "timingwheel.h"
+
+void TimingWheel::reset(int timerCount, qint64 now)
+{
+    m_nodes.fill(Node{ 0, -1, -1, -1 }, timerCount);
+    m_heads.fill(-1, Levels * Slots);
+    m_occupied.fill(0, Levels * Slots / 64);
+    m_now = now;
+    m_scheduled = 0;
+}
+
+void TimingWheel::schedule(int timer, qint64 expiry)
+{
+    if (m_nodes[timer].slot >= 0) {
+        unlink(timer);
+    }
+
+    m_nodes[timer].expiry = qMax(expiry, m_now + 1);
+    file(timer);
+}
+
+void TimingWheel::file(int timer)
+{
+    const qint64 expiry = m_nodes[timer].expiry;
+
+    // The lowest level whose span covers the delay; the slot is taken from
+    // the expiry's own bits so it lines up with the cascade in advance()
+    const quint64 delay = static_cast<quint64>(expiry - m_now);
+    int level = 0;
+    while (level < Levels - 1 && delay >= (quint64(1) << ((level + 1) * SlotBits))) {
+        ++level;
+    }
+    int index;
+    if (delay >= (quint64(1) << (Levels * SlotBits))) {
+        // Beyond the wheel: park in the last top-level slot and re-file from there
+        index = static_cast<int>(((m_now >> ((Levels - 1) * SlotBits)) - 1) & (Slots - 1));
+    } else {
+        index = static_cast<int>((expiry >> (level * SlotBits)) & (Slots - 1));
+    }
+    link(timer, level * Slots + index);
+}
+
+void TimingWheel::cancel(int timer)
+{
+    if (m_nodes[timer].slot >= 0) {
+        unlink(timer);
+    }
+}
+
+void TimingWheel::link(int timer, int slot)
+{
+    Node &node = m_nodes[timer];
+    node.slot = slot;
+    node.prev = -1;
+    node.next = m_heads[slot];
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = timer;
+    }
+    m_heads[slot] = timer;
+    m_occupied[slot >> 6] |= quint64(1) << (slot & 63);
+    ++m_scheduled;
+}
+
+void TimingWheel::unlink(int timer)
+{
+    Node &node = m_nodes[timer];
+    if (node.prev >= 0) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_heads[node.slot] = node.next;
+        if (node.next < 0) {
+            m_occupied[node.slot >> 6] &= ~(quint64(1) << (node.slot & 63));
+        }
+    }
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = node.prev;
+    }
+    node.slot = -1;
+    node.prev = -1;
+    node.next = -1;
+    --m_scheduled;
+}
+
+void TimingWheel::cascade(int level)
+{
+    const int slot = level * Slots + static_cast<int>((m_now >> (level * SlotBits)) & (Slots - 1));
+    int timer = m_heads[slot];
+    while (timer >= 0) {
+        const int next = m_nodes[timer].next;
+        unlink(timer);
+        // Due at the earliest now, in the first-level slot advance() handles next
+        file(timer);
+        timer = next;
+    }
+}
+
+qint64 TimingWheel::nextEvent() const
+{
+    qint64 next = -1;
+    if (m_scheduled == 0) {
+        return next;
+    }
+    for (int level = 0; level < Levels; ++level) {
+        // Slots of a level are reached one after another at multiples of its tick
+        const int shift = level * SlotBits;
+        const qint64 position = m_now >> shift;
+        const int distance = distanceToOccupied(level, static_cast<int>(position & (Slots - 1)));
+        if (distance > 0) {
+            const qint64 tick = (position + distance) << shift;
+            if (next < 0 || tick < next) {
+                next = tick;
+            }
+        }
+    }
+    return next;
+}
+
+int TimingWheel::distanceToOccupied(int level, int index) const
+{
+    const quint64 *words = m_occupied.constData() + level * (Slots / 64);
+    const int end = index + Slots + 1;
+    int position = index + 1;
+    while (position < end) {
+        const int slot = position & (Slots - 1);
+        const quint64 bits = words[slot >> 6] >> (slot & 63);
+        if (bits) {
+            const int found = position + static_cast<int>(qCountTrailingZeroBits(bits));
+            return found < end ? found - index : 0;
+        }
+        position += 64 - (slot & 63);
+    }
+    return 0;
+}
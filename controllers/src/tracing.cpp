@@ -0,0 +1,199 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    qint64 beginNs;
+    qint64 endNs;
+};
+
+struct ThreadRing
+{
+    int tid = 0;
+    QByteArray threadName;
+    std::atomic<quint64> written{ 0 };  // Events ever recorded; the writer's position
+    Event events[Tracing::RingSize];
+};
+
+struct Registry
+{
+    QMutex mutex;   // Registration and export only
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadRing *t_ring = nullptr;
+
+ThreadRing *registerThread()
+{
+    auto ring = std::make_unique<ThreadRing>();
+    QThread *thread = QThread::currentThread();
+    ring->threadName = thread ? thread->objectName().toUtf8() : QByteArray();
+    if (ring->threadName.isEmpty()) {
+        QCoreApplication *app = QCoreApplication::instance();
+        ring->threadName = thread && app && thread == app->thread()
+                ? QByteArray("GUI") : QByteArray("Thread");
+    }
+
+    Registry &instance = registry();
+    QMutexLocker locker(&instance.mutex);
+    ring->tid = static_cast<int>(instance.rings.size()) + 1;
+    instance.rings.push_back(std::move(ring));
+    return instance.rings.back().get();
+}
+
+void appendEscaped(QByteArray &out, const QByteArray &text)
+{
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+    }
+}
+
+#ifdef Q_OS_UNIX
+int s_dumpPipe[2] = { -1, -1 };
+
+void handleDumpSignal(int)
+{
+    const char byte = 1;
+    const ssize_t ignored = ::write(s_dumpPipe[1], &byte, 1);
+    Q_UNUSED(ignored)
+}
+#endif
+
+} // namespace
+
+qint64 Tracing::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracing::complete(const char *name, qint64 beginNs, qint64 endNs)
+{
+    ThreadRing *ring = t_ring;
+    if (!ring) {
+        ring = t_ring = registerThread();
+    }
+
+    // Single writer: publish the slot after filling it
+    const quint64 position = ring->written.load(std::memory_order_relaxed);
+    Event &event = ring->events[position & (RingSize - 1)];
+    event.name = name;
+    event.beginNs = beginNs;
+    event.endNs = endNs;
+    ring->written.store(position + 1, std::memory_order_release);
+}
+
+QByteArray Tracing::chromeTrace()
+{
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray out;
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first] {
+        if (!first) {
+            out += ",\n";
+        }
+        first = false;
+    };
+
+    Registry &instance = registry();
+    QMutexLocker locker(&instance.mutex);
+    std::vector<Event> events;
+    events.reserve(RingSize);
+    for (const std::unique_ptr<ThreadRing> &ring : instance.rings) {
+        const QByteArray tid = QByteArray::number(ring->tid);
+        separator();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+                + ",\"args\":{\"name\":\"";
+        appendEscaped(out, ring->threadName);
+        out += "\"}}";
+
+        // Copy while the owner may keep writing, then drop what it overwrote meanwhile
+        const quint64 end = ring->written.load(std::memory_order_acquire);
+        const quint64 begin = end > quint64(RingSize) ? end - RingSize : 0;
+        events.clear();
+        for (quint64 position = begin; position < end; ++position) {
+            events.push_back(ring->events[position & (RingSize - 1)]);
+        }
+        const quint64 after = ring->written.load(std::memory_order_acquire);
+        const quint64 valid = after > quint64(RingSize) ? after - RingSize : 0;
+        const size_t skip = valid > begin ? static_cast<size_t>(qMin(valid - begin, end - begin)) : 0;
+
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event &event = events[i];
+            separator();
+            out += "{\"name\":\"";
+            appendEscaped(out, QByteArray(event.name));
+            out += "\",\"ph\":\"X\",\"pid\":" + pid + ",\"tid\":" + tid
+                    + ",\"ts\":" + QByteArray::number(event.beginNs / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number((event.endNs - event.beginNs) / 1000.0, 'f', 3) + '}';
+        }
+    }
+    out += "]}\n";
+    return out;
+}
+
+bool Tracing::writeChromeTrace(const QString &path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(chromeTrace()) < 0 || !file.commit()) {
+        qWarning() << "Tracing: cannot write" << path << ":" << file.errorString();
+        return false;
+    }
+    qDebug() << "Tracing: wrote" << path;
+    return true;
+}
+
+void Tracing::installDumpTriggers(const QString &path)
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    QObject::connect(app, &QCoreApplication::aboutToQuit, app, [path] { writeChromeTrace(path); });
+
+#ifdef Q_OS_UNIX
+    // The handler only wakes the event loop; the export runs on the GUI thread
+    if (s_dumpPipe[0] >= 0 || ::pipe(s_dumpPipe) != 0) {
+        return;
+    }
+    ::fcntl(s_dumpPipe[1], F_SETFL, O_NONBLOCK);
+    auto *notifier = new QSocketNotifier(s_dumpPipe[0], QSocketNotifier::Read, app);
+    QObject::connect(notifier, &QSocketNotifier::activated, app, [path] {
+        char byte;
+        if (::read(s_dumpPipe[0], &byte, 1) == 1) {
+            writeChromeTrace(path);
+        }
+    });
+    struct sigaction action = {};
+    action.sa_handler = handleDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    ::sigaction(SIGUSR1, &action, nullptr);
+#endif
+}
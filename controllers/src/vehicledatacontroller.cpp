@@ -1,5 +1,14 @@
 #include "vehicledatacontroller.h"
+#include "binarylogger.h"
+#include "dbcdatabase.h"
+#include "tracing.h"
+#include "vehiclesignals_generated.h"
 #include <QDebug>
+#include <QVariantMap>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 VehicleDataController::VehicleDataController(QObject *parent)
     : QObject(parent)
@@ -18,11 +27,41 @@ VehicleDataController::VehicleDataController(QObject *parent)
     , m_engineRunning(false)
     , m_seatbelt(false)
     , m_doorOpen(false)
+    , m_decodeAll(qgetenv("VEHICLESYS_DECODE") == "all")
+    , m_staleTransitions(0)
+    , m_freshTransitions(0)
+    , m_staleMessageCount(0)
+    , m_staleSignalCount(0)
+    , m_staleCycles(qEnvironmentVariableIsSet("VEHICLESYS_STALE_CYCLES")
+                    ? qEnvironmentVariableIntValue("VEHICLESYS_STALE_CYCLES") : 3)
+    , m_stalenessChanged(false)
+    , m_staleTimer(new QTimer(this))
+    , m_statistics(nullptr)
+    , m_signalModel(new VehicleSignalModel(&m_signalRegistry, this))
+    , m_publishMode(ImmediatePublish)
+    , m_pendingChanges(0)
+    , m_publishRequested(false)
     , m_odometerTimer(new QTimer(this))
     , m_previousSpeed(0)
 {
     connect(m_odometerTimer, &QTimer::timeout, this, &VehicleDataController::updateOdometer);
     m_odometerTimer->start(1000); // Update odometer every second
+    connect(m_staleTimer, &QTimer::timeout, this, &VehicleDataController::checkStaleness);
+    if (m_staleCycles > 0) {
+        m_staleTimer->start(100); // Detection delay on a silent bus; frames advance it otherwise
+    }
+
+    std::memset(m_payload, 0, sizeof(m_payload));
+    setupSignalBindings();
+
+    // VEHICLESYS_DBC points at a production database; the bundled one describes the simulator
+    const QString dbcPath = qEnvironmentVariableIsSet("VEHICLESYS_DBC")
+            ? qEnvironmentVariable("VEHICLESYS_DBC")
+            : QStringLiteral(":/dbc/vehicle.dbc");
+    loadDbc(dbcPath);
+
+    // The odometer integrates speed whether or not a gauge shows it
+    subscribe(QStringLiteral("VehicleSpeed"));
 }
 
 // Getters
@@ -41,117 +80,481 @@ bool VehicleDataController::engineRunning() const { return m_engineRunning; }
 bool VehicleDataController::seatbelt() const { return m_seatbelt; }
 bool VehicleDataController::doorOpen() const { return m_doorOpen; }
 
-void VehicleDataController::processCanFrame(quint32 frameId, const QByteArray &data)
+QList<quint32> VehicleDataController::handledFrameIds() const
 {
-    if (data.isEmpty()) {
+    return m_decodeTable.frameIds();
+}
+
+bool VehicleDataController::loadDbc(const QString &path)
+{
+    DbcDatabase database;
+    if (!database.load(path)) {
+        qWarning() << "VehicleDataController: failed to load DBC:" << database.errorString();
+        return false;
+    }
+
+    m_decodeTable.compile(database);
+    m_signalModel->beginRebuild();
+    m_signalRegistry.rebuild(database);
+    m_signalModel->endRebuild();
+    m_dbcPath = path;
+    resolveSignalBindings();
+    m_payloadCache.rebuild(m_decodeTable);
+    resolveSubscriptions();
+    m_decodedNs.fill(0, m_decodeTable.signalCount());
+    resolveTracedSignals();
+    resetStaleness(monotonicMs());
+    m_reportedUnknownIds.clear();
+    m_useGeneratedDecoders = GeneratedCan::decoderCount > 0 && database.checksum() == GeneratedCan::dbcChecksum;
+    qDebug() << "VehicleDataController: loaded" << database.messages().size() << "messages,"
+             << m_decodeTable.signalCount() << "signals from" << path
+             << (m_useGeneratedDecoders ? "(generated decoders)" : "(decode table)");
+
+    emit handledFrameIdsChanged(handledFrameIds());
+    emit dbcLoaded(m_dbcPath);
+    return true;
+}
+
+void VehicleDataController::processCanFrame(const CanFrame &frame)
+{
+    VEHICLESYS_TRACE_ZONE("VehicleDataController::processCanFrame");
+    if (frame.length == 0 || (frame.flags & CanFrame::RemoteRequest)) {
         return;
     }
 
-    switch (frameId) {
-    case 0x100: // Engine_Data (256 decimal) - Engine speed, load, temperature, fuel
-        if (data.size() >= 8) {
-            // Engine Speed (RPM) - bytes 0-1, scale 0.25
-            int rpm = (static_cast<quint8>(data[0]) | (static_cast<quint8>(data[1]) << 8)) * 0.25;
-            setRpm(rpm);
-            
-            // Engine running state based on RPM
-            bool wasRunning = m_engineRunning;
-            bool running = rpm > 500;
-            if (running != wasRunning) {
-                setEngineRunning(running);
-            }
-            
-            // Engine Coolant Temperature - byte 3, scale 1, offset -40
-            if (data.size() >= 4) {
-                int temp = static_cast<quint8>(data[3]) - 40;
-                setEngineTemperature(temp);
-            }
-            
-            // Fuel Level - byte 7, scale 0.392157 (percent)
-            if (data.size() >= 8) {
-                int fuelLevel = static_cast<quint8>(data[7]) * 0.392157;
-                setFuelLevel(fuelLevel);
+    // Classic and FD frames take the same path; only the length differs
+    const int length = frame.length;
+
+    // Standard and extended frames with the same ID are different messages
+    const bool extended = (frame.flags & CanFrame::ExtendedId) != 0;
+    const CanDecodeTable::Message *message = m_decodeTable.find(frame.id, extended);
+    if (!message) {
+        // Normally filtered out in the kernel; report each stray ID only once.
+        // Bit 31 marks extended IDs here, as in a DBC file
+        const quint32 key = extended ? (frame.id | 0x80000000u) : frame.id;
+        if (!m_reportedUnknownIds.contains(key)) {
+            m_reportedUnknownIds.insert(key);
+            VEHICLESYS_LOG_DEBUG(logCan, "Unknown CAN frame ID: %1", BinaryLog::hex(frame.id));
+        }
+        return;
+    }
+
+    const int messageIndex = static_cast<int>(message - m_decodeTable.messages().constData());
+    // The message arrived whether or not anything in it gets decoded. Deadlines
+    // run on the same clock as checkStaleness(), not on frame timestamps, which
+    // are wall-clock time and, for replayed logs, in the past
+    advanceStaleness(monotonicMs(), messageIndex);
+
+    quint64 selected = m_messageEnabled.at(messageIndex);
+    if (!selected) {
+        return; // Nobody is watching this message
+    }
+    selected = m_payloadCache.select(messageIndex, frame.data, length, selected);
+    if (!selected) {
+        return; // Same bytes as last time for everything watched
+    }
+    // Only for LatencyTracer, and only for messages it traces
+    const qint64 decodedNs = m_messageTraced.at(messageIndex) ? CanFrame::currentTimestampNs() : 0;
+
+    if (m_useGeneratedDecoders) {
+        if (const GeneratedCan::DecoderEntry *decoder = GeneratedCan::findDecoder(frame.id, extended)) {
+            // Generated loads stay within the frame, so decode the data in place
+            double values[GeneratedCan::maxSignalsPerMessage];
+            quint64 present = decoder->decode(frame.data, length, values);
+            const SignalBinding *bindings = m_generatedBindings.constData() + decoder->firstSignal;
+            const int *signalIds = m_generatedSignalIds.constData() + decoder->firstSignal;
+            while (present) {
+                const int ordinal = static_cast<int>(qCountTrailingZeroBits(present));
+                present &= present - 1;
+                const int id = signalIds[ordinal];
+                if (id < 0 || !CanDecodeTable::isSelected(selected, id - message->firstSignal)) {
+                    continue;
+                }
+                m_signalRegistry.update(id, values[ordinal], frame.timestampNs);
+                if (decodedNs) {
+                    m_decodedNs[id] = decodedNs;
+                }
+                if (bindings[ordinal]) {
+                    bindings[ordinal](values[ordinal]);
+                }
             }
+            finishFrame();
+            return;
         }
-        break;
-        
-    case 0x200: // Vehicle_Speed (512 decimal) - Vehicle speed
-        if (data.size() >= 2) {
-            // Vehicle Speed - bytes 0-1, scale 0.1 km/h
-            int speed = (static_cast<quint8>(data[0]) | (static_cast<quint8>(data[1]) << 8)) * 0.1;
-            setSpeed(speed);
+    }
+
+    // Table loads read up to PayloadPadding bytes past the frame length (bits
+    // the masks discard); the inline buffer covers that except for long FD frames
+    const quint8 *payload = frame.data;
+    if (length > CanFrame::MaxPayload - CanDecodeTable::PayloadPadding) {
+        std::memcpy(m_payload, frame.data, length);
+        payload = m_payload;
+    }
+
+    const qint64 timestampNs = frame.timestampNs;
+    m_decodeTable.decode(*message, payload, length, [this, timestampNs, decodedNs](int signalIndex, double value) {
+        m_signalRegistry.update(signalIndex, value, timestampNs);
+        if (decodedNs) {
+            m_decodedNs[signalIndex] = decodedNs;
         }
-        break;
-        
-    case 0x400: // Transmission_Data (1024 decimal) - Gear position
-        if (data.size() >= 3) {
-            // Gear Position - lower 4 bits of byte 0
-            int gearValue = static_cast<quint8>(data[0]) & 0x0F;
-            QString gearStr;
-            switch (gearValue) {
-            case 0: gearStr = "P"; break;
-            case 1: gearStr = "R"; break;
-            case 2: gearStr = "N"; break;
-            case 3: gearStr = "D"; break;
-            case 4: gearStr = "S"; break; // Sport mode
-            case 5: gearStr = "M1"; break; // Manual 1st
-            case 6: gearStr = "M2"; break; // Manual 2nd
-            case 7: gearStr = "M3"; break; // Manual 3rd
-            case 8: gearStr = "M4"; break; // Manual 4th
-            case 9: gearStr = "M5"; break; // Manual 5th
-            case 10: gearStr = "M6"; break; // Manual 6th
-            default: gearStr = "?"; break;
+        const SignalBinding &binding = m_boundSignals.at(signalIndex);
+        if (binding) {
+            binding(value);
+        }
+    }, selected);
+    finishFrame();
+}
+
+void VehicleDataController::processCanFrames(const QVector<CanFrame> &frames)
+{
+    VEHICLESYS_TRACE_ZONE("VehicleDataController::processCanFrames");
+    const auto start = std::chrono::steady_clock::now();
+    for (const CanFrame &frame : frames) {
+        processCanFrame(frame);
+    }
+    if (m_statistics) {
+        m_statistics->recordDecode(frames.size(), std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+void VehicleDataController::resetStaleness(qint64 nowMs)
+{
+    const QVector<CanDecodeTable::Message> &messages = m_decodeTable.messages();
+    const bool hadStale = m_staleSignalCount > 0;
+
+    // The registry starts fresh; every message gets a full timeout to show up
+    m_staleWheel.reset(messages.size(), nowMs);
+    m_messageStale.fill(false, messages.size());
+    m_staleTransitionCounts.fill(0, messages.size());
+    m_staleMessageCount = 0;
+    m_staleSignalCount = 0;
+    if (m_staleCycles > 0) {
+        for (int m = 0; m < messages.size(); ++m) {
+            if (messages.at(m).cycleTimeMs > 0) {
+                m_staleWheel.schedule(m, nowMs + qint64(messages.at(m).cycleTimeMs) * m_staleCycles);
             }
-            setGear(gearStr);
-            
-            // Park status from bit 1 of byte 2
-            if (data.size() >= 3) {
-                quint8 status = static_cast<quint8>(data[2]);
-                setParkingBrake((status >> 1) & 0x01);
+        }
+    }
+
+    if (hadStale) {
+        emit stalenessChanged();
+    }
+}
+
+void VehicleDataController::advanceStaleness(qint64 nowMs, int messageIndex)
+{
+    if (m_staleCycles <= 0) {
+        return;
+    }
+
+    m_staleWheel.advance(nowMs, [this](int expired) {
+        setMessageStale(expired, true);
+    });
+
+    if (messageIndex >= 0) {
+        const qint32 cycleTimeMs = m_decodeTable.messages().at(messageIndex).cycleTimeMs;
+        if (cycleTimeMs > 0) {
+            m_staleWheel.schedule(messageIndex, nowMs + qint64(cycleTimeMs) * m_staleCycles);
+        }
+        if (m_messageStale.at(messageIndex)) {
+            setMessageStale(messageIndex, false);
+        }
+    }
+
+    if (m_stalenessChanged) {
+        m_stalenessChanged = false;
+        finishFrame();
+        emit stalenessChanged();
+    }
+}
+
+qint64 VehicleDataController::monotonicMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void VehicleDataController::setMessageStale(int messageIndex, bool stale)
+{
+    const CanDecodeTable::Message &message = m_decodeTable.messages().at(messageIndex);
+    m_messageStale[messageIndex] = stale;
+    for (int id = message.firstSignal; id < message.firstSignal + message.signalCount; ++id) {
+        m_signalRegistry.setStale(id, stale);
+    }
+
+    if (stale) {
+        m_staleMessageCount += 1;
+        m_staleSignalCount += message.signalCount;
+        ++m_staleTransitions;
+        ++m_staleTransitionCounts[messageIndex];
+        VEHICLESYS_LOG_DEBUG(logCan, "VehicleDataController: message %1 is stale", BinaryLog::hex(message.id));
+    } else {
+        m_staleMessageCount -= 1;
+        m_staleSignalCount -= message.signalCount;
+        ++m_freshTransitions;
+    }
+    m_stalenessChanged = true;
+}
+
+void VehicleDataController::checkStaleness()
+{
+    advanceStaleness(monotonicMs(), -1);
+}
+
+bool VehicleDataController::isStale(const QString &signalName) const
+{
+    const int id = m_signalRegistry.indexOf(signalName);
+    return id >= 0 && m_signalRegistry.isStale(id);
+}
+
+QVariantMap VehicleDataController::stalenessStatistics() const
+{
+    QVariantMap result;
+    result.insert(QStringLiteral("staleMessages"), m_staleMessageCount);
+    result.insert(QStringLiteral("staleSignals"), m_staleSignalCount);
+    result.insert(QStringLiteral("staleTransitions"), m_staleTransitions);
+    result.insert(QStringLiteral("freshTransitions"), m_freshTransitions);
+    return result;
+}
+
+void VehicleDataController::finishFrame()
+{
+    if (!m_signalRegistry.hasChanges()) {
+        return;
+    }
+    if (m_publishMode == ImmediatePublish) {
+        m_signalModel->publishChanges();
+    } else {
+        requestPublish();
+    }
+}
+
+void VehicleDataController::setupSignalBindings()
+{
+    // Engine_Data (0x100)
+    m_signalBindings.insert(QStringLiteral("EngineSpeed"), [this](double value) {
+        int rpm = static_cast<int>(value);
+        setRpm(rpm);
+
+        // Engine running state based on RPM
+        bool running = rpm > 500;
+        if (running != m_engineRunning) {
+            setEngineRunning(running);
+        }
+    });
+    m_signalBindings.insert(QStringLiteral("EngineCoolantTemp"), [this](double value) {
+        setEngineTemperature(static_cast<int>(value));
+    });
+    m_signalBindings.insert(QStringLiteral("FuelLevel"), [this](double value) {
+        setFuelLevel(static_cast<int>(value));
+    });
+
+    // Vehicle_Speed (0x200)
+    m_signalBindings.insert(QStringLiteral("VehicleSpeed"), [this](double value) {
+        setSpeed(static_cast<int>(value));
+    });
+
+    // Transmission_Data (0x400)
+    m_signalBindings.insert(QStringLiteral("GearPosition"), [this](double value) {
+        setGear(gearName(static_cast<int>(value)));
+    });
+    m_signalBindings.insert(QStringLiteral("ParkStatus"), [this](double value) {
+        setParkingBrake(value != 0.0);
+    });
+
+    // Battery_Status (0x500)
+    m_signalBindings.insert(QStringLiteral("BatteryVoltage"), [this](double value) {
+        setBatteryVoltage(static_cast<int>(value));
+    });
+
+    // Warning_Lights (0x600)
+    m_signalBindings.insert(QStringLiteral("LeftTurnSignal"), [this](double value) {
+        setLeftTurnSignal(value != 0.0);
+    });
+    m_signalBindings.insert(QStringLiteral("RightTurnSignal"), [this](double value) {
+        setRightTurnSignal(value != 0.0);
+    });
+    m_signalBindings.insert(QStringLiteral("Headlights"), [this](double value) {
+        setHeadlights(value != 0.0);
+    });
+
+    // Door_Status (0x700) - any of the four door bits
+    m_signalBindings.insert(QStringLiteral("DoorOpenMask"), [this](double value) {
+        setDoorOpen(value != 0.0);
+    });
+}
+
+void VehicleDataController::resolveSignalBindings()
+{
+    // Index by decode-table position so the per-frame path never hashes a name
+    m_boundSignals.fill(SignalBinding(), m_decodeTable.signalCount());
+    for (int i = 0; i < m_decodeTable.signalCount(); ++i) {
+        m_boundSignals[i] = m_signalBindings.value(m_decodeTable.signalName(i));
+    }
+
+    m_generatedBindings.fill(SignalBinding(), GeneratedCan::signalCount);
+    for (int i = 0; i < GeneratedCan::signalCount; ++i) {
+        m_generatedBindings[i] = m_signalBindings.value(QLatin1String(GeneratedCan::signalNames[i]));
+    }
+
+    // Generated signals to registry IDs, matched by name within their message
+    m_generatedSignalIds.fill(-1, GeneratedCan::signalCount);
+    for (int d = 0; d < GeneratedCan::decoderCount; ++d) {
+        const GeneratedCan::DecoderEntry &decoder = GeneratedCan::decoderTable[d];
+        const CanDecodeTable::Message *message = m_decodeTable.find(decoder.id, decoder.extended);
+        if (!message) {
+            continue;
+        }
+        for (int ordinal = 0; ordinal < decoder.signalCount; ++ordinal) {
+            const QLatin1String name(GeneratedCan::signalNames[decoder.firstSignal + ordinal]);
+            for (int id = message->firstSignal; id < message->firstSignal + message->signalCount; ++id) {
+                if (m_decodeTable.signalName(id) == name) {
+                    m_generatedSignalIds[decoder.firstSignal + ordinal] = id;
+                    break;
+                }
             }
         }
-        break;
-        
-    case 0x500: // Battery_Status (1280 decimal) - Battery voltage
-        if (data.size() >= 3) {
-            // Battery Voltage - bytes 0-1, scale 0.01 V
-            int voltage = (static_cast<quint8>(data[0]) | (static_cast<quint8>(data[1]) << 8)) * 0.01;
-            setBatteryVoltage(voltage);
+    }
+}
+
+bool VehicleDataController::subscribe(const QString &signalName)
+{
+    if (++m_subscriptions[signalName] == 1) {
+        resolveSubscriptions();
+    }
+
+    if (m_signalRegistry.indexOf(signalName) < 0) {
+        qWarning() << "VehicleDataController: subscribed to" << signalName << "which" << m_dbcPath << "does not define";
+        return false;
+    }
+    return true;
+}
+
+void VehicleDataController::unsubscribe(const QString &signalName)
+{
+    auto it = m_subscriptions.find(signalName);
+    if (it == m_subscriptions.end()) {
+        return;
+    }
+    if (--it.value() == 0) {
+        m_subscriptions.erase(it);
+        resolveSubscriptions();
+    }
+}
+
+int VehicleDataController::subscriberCount(const QString &signalName) const
+{
+    return m_subscriptions.value(signalName);
+}
+
+void VehicleDataController::resolveSubscriptions()
+{
+    const int signalCount = m_decodeTable.signalCount();
+    QVector<bool> subscribed(signalCount, m_decodeAll);
+    for (auto it = m_subscriptions.constBegin(); it != m_subscriptions.constEnd(); ++it) {
+        const int id = m_signalRegistry.indexOf(it.key());
+        if (id >= 0 && id < signalCount) {
+            subscribed[id] = true;
         }
-        break;
-        
-    case 0x600: // Warning_Lights (1536 decimal) - Turn signals and indicators
-        if (data.size() >= 2) {
-            quint8 warnings = static_cast<quint8>(data[0]);
-            quint8 signalBits = static_cast<quint8>(data[1]);
-            
-            // Turn signals from byte 1
-            setLeftTurnSignal(signalBits & 0x01);
-            setRightTurnSignal((signalBits >> 1) & 0x01);
-            setHeadlights((signalBits >> 2) & 0x01);
+    }
+
+    // A message is decoded at all only if one of its signals is wanted
+    const QVector<CanDecodeTable::Message> &messages = m_decodeTable.messages();
+    m_messageEnabled.fill(0, messages.size());
+    for (int m = 0; m < messages.size(); ++m) {
+        const CanDecodeTable::Message &message = messages.at(m);
+        for (int ordinal = 0; ordinal < message.signalCount; ++ordinal) {
+            if (subscribed.at(message.firstSignal + ordinal)) {
+                m_messageEnabled[m] |= ordinal < CanDecodeTable::SelectableSignals
+                        ? quint64(1) << ordinal : CanDecodeTable::AllSignals;
+            }
         }
-        break;
-        
-    case 0x700: // Door_Status (1792 decimal) - Door and closure status
-        if (data.size() >= 1) {
-            quint8 doorStatus = static_cast<quint8>(data[0]);
-            // Set door open if any door is open
-            bool anyDoorOpen = (doorStatus & 0x0F) != 0; // Check first 4 bits (doors)
-            setDoorOpen(anyDoorOpen);
+    }
+
+    // Newly watched signals need a value even if their bytes never change again
+    m_payloadCache.invalidate();
+}
+
+void VehicleDataController::traceLatency(const QString &signalName)
+{
+    if (!m_tracedSignals.contains(signalName)) {
+        m_tracedSignals.insert(signalName);
+        resolveTracedSignals();
+    }
+}
+
+qint64 VehicleDataController::receivedAtNs(const QString &signalName) const
+{
+    const int id = m_signalRegistry.indexOf(signalName);
+    return id >= 0 ? m_signalRegistry.timestampNs(id) : 0;
+}
+
+qint64 VehicleDataController::decodedAtNs(const QString &signalName) const
+{
+    const int id = m_signalRegistry.indexOf(signalName);
+    return id >= 0 ? m_decodedNs.value(id) : 0;
+}
+
+void VehicleDataController::resolveTracedSignals()
+{
+    m_messageTraced.fill(false, m_decodeTable.messages().size());
+    for (const QString &name : qAsConst(m_tracedSignals)) {
+        const int id = m_signalRegistry.indexOf(name);
+        if (id < 0) {
+            continue;
         }
-        break;
-        
-    case 0x300: // HVAC_Status (768 decimal) - HVAC and climate control
-        if (data.size() >= 1) {
-            // AC Status, Heater Status, Fan Speed, Temperature settings
-            // For now, just acknowledge the frame to prevent "unknown" errors
-            // Individual HVAC signals can be added later if needed
+        const SignalRegistry::SignalInfo &info = m_signalRegistry.info(id);
+        if (const CanDecodeTable::Message *message = m_decodeTable.find(info.frameId, info.extendedFrame)) {
+            m_messageTraced[static_cast<int>(message - m_decodeTable.messages().constData())] = true;
         }
-        break;
-        
-    default:
-        qDebug() << "Unknown CAN frame ID:" << Qt::hex << frameId;
-        break;
+    }
+}
+
+QVariantList VehicleDataController::decodeStatistics() const
+{
+    QVariantList result;
+    for (int m = 0; m < m_payloadCache.messageCount(); ++m) {
+        const PayloadChangeCache::Stats &stats = m_payloadCache.stats(m);
+        const quint64 wantedSignals = stats.signalsDecoded + stats.signalsSkipped;
+        QVariantMap entry;
+        entry.insert(QStringLiteral("frameId"), m_payloadCache.frameId(m));
+        entry.insert(QStringLiteral("frames"), stats.frames);
+        entry.insert(QStringLiteral("unchangedFrames"), stats.unchanged);
+        entry.insert(QStringLiteral("signalsDecoded"), stats.signalsDecoded);
+        entry.insert(QStringLiteral("signalsSkipped"), stats.signalsSkipped);
+        entry.insert(QStringLiteral("frameSkipRate"),
+                     stats.frames ? double(stats.unchanged) / double(stats.frames) : 0.0);
+        entry.insert(QStringLiteral("signalSkipRate"),
+                     wantedSignals ? double(stats.signalsSkipped) / double(wantedSignals) : 0.0);
+        entry.insert(QStringLiteral("stale"), m_messageStale.value(m));
+        entry.insert(QStringLiteral("staleTransitions"), m_staleTransitionCounts.value(m));
+        result.append(entry);
+    }
+    return result;
+}
+
+void VehicleDataController::resetDecodeStatistics()
+{
+    m_payloadCache.resetStats();
+    m_staleTransitionCounts.fill(0);
+}
+
+QString VehicleDataController::gearName(int gearValue)
+{
+    switch (gearValue) {
+    case 0: return "P";
+    case 1: return "R";
+    case 2: return "N";
+    case 3: return "D";
+    case 4: return "S"; // Sport mode
+    case 5: return "M1"; // Manual 1st
+    case 6: return "M2"; // Manual 2nd
+    case 7: return "M3"; // Manual 3rd
+    case 8: return "M4"; // Manual 4th
+    case 9: return "M5"; // Manual 5th
+    case 10: return "M6"; // Manual 6th
+    default: return "?";
     }
 }
 
@@ -162,6 +565,9 @@ void VehicleDataController::resetTripOdometer()
 
 void VehicleDataController::toggleEngineState()
 {
+    // Let the next engine frame override this even if its payload repeats
+    m_payloadCache.invalidate();
+
     if (m_engineRunning) {
         setRpm(0);
         setEngineRunning(false);
@@ -178,16 +584,181 @@ void VehicleDataController::updateOdometer()
         double distanceIncrement = (m_speed / 3600.0); // km/h to km/s
         m_odometer += distanceIncrement;
         m_tripOdometer += distanceIncrement;
+        markChanged(OdometerProperty);
+    }
+}
+
+void VehicleDataController::setPublishMode(PublishMode mode)
+{
+    if (m_publishMode != mode) {
+        // Nothing may stay pending once frames no longer flush it
+        publishPendingChanges();
+        m_publishMode = mode;
+        emit publishModeChanged(m_publishMode);
+    }
+}
+
+void VehicleDataController::publishPendingChanges()
+{
+    m_publishRequested = false;
+    if (m_publishMode == SnapshotPublish) {
+        // The proxy compares values itself; NOTIFY is emitted on its thread
+        m_pendingChanges = 0;
+        m_signalRegistry.takeChanges([](int, int) {});
+        writeSnapshot();
+        return;
+    }
+
+    quint32 pending = m_pendingChanges;
+    m_pendingChanges = 0;
+    while (pending) {
+        const int property = static_cast<int>(qCountTrailingZeroBits(pending));
+        pending &= pending - 1;
+        emitChanged(static_cast<Property>(property));
+    }
+    m_signalModel->publishChanges();
+}
+
+void VehicleDataController::writeSnapshot()
+{
+    // The slot holds an older snapshot; every field is overwritten, and the
+    // columns are copied in place so their buffers are reused
+    Snapshot &snapshot = m_snapshots.writeSlot();
+    snapshot.speed = m_speed;
+    snapshot.rpm = m_rpm;
+    snapshot.fuelLevel = m_fuelLevel;
+    snapshot.engineTemperature = m_engineTemperature;
+    snapshot.batteryVoltage = m_batteryVoltage;
+    snapshot.odometer = m_odometer;
+    snapshot.gear = m_gear;
+    snapshot.leftTurnSignal = m_leftTurnSignal;
+    snapshot.rightTurnSignal = m_rightTurnSignal;
+    snapshot.headlights = m_headlights;
+    snapshot.parkingBrake = m_parkingBrake;
+    snapshot.engineRunning = m_engineRunning;
+    snapshot.seatbelt = m_seatbelt;
+    snapshot.doorOpen = m_doorOpen;
+
+    // Same thresholds as emitChanged()
+    snapshot.warnings = 0;
+    if (m_fuelLevel <= 10) {
+        snapshot.warnings |= Snapshot::LowFuel;
+    }
+    if (m_engineTemperature >= 105) {
+        snapshot.warnings |= Snapshot::EngineOverheat;
+    }
+    if (m_batteryVoltage <= 11) {
+        snapshot.warnings |= Snapshot::BatteryLow;
+    }
+
+    const int count = m_signalRegistry.count();
+    snapshot.values.resize(count);
+    snapshot.timestamps.resize(count);
+    snapshot.generations.resize(count);
+    snapshot.stale.resize(count);
+    snapshot.decodedNs.resize(count);
+    std::copy(m_signalRegistry.values().constBegin(), m_signalRegistry.values().constEnd(), snapshot.values.begin());
+    std::copy(m_signalRegistry.timestamps().constBegin(), m_signalRegistry.timestamps().constEnd(), snapshot.timestamps.begin());
+    std::copy(m_signalRegistry.generations().constBegin(), m_signalRegistry.generations().constEnd(), snapshot.generations.begin());
+    std::copy(m_signalRegistry.staleFlags().constBegin(), m_signalRegistry.staleFlags().constEnd(), snapshot.stale.begin());
+    std::copy(m_decodedNs.constBegin(), m_decodedNs.constEnd(), snapshot.decodedNs.begin());
+    snapshot.staleSignalCount = m_staleSignalCount;
+
+    if (m_snapshots.publish()) {
+        emit snapshotPublished();
+    }
+}
+
+void VehicleDataController::requestPublish()
+{
+    if (!m_publishRequested) {
+        m_publishRequested = true;
+        emit publishRequested();
+    }
+}
+
+void VehicleDataController::markChanged(Property property)
+{
+    if (m_publishMode == ImmediatePublish) {
+        emitChanged(property);
+        return;
+    }
+
+    // Later changes within the same frame only overwrite the stored value
+    m_pendingChanges |= 1u << property;
+    requestPublish();
+}
+
+// NOTIFY signals, plus the warnings that depend on the published value
+void VehicleDataController::emitChanged(Property property)
+{
+    switch (property) {
+    case SpeedProperty:
+        emit speedChanged(m_speed);
+        break;
+    case RpmProperty:
+        emit rpmChanged(m_rpm);
+        break;
+    case FuelLevelProperty:
+        emit fuelLevelChanged(m_fuelLevel);
+
+        // Low fuel warning
+        if (m_fuelLevel <= 10) {
+            emit lowFuelWarning();
+        }
+        break;
+    case EngineTemperatureProperty:
+        emit engineTemperatureChanged(m_engineTemperature);
+
+        // Overheat warning
+        if (m_engineTemperature >= 105) {
+            emit engineOverheatWarning();
+        }
+        break;
+    case LeftTurnSignalProperty:
+        emit leftTurnSignalChanged(m_leftTurnSignal);
+        break;
+    case RightTurnSignalProperty:
+        emit rightTurnSignalChanged(m_rightTurnSignal);
+        break;
+    case HeadlightsProperty:
+        emit headlightsChanged(m_headlights);
+        break;
+    case ParkingBrakeProperty:
+        emit parkingBrakeChanged(m_parkingBrake);
+        break;
+    case GearProperty:
+        emit gearChanged(m_gear);
+        break;
+    case OdometerProperty:
         emit odometerChanged(m_odometer);
+        break;
+    case BatteryVoltageProperty:
+        emit batteryVoltageChanged(m_batteryVoltage);
+
+        // Low battery warning
+        if (m_batteryVoltage <= 11) {
+            emit batteryLowWarning();
+        }
+        break;
+    case EngineRunningProperty:
+        emit engineRunningChanged(m_engineRunning);
+        break;
+    case SeatbeltProperty:
+        emit seatbeltChanged(m_seatbelt);
+        break;
+    case DoorOpenProperty:
+        emit doorOpenChanged(m_doorOpen);
+        break;
     }
 }
 
-// Private setters with signal emission and warning checks
+// Private setters; the publish mode decides when the change is announced
 void VehicleDataController::setSpeed(int speed)
 {
     if (m_speed != speed) {
         m_speed = speed;
-        emit speedChanged(m_speed);
+        markChanged(SpeedProperty);
     }
 }
 
@@ -195,7 +766,7 @@ void VehicleDataController::setRpm(int rpm)
 {
     if (m_rpm != rpm) {
         m_rpm = rpm;
-        emit rpmChanged(m_rpm);
+        markChanged(RpmProperty);
     }
 }
 
@@ -203,12 +774,7 @@ void VehicleDataController::setFuelLevel(int fuelLevel)
 {
     if (m_fuelLevel != fuelLevel) {
         m_fuelLevel = fuelLevel;
-        emit fuelLevelChanged(m_fuelLevel);
-        
-        // Low fuel warning
-        if (m_fuelLevel <= 10) {
-            emit lowFuelWarning();
-        }
+        markChanged(FuelLevelProperty);
     }
 }
 
@@ -216,12 +782,7 @@ void VehicleDataController::setEngineTemperature(int engineTemperature)
 {
     if (m_engineTemperature != engineTemperature) {
         m_engineTemperature = engineTemperature;
-        emit engineTemperatureChanged(m_engineTemperature);
-        
-        // Overheat warning
-        if (m_engineTemperature >= 105) {
-            emit engineOverheatWarning();
-        }
+        markChanged(EngineTemperatureProperty);
     }
 }
 
@@ -229,7 +790,7 @@ void VehicleDataController::setLeftTurnSignal(bool leftTurnSignal)
 {
     if (m_leftTurnSignal != leftTurnSignal) {
         m_leftTurnSignal = leftTurnSignal;
-        emit leftTurnSignalChanged(m_leftTurnSignal);
+        markChanged(LeftTurnSignalProperty);
     }
 }
 
@@ -237,7 +798,7 @@ void VehicleDataController::setRightTurnSignal(bool rightTurnSignal)
 {
     if (m_rightTurnSignal != rightTurnSignal) {
         m_rightTurnSignal = rightTurnSignal;
-        emit rightTurnSignalChanged(m_rightTurnSignal);
+        markChanged(RightTurnSignalProperty);
     }
 }
 
@@ -245,7 +806,7 @@ void VehicleDataController::setHeadlights(bool headlights)
 {
     if (m_headlights != headlights) {
         m_headlights = headlights;
-        emit headlightsChanged(m_headlights);
+        markChanged(HeadlightsProperty);
     }
 }
 
@@ -253,7 +814,7 @@ void VehicleDataController::setParkingBrake(bool parkingBrake)
 {
     if (m_parkingBrake != parkingBrake) {
         m_parkingBrake = parkingBrake;
-        emit parkingBrakeChanged(m_parkingBrake);
+        markChanged(ParkingBrakeProperty);
     }
 }
 
@@ -261,7 +822,7 @@ void VehicleDataController::setGear(const QString &gear)
 {
     if (m_gear != gear) {
         m_gear = gear;
-        emit gearChanged(m_gear);
+        markChanged(GearProperty);
     }
 }
 
@@ -269,12 +830,7 @@ void VehicleDataController::setBatteryVoltage(int batteryVoltage)
 {
     if (m_batteryVoltage != batteryVoltage) {
         m_batteryVoltage = batteryVoltage;
-        emit batteryVoltageChanged(m_batteryVoltage);
-        
-        // Low battery warning
-        if (m_batteryVoltage <= 11) {
-            emit batteryLowWarning();
-        }
+        markChanged(BatteryVoltageProperty);
     }
 }
 
@@ -282,7 +838,7 @@ void VehicleDataController::setEngineRunning(bool engineRunning)
 {
     if (m_engineRunning != engineRunning) {
         m_engineRunning = engineRunning;
-        emit engineRunningChanged(m_engineRunning);
+        markChanged(EngineRunningProperty);
     }
 }
 
@@ -290,7 +846,7 @@ void VehicleDataController::setSeatbelt(bool seatbelt)
 {
     if (m_seatbelt != seatbelt) {
         m_seatbelt = seatbelt;
-        emit seatbeltChanged(m_seatbelt);
+        markChanged(SeatbeltProperty);
     }
 }
 
@@ -298,6 +854,6 @@ void VehicleDataController::setDoorOpen(bool doorOpen)
 {
     if (m_doorOpen != doorOpen) {
         m_doorOpen = doorOpen;
-        emit doorOpenChanged(m_doorOpen);
+        markChanged(DoorOpenProperty);
     }
 }
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "vehicledataproxy.h"
+#include "dbcdatabase.h"
+#include <QDebug>
+#include <algorithm>
+
+VehicleDataProxy::VehicleDataProxy(VehicleDataController *controller, QObject *parent)
+    : QObject(parent)
+    , m_controller(controller)
+    , m_snapshots(&controller->snapshots())
+    , m_thread(new QThread(this))
+    , m_signalModel(new VehicleSignalModel(&m_signalRegistry, this))
+    , m_handledFrameIds(controller->handledFrameIds())
+    , m_dbcPath(controller->dbcPath())
+{
+    qRegisterMetaType<QVector<CanFrame>>();
+    qRegisterMetaType<QList<quint32>>();
+
+    // Start from the controller's state while it still belongs to this thread
+    m_state.speed = controller->speed();
+    m_state.rpm = controller->rpm();
+    m_state.fuelLevel = controller->fuelLevel();
+    m_state.engineTemperature = controller->engineTemperature();
+    m_state.batteryVoltage = controller->batteryVoltage();
+    m_state.odometer = controller->odometer();
+    m_state.gear = controller->gear();
+    m_state.leftTurnSignal = controller->leftTurnSignal();
+    m_state.rightTurnSignal = controller->rightTurnSignal();
+    m_state.headlights = controller->headlights();
+    m_state.parkingBrake = controller->parkingBrake();
+    m_state.engineRunning = controller->engineRunning();
+    m_state.seatbelt = controller->seatbelt();
+    m_state.doorOpen = controller->doorOpen();
+    m_state.staleSignalCount = controller->staleSignalCount();
+    rebuildRegistry(m_dbcPath);
+
+    // Changes are collected on the decode thread and published once per
+    // event-loop turn there, i.e. after each drained batch
+    controller->setPublishMode(VehicleDataController::SnapshotPublish);
+    connect(controller, &VehicleDataController::publishRequested,
+            controller, &VehicleDataController::publishPendingChanges, Qt::QueuedConnection);
+    connect(controller, &VehicleDataController::snapshotPublished, this, &VehicleDataProxy::publishRequested);
+    connect(controller, &VehicleDataController::dbcLoaded, this, &VehicleDataProxy::handleDbcLoaded);
+    connect(controller, &VehicleDataController::handledFrameIdsChanged,
+            this, &VehicleDataProxy::handleHandledFrameIdsChanged);
+
+    m_thread->setObjectName(QStringLiteral("VehicleData"));
+    controller->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, controller, &QObject::deleteLater);
+    m_thread->start();
+}
+
+VehicleDataProxy::~VehicleDataProxy()
+{
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void VehicleDataProxy::loadDbc(const QString &path)
+{
+    VehicleDataController *controller = m_controller;
+    QMetaObject::invokeMethod(controller, [controller, path] { controller->loadDbc(path); }, Qt::QueuedConnection);
+}
+
+bool VehicleDataProxy::subscribe(const QString &signalName)
+{
+    VehicleDataController *controller = m_controller;
+    QMetaObject::invokeMethod(controller, [controller, signalName] { controller->subscribe(signalName); },
+                              Qt::QueuedConnection);
+    return m_signalRegistry.indexOf(signalName) >= 0;
+}
+
+void VehicleDataProxy::unsubscribe(const QString &signalName)
+{
+    VehicleDataController *controller = m_controller;
+    QMetaObject::invokeMethod(controller, [controller, signalName] { controller->unsubscribe(signalName); },
+                              Qt::QueuedConnection);
+}
+
+void VehicleDataProxy::traceLatency(const QString &signalName)
+{
+    VehicleDataController *controller = m_controller;
+    QMetaObject::invokeMethod(controller, [controller, signalName] { controller->traceLatency(signalName); },
+                              Qt::QueuedConnection);
+}
+
+qint64 VehicleDataProxy::receivedAtNs(const QString &signalName) const
+{
+    const int id = m_signalRegistry.indexOf(signalName);
+    return id >= 0 ? m_signalRegistry.timestampNs(id) : 0;
+}
+
+qint64 VehicleDataProxy::decodedAtNs(const QString &signalName) const
+{
+    const int id = m_signalRegistry.indexOf(signalName);
+    return id >= 0 ? m_decodedNs.value(id) : 0;
+}
+
+bool VehicleDataProxy::isStale(const QString &signalName) const
+{
+    const int id = m_signalRegistry.indexOf(signalName);
+    return id >= 0 && m_signalRegistry.isStale(id);
+}
+
+void VehicleDataProxy::resetTripOdometer()
+{
+    QMetaObject::invokeMethod(m_controller, &VehicleDataController::resetTripOdometer, Qt::QueuedConnection);
+}
+
+void VehicleDataProxy::toggleEngineState()
+{
+    QMetaObject::invokeMethod(m_controller, &VehicleDataController::toggleEngineState, Qt::QueuedConnection);
+}
+
+template<typename T, typename Notify>
+bool VehicleDataProxy::publish(T &current, const T &next, Notify notify)
+{
+    if (current == next) {
+        return false;
+    }
+    current = next;
+    emit (this->*notify)(current);
+    return true;
+}
+
+void VehicleDataProxy::publishPendingChanges()
+{
+    if (!m_snapshots->consume()) {
+        return;
+    }
+
+    // Owned by this thread until the next consume()
+    const Snapshot &next = m_snapshots->readSlot();
+    // Signals first, so handlers of the NOTIFYs below see the same snapshot
+    m_state.staleSignalCount = next.staleSignalCount;
+    const bool staleChanged = applySignals(next);
+
+    publish(m_state.speed, next.speed, &VehicleDataProxy::speedChanged);
+    publish(m_state.rpm, next.rpm, &VehicleDataProxy::rpmChanged);
+    if (publish(m_state.fuelLevel, next.fuelLevel, &VehicleDataProxy::fuelLevelChanged)
+            && (next.warnings & Snapshot::LowFuel)) {
+        emit lowFuelWarning();
+    }
+    if (publish(m_state.engineTemperature, next.engineTemperature, &VehicleDataProxy::engineTemperatureChanged)
+            && (next.warnings & Snapshot::EngineOverheat)) {
+        emit engineOverheatWarning();
+    }
+    publish(m_state.leftTurnSignal, next.leftTurnSignal, &VehicleDataProxy::leftTurnSignalChanged);
+    publish(m_state.rightTurnSignal, next.rightTurnSignal, &VehicleDataProxy::rightTurnSignalChanged);
+    publish(m_state.headlights, next.headlights, &VehicleDataProxy::headlightsChanged);
+    publish(m_state.parkingBrake, next.parkingBrake, &VehicleDataProxy::parkingBrakeChanged);
+    publish(m_state.gear, next.gear, &VehicleDataProxy::gearChanged);
+    publish(m_state.odometer, next.odometer, &VehicleDataProxy::odometerChanged);
+    if (publish(m_state.batteryVoltage, next.batteryVoltage, &VehicleDataProxy::batteryVoltageChanged)
+            && (next.warnings & Snapshot::BatteryLow)) {
+        emit batteryLowWarning();
+    }
+    publish(m_state.engineRunning, next.engineRunning, &VehicleDataProxy::engineRunningChanged);
+    publish(m_state.seatbelt, next.seatbelt, &VehicleDataProxy::seatbeltChanged);
+    publish(m_state.doorOpen, next.doorOpen, &VehicleDataProxy::doorOpenChanged);
+
+    if (staleChanged) {
+        emit stalenessChanged();
+    }
+}
+
+bool VehicleDataProxy::applySignals(const Snapshot &snapshot)
+{
+    // Columns of another DBC: wait for dbcLoaded() to rebuild the registry
+    const int count = m_signalRegistry.count();
+    if (snapshot.values.size() != count) {
+        return false;
+    }
+    bool stalenessChanged = false;
+    for (int id = 0; id < count; ++id) {
+        m_signalRegistry.assign(id, snapshot.values.at(id), snapshot.timestamps.at(id),
+                                snapshot.generations.at(id));
+        stalenessChanged |= m_signalRegistry.setStale(id, snapshot.stale.at(id));
+    }
+    // Copied, not shared: the writer reuses the snapshot's buffer in place
+    m_decodedNs.resize(count);
+    std::copy(snapshot.decodedNs.constBegin(), snapshot.decodedNs.constEnd(), m_decodedNs.begin());
+    m_signalModel->publishChanges();
+    return stalenessChanged;
+}
+
+void VehicleDataProxy::rebuildRegistry(const QString &path)
+{
+    // Parsed again here for the metadata; values keep coming in snapshots
+    DbcDatabase database;
+    if (!database.load(path)) {
+        qWarning() << "VehicleDataProxy: failed to load DBC:" << database.errorString();
+        return;
+    }
+    m_signalModel->beginRebuild();
+    m_signalRegistry.rebuild(database);
+    m_signalModel->endRebuild();
+}
+
+void VehicleDataProxy::handleDbcLoaded(const QString &path)
+{
+    m_dbcPath = path;
+    rebuildRegistry(m_dbcPath);
+    // The snapshot in hand may already carry the new columns
+    const Snapshot &current = m_snapshots->readSlot();
+    const bool sameDbc = current.values.size() == m_signalRegistry.count();
+    m_state.staleSignalCount = sameDbc ? current.staleSignalCount : 0;
+    applySignals(current);
+    emit stalenessChanged();
+    emit dbcLoaded(m_dbcPath);
+}
+
+void VehicleDataProxy::handleHandledFrameIdsChanged(const QList<quint32> &frameIds)
+{
+    m_handledFrameIds = frameIds;
+    emit handledFrameIdsChanged(m_handledFrameIds);
+}
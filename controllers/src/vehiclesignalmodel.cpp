@@ -0,0 +1,100 @@
+#include "vehiclesignalmodel.h"
+#include "signalregistry.h"
+
+VehicleSignalModel::VehicleSignalModel(SignalRegistry *registry, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_registry(registry)
+    , m_valueRoles{ ValueRole, TimestampRole, GenerationRole, StaleRole }
+{
+}
+
+int VehicleSignalModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_registry->count();
+}
+
+QVariant VehicleSignalModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_registry->count()) {
+        return QVariant();
+    }
+
+    const int id = index.row();
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole: return m_registry->info(id).name;
+    case MessageRole: return m_registry->info(id).message;
+    case FrameIdRole: return m_registry->info(id).frameId;
+    case UnitRole: return m_registry->info(id).unit;
+    case MinimumRole: return m_registry->info(id).minimum;
+    case MaximumRole: return m_registry->info(id).maximum;
+    case FactorRole: return m_registry->info(id).factor;
+    case OffsetRole: return m_registry->info(id).offset;
+    case ValueRole: return m_registry->value(id);
+    case TimestampRole: return m_registry->timestampNs(id);
+    case GenerationRole: return m_registry->generation(id);
+    case StaleRole: return m_registry->isStale(id);
+    default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> VehicleSignalModel::roleNames() const
+{
+    return {
+        { NameRole, "name" },
+        { MessageRole, "message" },
+        { FrameIdRole, "frameId" },
+        { UnitRole, "unit" },
+        { MinimumRole, "minimum" },
+        { MaximumRole, "maximum" },
+        { FactorRole, "factor" },
+        { OffsetRole, "offset" },
+        { ValueRole, "value" },
+        { TimestampRole, "timestamp" },
+        { GenerationRole, "generation" },
+        { StaleRole, "stale" }
+    };
+}
+
+int VehicleSignalModel::indexOf(const QString &name) const
+{
+    return m_registry->indexOf(name);
+}
+
+QVariantMap VehicleSignalModel::get(int row) const
+{
+    QVariantMap result;
+    if (row < 0 || row >= m_registry->count()) {
+        return result;
+    }
+
+    const QModelIndex modelIndex = index(row);
+    const QHash<int, QByteArray> roles = roleNames();
+    for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+        result.insert(QString::fromLatin1(it.value()), data(modelIndex, it.key()));
+    }
+    return result;
+}
+
+double VehicleSignalModel::value(int row) const
+{
+    return (row >= 0 && row < m_registry->count()) ? m_registry->value(row) : 0.0;
+}
+
+void VehicleSignalModel::beginRebuild()
+{
+    beginResetModel();
+}
+
+void VehicleSignalModel::endRebuild()
+{
+    endResetModel();
+    emit countChanged();
+}
+
+void VehicleSignalModel::publishChanges()
+{
+    m_registry->takeChanges([this](int first, int last) {
+        emit dataChanged(index(first), index(last), m_valueRoles);
+    });
+}
@@ -1,13 +1,21 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <memory>
 
 #include "controllers/headers/system.h"
 #include "controllers/headers/hvachandler.h"
 #include "controllers/headers/audiocontroller.h"
 #include "controllers/headers/canbuscontroller.h"
 #include "controllers/headers/vehicledatacontroller.h"
+#include "controllers/headers/vehicledataproxy.h"
+#include "controllers/headers/signalsubscription.h"
 #include "controllers/headers/mediacontroller.h"
+#include "controllers/headers/latencytracer.h"
+#include "controllers/headers/tracing.h"
+#include "controllers/headers/binarylogger.h"
 
 
 int main(int argc, char *argv[])
@@ -17,20 +25,58 @@ int main(int argc, char *argv[])
 #endif
 	
   QGuiApplication app(argc, argv);
+	// Everything logged from here on, qDebug() included, is written by a
+	// background thread; declared first among the objects so it is torn down last
+	BinaryLogger m_logger;
+
+#ifdef VEHICLESYS_TRACING
+	// Timeline of the zones: written at exit, and on demand with kill -USR1
+	const QString tracePath = qEnvironmentVariableIsSet("VEHICLESYS_TRACE_FILE")
+			? qEnvironmentVariable("VEHICLESYS_TRACE_FILE")
+			: QStringLiteral("vehiclesys-trace.json");
+	Tracing::installDumpTriggers(tracePath);
+#endif
 
 	System m_systemHandler;
 	HvacHandler m_driverHvacHandler;
 	HvacHandler m_passengerHvacHandler;
 	AudioController m_audioController;
 	CanBusController m_canBusController;
-	VehicleDataController m_vehicleDataController;
+	auto m_vehicleDataController = std::make_unique<VehicleDataController>();
+	std::unique_ptr<VehicleDataProxy> m_vehicleDataProxy;
 	MediaController m_mediaController;
+	// Declared before the engine: the window's render thread reports to it until the end
+	LatencyTracer m_latencyTracer;
 	
   QQmlApplicationEngine engine;
   
-	// Connect CAN bus to vehicle data controller
-	QObject::connect(&m_canBusController, &CanBusController::frameReceived,
-					 &m_vehicleDataController, &VehicleDataController::processCanFrame);
+	// Let the kernel drop every CAN ID the decoder does not handle
+	m_canBusController.setFrameIdFilter(m_vehicleDataController->handledFrameIds());
+	QObject::connect(m_vehicleDataController.get(), &VehicleDataController::handledFrameIdsChanged,
+					 &m_canBusController, &CanBusController::setFrameIdFilter);
+	
+	// The simulator transmits whatever the decoder's DBC describes
+	m_canBusController.setSimulationDbc(m_vehicleDataController->dbcPath());
+	QObject::connect(m_vehicleDataController.get(), &VehicleDataController::dbcLoaded,
+					 &m_canBusController, &CanBusController::setSimulationDbc);
+	
+	// Connect CAN bus to vehicle data controller. VEHICLESYS_DECODE_THREAD=1
+	// decodes on a worker thread instead; QML then binds to a proxy that
+	// receives snapshots of the controller's state
+	QObject *vehicleData = m_vehicleDataController.get();
+	if (qgetenv("VEHICLESYS_DECODE_THREAD") == "1") {
+		QObject::connect(&m_canBusController, &CanBusController::framesReceived,
+						 m_vehicleDataController.get(), &VehicleDataController::processCanFrames);
+		m_vehicleDataController->setStatistics(m_canBusController.statistics()->createShard(QStringLiteral("VehicleData")));
+		m_vehicleDataProxy = std::make_unique<VehicleDataProxy>(m_vehicleDataController.release());
+		vehicleData = m_vehicleDataProxy.get();
+	} else {
+		QObject::connect(&m_canBusController, &CanBusController::frameReceived,
+						 m_vehicleDataController.get(), &VehicleDataController::processCanFrame);
+	}
+	
+	// Receive and decode times of the values the gauges show
+	m_latencyTracer.setSource(vehicleData);
 	
 	// Connect audio controller to media controller for volume sync
 	QObject::connect(&m_audioController, &AudioController::volumeLevelChanged,
@@ -38,8 +84,11 @@ int main(int argc, char *argv[])
 	QObject::connect(&m_mediaController, &MediaController::volumeChanged,
 					 &m_audioController, &AudioController::setVolumeLevel);
 	
-	// Start CAN bus simulation
-	m_canBusController.connectToSimulator();
+	// Start CAN bus simulation, or replay a recorded log: VEHICLESYS_REPLAY=<file>
+	const QString replayLog = qEnvironmentVariable("VEHICLESYS_REPLAY");
+	if (replayLog.isEmpty() || !m_canBusController.connectToReplay(replayLog)) {
+		m_canBusController.connectToSimulator();
+	}
 	
   // Set context property BEFORE loading QML
 	QQmlContext * context( engine.rootContext() );
@@ -48,12 +97,66 @@ int main(int argc, char *argv[])
 	context->setContextProperty( "passengerHVAC", &m_passengerHvacHandler );
 	context->setContextProperty( "audioController", &m_audioController );
 	context->setContextProperty( "canBusController", &m_canBusController );
-	context->setContextProperty( "vehicleData", &m_vehicleDataController );
+	context->setContextProperty( "vehicleData", vehicleData );
 	context->setContextProperty( "mediaController", &m_mediaController );
+	context->setContextProperty( "latencyTracer", &m_latencyTracer );
+	
+	// Screens declare the signals they show; nothing else is decoded
+	qmlRegisterType<SignalSubscription>("VehicleSys", 1, 0, "SignalSubscription");
 	
-  engine.load(QUrl(QStringLiteral("qrc:/Main.qml")));
+  {
+	VEHICLESYS_TRACE_ZONE("QQmlApplicationEngine::load");
+	engine.load(QUrl(QStringLiteral("qrc:/Main.qml")));
+  }
   if (engine.rootObjects().isEmpty())
     exit(-1);
 	
+	// Publish vehicle data once per rendered frame rather than at bus rate.
+	// afterAnimating runs on the GUI thread just before the scene graph sync
+	// (beforeSynchronizing would fire on the render thread).
+	// VEHICLESYS_PUBLISH=immediate restores one NOTIFY per decoded change
+	auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+	if (window) {
+		m_latencyTracer.attachWindow(window);
+	}
+#ifdef VEHICLESYS_TRACING
+	// Scene graph phases, on the render thread (the GUI thread with the basic loop)
+	if (window) {
+		static qint64 syncBeginNs = 0;
+		static qint64 renderBeginNs = 0;
+		QObject::connect(window, &QQuickWindow::beforeSynchronizing, window, [] {
+			syncBeginNs = Tracing::now();
+		}, Qt::DirectConnection);
+		QObject::connect(window, &QQuickWindow::afterSynchronizing, window, [] {
+			Tracing::complete("QQuickWindow::sync", syncBeginNs, Tracing::now());
+		}, Qt::DirectConnection);
+		QObject::connect(window, &QQuickWindow::beforeRendering, window, [] {
+			renderBeginNs = Tracing::now();
+		}, Qt::DirectConnection);
+		QObject::connect(window, &QQuickWindow::afterRendering, window, [] {
+			Tracing::complete("QQuickWindow::render", renderBeginNs, Tracing::now());
+		}, Qt::DirectConnection);
+	}
+#endif
+	const bool framePublish = window && qgetenv("VEHICLESYS_PUBLISH") != "immediate";
+	if (m_vehicleDataProxy) {
+		// The proxy takes the newest snapshot per frame, or each as it arrives
+		if (framePublish) {
+			QObject::connect(window, &QQuickWindow::afterAnimating,
+							 m_vehicleDataProxy.get(), &VehicleDataProxy::publishPendingChanges);
+			QObject::connect(m_vehicleDataProxy.get(), &VehicleDataProxy::publishRequested,
+							 window, &QQuickWindow::update);
+		} else {
+			QObject::connect(m_vehicleDataProxy.get(), &VehicleDataProxy::publishRequested,
+							 m_vehicleDataProxy.get(), &VehicleDataProxy::publishPendingChanges);
+		}
+	} else if (framePublish) {
+		QObject::connect(window, &QQuickWindow::afterAnimating,
+						 m_vehicleDataController.get(), &VehicleDataController::publishPendingChanges);
+		QObject::connect(m_vehicleDataController.get(), &VehicleDataController::publishRequested,
+						 window, &QQuickWindow::update);
+		m_vehicleDataController->setPublishMode(VehicleDataController::FramePublish);
+	}
+	
   return app.exec();
 }
@@ -0,0 +1,362 @@
+// dbc2cpp - turns a DBC file into a header of constexpr, per-message
+// specialized CAN decoders plus a compile-time ID-to-decoder table.
+//
+//   dbc2cpp <input.dbc> <output.h> [--messages 0x100,0x200,...]
+//
+// --messages takes IDs as in the DBC file: bit 31 marks an extended ID,
+// and a bare ID selects the message of either format.
+//
+// Messages that cannot be expressed as single-window loads (signals
+// spanning more than 64 bits, or more than 64 signals) are skipped; the
+// runtime CanDecodeTable still decodes them.
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "dbcdatabase.h"
+
+namespace {
+
+struct SignalLayout
+{
+    int byteOffset;
+    int byteCount;  // Bytes the signal touches; loads never read past them
+    int shift;
+    int minLength;
+};
+
+bool layoutFor(const DbcSignal &dbcSignal, SignalLayout *layout)
+{
+    const int startByte = dbcSignal.startBit / 8;
+    if (dbcSignal.bigEndian) {
+        const int bitFromTop = 7 - (dbcSignal.startBit % 8);
+        if (bitFromTop + dbcSignal.length > 64) {
+            return false;
+        }
+        layout->byteOffset = startByte;
+        layout->byteCount = (bitFromTop + dbcSignal.length + 7) / 8;
+        layout->shift = layout->byteCount * 8 - bitFromTop - dbcSignal.length;
+        layout->minLength = startByte + layout->byteCount;
+    } else {
+        const int bitInByte = dbcSignal.startBit % 8;
+        if (bitInByte + dbcSignal.length > 64) {
+            return false;
+        }
+        layout->byteOffset = startByte;
+        layout->byteCount = (bitInByte + dbcSignal.length + 7) / 8;
+        layout->shift = bitInByte;
+        layout->minLength = startByte + layout->byteCount;
+    }
+    return true;
+}
+
+QString hex(quint64 value)
+{
+    return QStringLiteral("0x%1").arg(value, 0, 16);
+}
+
+QString number(double value)
+{
+    QString text = QString::number(value, 'g', 17);
+    if (!text.contains(QLatin1Char('.')) && !text.contains(QLatin1Char('e'))) {
+        text += QStringLiteral(".0");
+    }
+    return text;
+}
+
+void writeRawAccessor(QTextStream &out, const DbcSignal &dbcSignal, const SignalLayout &layout)
+{
+    const quint64 mask = dbcSignal.length >= 64 ? ~quint64(0) : ((quint64(1) << dbcSignal.length) - 1);
+    const QString load = dbcSignal.bigEndian ? QStringLiteral("loadBigEndian") : QStringLiteral("loadLittleEndian");
+
+    out << "    static constexpr qint64 raw" << dbcSignal.name << "(const quint8 *data)\n    {\n";
+    out << "        return ";
+    if (dbcSignal.isSigned && dbcSignal.length < 64) {
+        out << "signExtend<" << dbcSignal.length << ">(";
+    } else {
+        out << "static_cast<qint64>(";
+    }
+    out << "(" << load << "<" << layout.byteCount << ">(data + " << layout.byteOffset << ")";
+    if (layout.shift) {
+        out << " >> " << layout.shift;
+    }
+    out << ") & " << hex(mask) << "ull);\n    }\n";
+}
+
+void writePhysicalAccessor(QTextStream &out, const DbcSignal &dbcSignal)
+{
+    // Integer scaling stays in integer arithmetic, like hand-written decoders
+    const bool integral = dbcSignal.length <= 32
+            && dbcSignal.factor == std::trunc(dbcSignal.factor) && std::abs(dbcSignal.factor) < 65536.0
+            && dbcSignal.offset == std::trunc(dbcSignal.offset) && std::abs(dbcSignal.offset) < 2147483648.0;
+
+    if (integral) {
+        out << "    static constexpr qint64 decode" << dbcSignal.name << "(const quint8 *data)\n    {\n";
+        out << "        return raw" << dbcSignal.name << "(data)";
+        if (dbcSignal.factor != 1.0) {
+            out << " * " << static_cast<qint64>(dbcSignal.factor);
+        }
+        if (dbcSignal.offset != 0.0) {
+            out << " + " << static_cast<qint64>(dbcSignal.offset);
+        }
+    } else {
+        out << "    static constexpr double decode" << dbcSignal.name << "(const quint8 *data)\n    {\n";
+        out << "        return static_cast<double>(raw" << dbcSignal.name << "(data))";
+        if (dbcSignal.factor != 1.0) {
+            out << " * " << number(dbcSignal.factor);
+        }
+        if (dbcSignal.offset != 0.0) {
+            out << " + " << number(dbcSignal.offset);
+        }
+    }
+    out << ";\n    }\n";
+}
+
+QString messageType(const DbcMessage &message)
+{
+    return QStringLiteral("Message<%1u, %2>").arg(hex(message.id), QLatin1String(message.extended ? "true" : "false"));
+}
+
+bool writeMessage(QTextStream &out, const DbcMessage &message, int firstSignal)
+{
+    QVector<SignalLayout> layouts;
+    for (const DbcSignal &dbcSignal : message.signalList) {
+        SignalLayout layout;
+        if (!layoutFor(dbcSignal, &layout)) {
+            return false;
+        }
+        layouts.append(layout);
+    }
+
+    const int count = message.signalList.size();
+    out << "// " << message.name << " (" << hex(message.id) << (message.extended ? ", extended" : "") << "), "
+        << message.length << " bytes, " << count << " signals\n";
+    out << "template<>\nstruct " << messageType(message) << "\n{\n";
+    out << "    static constexpr quint32 id = " << hex(message.id) << "u;\n";
+    out << "    static constexpr bool extended = " << (message.extended ? "true" : "false") << ";\n";
+    out << "    static constexpr int length = " << message.length << ";\n";
+    out << "    static constexpr int firstSignal = " << firstSignal << ";\n";
+    out << "    static constexpr int signalCount = " << count << ";\n\n";
+
+    for (int i = 0; i < count; ++i) {
+        writeRawAccessor(out, message.signalList[i], layouts[i]);
+        writePhysicalAccessor(out, message.signalList[i]);
+    }
+
+    // decode(): values[] is indexed by signal ordinal, the return value
+    // has one bit per ordinal that was present in this frame
+    out << "\n    static constexpr quint64 decode(const quint8 *data, int length, double *values)\n    {\n";
+    out << "        quint64 present = 0;\n";
+
+    int multiplexor = -1;
+    for (int i = 0; i < count; ++i) {
+        if (message.signalList[i].multiplexMode == DbcSignal::Multiplexor) {
+            multiplexor = i;
+        }
+    }
+    if (multiplexor >= 0) {
+        out << "        const qint64 mux = length >= " << layouts[multiplexor].minLength << " ? raw"
+            << message.signalList[multiplexor].name << "(data) : -1;\n";
+    }
+
+    // Common case: a full-length frame carries every plain signal, so
+    // skip the per-signal length checks entirely
+    int fullLength = 0;
+    quint64 plainMask = 0;
+    for (int i = 0; i < count; ++i) {
+        if (message.signalList[i].multiplexMode != DbcSignal::Multiplexed) {
+            fullLength = qMax(fullLength, layouts[i].minLength);
+            plainMask |= quint64(1) << i;
+        }
+    }
+
+    if (plainMask) {
+        out << "        if (length >= " << fullLength << ") {\n";
+        for (int i = 0; i < count; ++i) {
+            if (plainMask & (quint64(1) << i)) {
+                out << "            values[" << i << "] = decode" << message.signalList[i].name << "(data);\n";
+            }
+        }
+        out << "            present = " << hex(plainMask) << "ull;\n";
+        out << "        } else {\n";
+        for (int i = 0; i < count; ++i) {
+            if (plainMask & (quint64(1) << i)) {
+                out << "            if (length >= " << layouts[i].minLength << ") { values[" << i << "] = decode"
+                    << message.signalList[i].name << "(data); present |= " << hex(quint64(1) << i) << "ull; }\n";
+            }
+        }
+        out << "        }\n";
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const DbcSignal &dbcSignal = message.signalList[i];
+        if (dbcSignal.multiplexMode == DbcSignal::Multiplexed) {
+            out << "        if (mux == " << dbcSignal.multiplexValue << " && length >= " << layouts[i].minLength
+                << ") { values[" << i << "] = decode" << dbcSignal.name << "(data); present |= "
+                << hex(quint64(1) << i) << "ull; }\n";
+        }
+    }
+
+    out << "        return present;\n    }\n};\n\n";
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = app.arguments();
+    if (arguments.size() < 3) {
+        std::fprintf(stderr, "usage: dbc2cpp <input.dbc> <output.h> [--messages id,id,...]\n");
+        return 2;
+    }
+
+    const QString inputPath = arguments.at(1);
+    const QString outputPath = arguments.at(2);
+
+    QSet<quint32> selected;
+    const int messagesOption = arguments.indexOf(QStringLiteral("--messages"));
+    if (messagesOption > 0 && messagesOption + 1 < arguments.size()) {
+        const QStringList ids = arguments.at(messagesOption + 1).split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (const QString &id : ids) {
+            selected.insert(id.trimmed().toUInt(nullptr, 0));
+        }
+    }
+
+    DbcDatabase database;
+    if (!database.load(inputPath)) {
+        std::fprintf(stderr, "dbc2cpp: %s\n", qPrintable(database.errorString()));
+        return 1;
+    }
+
+    QVector<DbcMessage> messages;
+    for (const DbcMessage &message : database.messages()) {
+        if (selected.isEmpty() || selected.contains(message.id)
+                || (message.extended && selected.contains(message.id | 0x80000000u))) {
+            messages.append(message);
+        }
+    }
+    // Standard before extended for a shared ID; stable, so a duplicate keeps
+    // its place in the file
+    std::stable_sort(messages.begin(), messages.end(), [](const DbcMessage &a, const DbcMessage &b) {
+        return a.id != b.id ? a.id < b.id : a.extended < b.extended;
+    });
+
+    QString text;
+    QTextStream out(&text);
+    out << "// Generated by dbc2cpp from " << QFileInfo(inputPath).fileName() << " - do not edit.\n";
+    out << "#ifndef VEHICLESIGNALS_GENERATED_H\n#define VEHICLESIGNALS_GENERATED_H\n\n";
+    out << "#include <QtGlobal>\n\n";
+    out << "namespace GeneratedCan {\n\n";
+    out << "constexpr quint32 dbcChecksum = " << hex(database.checksum()) << "u;\n\n";
+    out << "// Loads read exactly the bytes a signal occupies, so decoders work on\n";
+    out << "// frame data in place (no padded copy); the byte loops fold into a\n";
+    out << "// single load (plus bswap) at -O2.\n";
+    out << "template<int Bytes>\nconstexpr quint64 loadLittleEndian(const quint8 *p)\n{\n"
+           "    quint64 value = 0;\n"
+           "    for (int i = Bytes - 1; i >= 0; --i) {\n"
+           "        value = value << 8 | p[i];\n"
+           "    }\n"
+           "    return value;\n}\n\n";
+    out << "template<int Bytes>\nconstexpr quint64 loadBigEndian(const quint8 *p)\n{\n"
+           "    quint64 value = 0;\n"
+           "    for (int i = 0; i < Bytes; ++i) {\n"
+           "        value = value << 8 | p[i];\n"
+           "    }\n"
+           "    return value;\n}\n\n";
+    out << "template<int Bits>\nconstexpr qint64 signExtend(quint64 raw)\n{\n"
+           "    return static_cast<qint64>(raw << (64 - Bits)) >> (64 - Bits);\n}\n\n";
+    out << "// A standard and an extended message can share an ID\n";
+    out << "template<quint32 Id, bool Extended = false>\nstruct Message;\n\n";
+
+    QStringList signalNames;
+    QVector<const DbcMessage *> emitted;
+    int maxSignals = 1;
+    for (const DbcMessage &message : qAsConst(messages)) {
+        if (!emitted.isEmpty() && emitted.constLast()->id == message.id
+                && emitted.constLast()->extended == message.extended) {
+            std::fprintf(stderr, "dbc2cpp: skipping %s: ID already used by %s\n", qPrintable(message.name),
+                         qPrintable(emitted.constLast()->name));
+            continue;
+        }
+        if (message.signalList.size() > 64) {
+            std::fprintf(stderr, "dbc2cpp: skipping %s: more than 64 signals\n", qPrintable(message.name));
+            continue;
+        }
+        QString body;
+        QTextStream messageOut(&body);
+        if (!writeMessage(messageOut, message, signalNames.size())) {
+            std::fprintf(stderr, "dbc2cpp: skipping %s: signal spans more than 64 bits\n", qPrintable(message.name));
+            continue;
+        }
+        messageOut.flush();
+        out << body;
+        for (const DbcSignal &dbcSignal : message.signalList) {
+            signalNames.append(dbcSignal.name);
+        }
+        maxSignals = qMax(maxSignals, message.signalList.size());
+        emitted.append(&message);
+    }
+
+    out << "constexpr int signalCount = " << signalNames.size() << ";\n";
+    out << "constexpr int maxSignalsPerMessage = " << maxSignals << ";\n\n";
+    out << "// Global signal index = DecoderEntry::firstSignal + ordinal\n";
+    out << "constexpr const char *signalNames[] = {\n";
+    for (const QString &name : qAsConst(signalNames)) {
+        out << "    \"" << name << "\",\n";
+    }
+    if (signalNames.isEmpty()) {
+        out << "    nullptr\n";
+    }
+    out << "};\n\n";
+
+    out << "using DecodeFunction = quint64 (*)(const quint8 *data, int length, double *values);\n\n";
+    out << "struct DecoderEntry\n{\n    quint32 id;\n    bool extended;\n    int firstSignal;\n    int signalCount;\n"
+           "    DecodeFunction decode;\n};\n\n";
+    out << "// Sorted by ID, standard before extended\n";
+    out << "constexpr DecoderEntry decoderTable[] = {\n";
+    for (const DbcMessage *message : qAsConst(emitted)) {
+        const QString type = messageType(*message);
+        out << "    { " << hex(message->id) << "u, " << (message->extended ? "true" : "false") << ", "
+            << type << "::firstSignal, " << type << "::signalCount, &" << type << "::decode },\n";
+    }
+    if (emitted.isEmpty()) {
+        out << "    { 0xffffffffu, false, 0, 0, nullptr },\n";
+    }
+    out << "};\n";
+    out << "constexpr int decoderCount = " << emitted.size() << ";\n\n";
+
+    out << "constexpr const DecoderEntry *findDecoder(quint32 id, bool extended)\n{\n"
+           "    int low = 0;\n"
+           "    int high = decoderCount;\n"
+           "    while (low < high) {\n"
+           "        const int middle = (low + high) / 2;\n"
+           "        const DecoderEntry &entry = decoderTable[middle];\n"
+           "        if (entry.id < id || (entry.id == id && entry.extended < extended)) {\n"
+           "            low = middle + 1;\n"
+           "        } else {\n"
+           "            high = middle;\n"
+           "        }\n"
+           "    }\n"
+           "    return (low < decoderCount && decoderTable[low].id == id && decoderTable[low].extended == extended)\n"
+           "        ? &decoderTable[low] : nullptr;\n"
+           "}\n\n";
+    out << "} // namespace GeneratedCan\n\n#endif // VEHICLESIGNALS_GENERATED_H\n";
+    out.flush();
+
+    QSaveFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly)) {
+        std::fprintf(stderr, "dbc2cpp: cannot write %s\n", qPrintable(outputPath));
+        return 1;
+    }
+    output.write(text.toUtf8());
+    return output.commit() ? 0 : 1;
+}
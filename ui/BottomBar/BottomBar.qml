@@ -15,6 +15,7 @@ Rectangle {
   signal dashboardClicked()
   signal phoneClicked()
   signal parkAssistClicked()
+  signal settingsClicked()
 
   Image {
   id: carSettingsIcon
@@ -136,8 +137,7 @@ Rectangle {
   MouseArea {
   anchors.fill: parent
   onClicked: {
-	// TODO: Add video functionality
-	console.log("Settings button clicked")
+	bottomBar.settingsClicked()
   }
 }
 }
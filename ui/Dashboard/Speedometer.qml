@@ -1,15 +1,26 @@
 import QtQuick 2.15
+import VehicleSys 1.0
 
 Rectangle {
   id: speedometer
   width: 250
   height: 250
   color: "transparent"
+  // Greyed out while the value is no longer arriving
+  opacity: speedSubscription.stale ? 0.4 : 1.0
 
   property int speed: vehicleData.speed
   property int maxSpeed: 160
   property real needleAngle: (speed / maxSpeed) * 270 - 135 // 270 degree sweep, -135 start (8 o'clock position)
 
+  // Decode vehicle speed only while the gauge is on screen
+  SignalSubscription {
+  id: speedSubscription
+  source: vehicleData
+  signalNames: ["VehicleSpeed"]
+  active: speedometer.visible
+}
+
   Canvas {
   id: speedometerCanvas
   anchors.fill: parent
@@ -71,6 +82,8 @@ Rectangle {
   target: vehicleData
   function onSpeedChanged() {
     speedometerCanvas.requestPaint()
+    // Timed from CAN receive to the first frame that shows the new value
+    latencyTracer.markChanged("VehicleSpeed")
   }
 }
 }
@@ -1,15 +1,26 @@
 import QtQuick 2.15
+import VehicleSys 1.0
 
 Rectangle {
   id: tachometer
   width: 250
   height: 250
   color: "transparent"
+  // Greyed out while the value is no longer arriving
+  opacity: rpmSubscription.stale ? 0.4 : 1.0
 
   property int rpm: vehicleData.rpm
   property int maxRpm: 7000
   property real needleAngle: (rpm / maxRpm) * 240 - 120 // 240 degree sweep, -120 start (7 o'clock position)
 
+  // Decode engine speed only while the gauge is on screen
+  SignalSubscription {
+  id: rpmSubscription
+  source: vehicleData
+  signalNames: ["EngineSpeed"]
+  active: tachometer.visible
+}
+
   Canvas {
   id: tachometerCanvas
   anchors.fill: parent
@@ -82,6 +93,8 @@ Rectangle {
   target: vehicleData
   function onRpmChanged() {
     tachometerCanvas.requestPaint()
+    // Timed from CAN receive to the first frame that shows the new value
+    latencyTracer.markChanged("EngineSpeed")
   }
 }
 }
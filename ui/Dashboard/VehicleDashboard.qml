@@ -1,4 +1,5 @@
 import QtQuick 2.15
+import VehicleSys 1.0
 import "."
 
 Rectangle {
@@ -7,6 +8,24 @@ Rectangle {
   anchors.margins: 5
   color: "#0a0a0a"
   radius: 8
+
+  // Signals shown by the gauges, indicators and info panel below; the
+  // speedometer and tachometer subscribe to their own
+  SignalSubscription {
+  source: vehicleData
+  signalNames: [
+    "EngineSpeed",        // engineRunning
+    "EngineCoolantTemp",
+    "FuelLevel",
+    "GearPosition",
+    "ParkStatus",
+    "BatteryVoltage",
+    "LeftTurnSignal",
+    "RightTurnSignal",
+    "Headlights"
+  ]
+  active: dashboard.visible
+}
     
   // Main dashboard layout - 2 columns
   Row {
@@ -0,0 +1,205 @@
+import QtQuick 2.15
+
+Rectangle {
+    id: busDiagnostics
+    width: 350
+    height: 450
+    color: "#1a1a1a"
+    radius: 8
+    border.color: "#333"
+    border.width: 1
+
+    property var statistics: canBusController.statistics
+
+    function formatCount(value) {
+        if (value >= 1000000)
+            return (value / 1000000).toFixed(1) + "M"
+        if (value >= 1000)
+            return (value / 1000).toFixed(1) + "k"
+        return value.toString()
+    }
+
+    Rectangle {
+        id: header
+        anchors.top: parent.top
+        anchors.left: parent.left
+        anchors.right: parent.right
+        height: 50
+        color: "#2a2a2a"
+        radius: parent.radius
+
+        Text {
+            anchors.centerIn: parent
+            text: "CAN Bus Diagnostics"
+            color: "#ffffff"
+            font.pixelSize: 18
+            font.bold: true
+        }
+
+        Rectangle {
+            anchors.bottom: parent.bottom
+            anchors.left: parent.left
+            anchors.right: parent.right
+            height: 1
+            color: "#444"
+        }
+    }
+
+    // Bus-wide totals
+    Row {
+        id: summary
+        anchors.top: header.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.margins: 15
+        spacing: 25
+
+        Repeater {
+            model: [
+                { label: "Bus load", value: statistics.busLoad.toFixed(1) + " %",
+                  warn: statistics.busLoad > 70 },
+                { label: "Frames/s", value: statistics.frameRate.toFixed(0), warn: false },
+                { label: "Total", value: formatCount(statistics.totalFrames), warn: false },
+                { label: "Errors", value: formatCount(statistics.errorFrames),
+                  warn: statistics.errorFrames > 0 },
+                { label: "Drops", value: formatCount(statistics.droppedFrames),
+                  warn: statistics.droppedFrames > 0 },
+                { label: "Decode", value: statistics.decodeTimeNs.toFixed(0) + " ns", warn: false }
+            ]
+
+            Column {
+                spacing: 2
+
+                Text {
+                    text: modelData.label
+                    color: "#aaa"
+                    font.pixelSize: 12
+                }
+
+                Text {
+                    text: modelData.value
+                    color: modelData.warn ? "#ff5555" : "#ffffff"
+                    font.pixelSize: 18
+                    font.bold: true
+                }
+            }
+        }
+    }
+
+    // Per-ID table header
+    Row {
+        id: columnHeader
+        anchors.top: summary.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.margins: 15
+        anchors.topMargin: 20
+
+        Repeater {
+            model: ["ID", "Frames", "Rate/s", "Load %", "Jitter µs", "p99 µs"]
+
+            Text {
+                width: columnHeader.width / 6
+                text: modelData
+                color: "#aaa"
+                font.pixelSize: 12
+                font.bold: true
+            }
+        }
+    }
+
+    ListView {
+        id: idList
+        anchors.top: columnHeader.bottom
+        anchors.bottom: latency.top
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.margins: 15
+        anchors.topMargin: 5
+        clip: true
+        model: statistics
+
+        delegate: Row {
+            width: idList.width
+            height: 24
+
+            Text {
+                width: idList.width / 6
+                // Extended IDs as eight digits, the way candump prints them
+                text: "0x" + (extended ? ("0000000" + frameId.toString(16)).slice(-8)
+                                       : frameId.toString(16)).toUpperCase()
+                color: "#ffffff"
+                font.pixelSize: 14
+                font.family: "monospace"
+            }
+
+            Text {
+                width: idList.width / 6
+                text: busDiagnostics.formatCount(frames)
+                color: "#ffffff"
+                font.pixelSize: 14
+            }
+
+            Text {
+                width: idList.width / 6
+                text: frameRate.toFixed(1)
+                color: "#ffffff"
+                font.pixelSize: 14
+            }
+
+            Text {
+                width: idList.width / 6
+                text: busLoad.toFixed(2)
+                color: "#ffffff"
+                font.pixelSize: 14
+            }
+
+            Text {
+                width: idList.width / 6
+                text: jitterMean.toFixed(0)
+                color: "#ffffff"
+                font.pixelSize: 14
+            }
+
+            Text {
+                width: idList.width / 6
+                text: jitter99 < 0 ? ">" + statistics.jitterBounds().slice(-1)[0] : jitter99
+                color: jitter99 < 0 || jitter99 > 1000 ? "#ffaa00" : "#ffffff"
+                font.pixelSize: 14
+            }
+        }
+    }
+
+    // Receive to first rendered frame, per gauge signal
+    Column {
+        id: latency
+        anchors.bottom: parent.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.margins: 15
+        spacing: 4
+
+        Text {
+            text: "Display latency (receive → swap, ms)"
+            color: "#aaa"
+            font.pixelSize: 12
+            font.bold: true
+        }
+
+        Repeater {
+            model: latencyTracer.statistics
+
+            Text {
+                // Last stage is end to end
+                property var total: modelData.stages[modelData.stages.length - 1]
+                text: modelData.name + "   p50 " + (total.p50 / 1000).toFixed(1)
+                      + "   p99 " + (total.p99 / 1000).toFixed(1)
+                      + "   max " + (total.max / 1000).toFixed(1)
+                      + "   (" + modelData.samples + " frames, "
+                      + modelData.superseded + " superseded)"
+                color: total.p99 > 50000 ? "#ffaa00" : "#ffffff"
+                font.pixelSize: 14
+            }
+        }
+    }
+}
@@ -139,10 +139,124 @@ Rectangle {
   font.pixelSize: 12
 }
 }
+}
+
+  // Library search; results replace the playlist while there is a query
+  Rectangle {
+  id: searchBox
+  anchors.top: albumArt.bottom
+  anchors.topMargin: 20
+  anchors.left: parent.left
+  anchors.leftMargin: 20
+  anchors.right: parent.right
+  anchors.rightMargin: 20
+  height: 32
+  color: "#2a2a2a"
+  radius: 4
+
+  Image {
+  id: searchIcon
+  anchors.left: parent.left
+  anchors.leftMargin: 8
+  anchors.verticalCenter: parent.verticalCenter
+  height: parent.height * 0.5
+  source: "qrc:/images/search.png"
+  fillMode: Image.PreserveAspectFit
+}
+
+  Text {
+  anchors.left: searchIcon.right
+  anchors.leftMargin: 8
+  anchors.verticalCenter: parent.verticalCenter
+  text: "Search title, artist or album"
+  color: "#666"
+  font.pixelSize: 14
+  visible: searchInput.text === ""
+}
+
+  TextInput {
+  id: searchInput
+  anchors.top: parent.top
+  anchors.bottom: parent.bottom
+  anchors.left: searchIcon.right
+  anchors.leftMargin: 8
+  anchors.right: parent.right
+  anchors.rightMargin: 8
+  verticalAlignment: Text.AlignVCenter
+  color: "#ffffff"
+  font.pixelSize: 14
+  clip: true
+  // Queries run on a worker thread; typing never waits for results
+  onTextChanged: if (mediaController) mediaController.search.query = text
+}
+}
+
+  // Playlist; delegates are only created for the visible rows
+  ListView {
+  id: playlistView
+  property bool searching: searchInput.text !== ""
+  anchors.top: searchBox.bottom
+  anchors.topMargin: 10
+  anchors.bottom: controls.top
+  anchors.bottomMargin: 20
+  anchors.left: parent.left
+  anchors.leftMargin: 20
+  anchors.right: parent.right
+  anchors.rightMargin: 20
+  clip: true
+  model: mediaController ? (searching ? mediaController.search : mediaController.playlist) : null
+  currentIndex: mediaController && !searching ? mediaController.currentIndex : -1
+
+  delegate: Rectangle {
+  width: playlistView.width
+  height: 36
+  color: index === playlistView.currentIndex ? "#2a2a2a" : "transparent"
+  radius: 4
+
+  Column {
+  anchors.left: parent.left
+  anchors.leftMargin: 8
+  anchors.right: durationText.left
+  anchors.rightMargin: 8
+  anchors.verticalCenter: parent.verticalCenter
+
+  Text {
+  width: parent.width
+  text: title
+  color: index === playlistView.currentIndex ? "#00aaff" : "#ffffff"
+  font.pixelSize: 14
+  elide: Text.ElideRight
+}
+
+  Text {
+  width: parent.width
+  text: album ? artist + " · " + album : artist
+  color: "#aaa"
+  font.pixelSize: 11
+  elide: Text.ElideRight
+}
+}
+
+  Text {
+  id: durationText
+  anchors.right: parent.right
+  anchors.rightMargin: 8
+  anchors.verticalCenter: parent.verticalCenter
+  text: duration > 0 ? formatTime(duration / 1000) : ""
+  color: "#aaa"
+  font.pixelSize: 12
+}
+
+  MouseArea {
+  anchors.fill: parent
+  onClicked: playlistView.searching ? mediaController.playFile(path) : mediaController.playTrack(index)
+}
+}
 }
 
   // Control buttons
   Row {
+  id: controls
   anchors.bottom: parent.bottom
   anchors.bottomMargin: 40
   anchors.horizontalCenter: parent.horizontalCenter
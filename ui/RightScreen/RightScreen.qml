@@ -3,6 +3,7 @@ import QtLocation 5.15
 import QtPositioning 5.15
 import "../MusicPlayer"
 import "../Phone"
+import "../Diagnostics"
 import "."
 
 Rectangle {
@@ -14,7 +15,7 @@ Rectangle {
 	right: parent.right
     }
     
-    property string currentContent: "map" // "map", "music", "phone"
+    property string currentContent: "map" // "map", "music", "phone", "diagnostics"
 
     Plugin {
 	id: mapPlugin
@@ -141,6 +142,46 @@ Rectangle {
         }
     }
     
+    // CAN bus diagnostics view
+    Rectangle {
+        id: diagnosticsContainer
+        anchors.fill: parent
+        visible: currentContent === "diagnostics"
+        color: "black"
+        
+        BusDiagnostics {
+            anchors.fill: parent
+            anchors.margins: 20
+        }
+        
+        // Minimize button
+        Rectangle {
+            anchors.top: parent.top
+            anchors.right: parent.right
+            anchors.topMargin: 15
+            anchors.rightMargin: 15
+            width: 30
+            height: 30
+            radius: 15
+            color: "#444444"
+            
+            Text {
+                anchors.centerIn: parent
+                text: "−"
+                color: "white"
+                font.pixelSize: 18
+                font.bold: true
+            }
+            
+            MouseArea {
+                anchors.fill: parent
+                onClicked: {
+                    currentContent = "map"
+                }
+            }
+        }
+    }
+    
     width: parent.width * 1.68/3    // this sets width ratio for right/left screen
     
     function showMap() {
@@ -154,4 +195,8 @@ Rectangle {
     function showPhone() {
         currentContent = "phone"
     }
+    
+    function showDiagnostics() {
+        currentContent = "diagnostics"
+    }
 }